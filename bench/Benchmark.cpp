@@ -0,0 +1,293 @@
+#include "Benchmark.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+static double wallSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double cpuSecondsNow()
+{
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+//////////////////////////////////////////////////////////////////////
+// BenchmarkState
+//////////////////////////////////////////////////////////////////////
+
+BenchmarkState::BenchmarkState(int64_t iterations, int64_t argValue)
+{
+    maxIterations = iterations;
+    remaining = iterations;
+    arg = argValue;
+    started = false;
+    running = false;
+    itemsProcessed = 0;
+    bytesProcessed = 0;
+    realStart = 0.0;
+    cpuStart = 0.0;
+    realSeconds = 0.0;
+    cpuSeconds = 0.0;
+}
+
+bool BenchmarkState::keepRunning()
+{
+    if (!started)
+    {
+        started = true;
+        startTimer();
+    }
+
+    if (remaining-- > 0)
+        return true;
+
+    stopTimer();
+    return false;
+}
+
+void BenchmarkState::startTimer()
+{
+    running = true;
+    realStart = wallSeconds();
+    cpuStart = cpuSecondsNow();
+}
+
+void BenchmarkState::stopTimer()
+{
+    if (!running)
+        return;
+    running = false;
+    realSeconds += wallSeconds() - realStart;
+    cpuSeconds += cpuSecondsNow() - cpuStart;
+}
+
+void BenchmarkState::pauseTiming()
+{
+    stopTimer();
+}
+
+void BenchmarkState::resumeTiming()
+{
+    startTimer();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Registry
+//////////////////////////////////////////////////////////////////////
+
+Benchmark::Benchmark(const char *benchName, BenchmarkFunction benchFunction)
+{
+    name = benchName;
+    function = benchFunction;
+    registry().push_back(this);
+}
+
+Benchmark *Benchmark::Arg(int64_t arg)
+{
+    args.push_back(arg);
+    return this;
+}
+
+std::vector<Benchmark *> &Benchmark::registry()
+{
+    static std::vector<Benchmark *> benchmarks;
+    return benchmarks;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Runner
+//////////////////////////////////////////////////////////////////////
+
+struct BenchmarkResult
+{
+    std::string name;
+    int64_t iterations;
+    double realNs;       // Mean over repetitions, per iteration
+    double realNsMedian; // Median over repetitions, per iteration
+    double realNsStddev;
+    double cpuNs;
+    double itemsPerSecond;
+    double bytesPerSecond;
+};
+
+static BenchmarkResult runOne(Benchmark *bench, const std::string &name, int64_t arg,
+                              double minTime, int repetitions)
+{
+    // Grow the iteration count until one run takes at least minTime
+    int64_t iterations = 1;
+    for (;;)
+    {
+        BenchmarkState state(iterations, arg);
+        bench->function(state);
+
+        double t = state.getRealSeconds();
+        if (t >= minTime || iterations >= 1000000000)
+            break;
+
+        double multiplier = t > 0.0 ? minTime * 1.4 / t : 10.0;
+        if (multiplier > 10.0)
+            multiplier = 10.0;
+        if (multiplier < 2.0)
+            multiplier = 2.0;
+        iterations = (int64_t)(iterations * multiplier);
+    }
+
+    std::vector<double> perIteration;
+    double cpuTotal = 0.0;
+    double realTotal = 0.0;
+    int64_t items = 0;
+    int64_t bytes = 0;
+
+    for (int r = 0; r < repetitions; r++)
+    {
+        BenchmarkState state(iterations, arg);
+        bench->function(state);
+        perIteration.push_back(state.getRealSeconds() * 1e9 / iterations);
+        realTotal += state.getRealSeconds();
+        cpuTotal += state.getCpuSeconds();
+        items += state.getItemsProcessed();
+        bytes += state.getBytesProcessed();
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+
+    double mean = 0.0;
+    for (size_t i = 0; i < perIteration.size(); i++)
+        mean += perIteration[i];
+    mean /= perIteration.size();
+
+    double variance = 0.0;
+    for (size_t i = 0; i < perIteration.size(); i++)
+        variance += (perIteration[i] - mean) * (perIteration[i] - mean);
+    variance /= perIteration.size();
+
+    std::sort(perIteration.begin(), perIteration.end());
+
+    result.realNs = mean;
+    result.realNsMedian = perIteration[perIteration.size() / 2];
+    result.realNsStddev = sqrt(variance);
+    result.cpuNs = cpuTotal * 1e9 / ((double)iterations * repetitions);
+    result.itemsPerSecond = realTotal > 0.0 ? items / realTotal : 0.0;
+    result.bytesPerSecond = realTotal > 0.0 ? bytes / realTotal : 0.0;
+    return result;
+}
+
+static void writeJson(const char *path, const std::vector<BenchmarkResult> &results)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "Error: could not write %s\n", path);
+        return;
+    }
+
+    char date[64];
+    time_t now = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    fprintf(file, "{\n  \"context\": {\n");
+    fprintf(file, "    \"date\": \"%s\",\n", date);
+    fprintf(file, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(file, "    \"profiler\": %d\n", EGYPT_PROFILE);
+    fprintf(file, "  },\n  \"benchmarks\": [\n");
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult &r = results[i];
+        fprintf(file, "    {\n");
+        fprintf(file, "      \"name\": \"%s\",\n", r.name.c_str());
+        fprintf(file, "      \"iterations\": %lld,\n", (long long)r.iterations);
+        fprintf(file, "      \"real_time\": %.3f,\n", r.realNs);
+        fprintf(file, "      \"real_time_median\": %.3f,\n", r.realNsMedian);
+        fprintf(file, "      \"real_time_stddev\": %.3f,\n", r.realNsStddev);
+        fprintf(file, "      \"cpu_time\": %.3f,\n", r.cpuNs);
+        fprintf(file, "      \"time_unit\": \"ns\"");
+        if (r.itemsPerSecond > 0.0)
+            fprintf(file, ",\n      \"items_per_second\": %.3f", r.itemsPerSecond);
+        if (r.bytesPerSecond > 0.0)
+            fprintf(file, ",\n      \"bytes_per_second\": %.3f", r.bytesPerSecond);
+        fprintf(file, "\n    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+}
+
+int main(int argc, char **argv)
+{
+    const char *jsonPath = NULL;
+    const char *filter = NULL;
+    double minTime = 0.5;
+    int repetitions = 3;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+            minTime = atof(argv[++i]);
+        else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+            repetitions = atoi(argv[++i]);
+        else
+        {
+            printf("Usage: %s [--json FILE] [--filter TEXT] [--min-time SECONDS] [--repetitions N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (repetitions < 1)
+        repetitions = 1;
+
+    std::vector<BenchmarkResult> results;
+
+    printf("%-40s %14s %14s %12s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations");
+    printf("------------------------------------------------------------------------------------\n");
+
+    std::vector<Benchmark *> &benchmarks = Benchmark::registry();
+    for (size_t b = 0; b < benchmarks.size(); b++)
+    {
+        Benchmark *bench = benchmarks[b];
+
+        std::vector<int64_t> args = bench->args;
+        bool hasArgs = !args.empty();
+        if (!hasArgs)
+            args.push_back(0);
+
+        for (size_t a = 0; a < args.size(); a++)
+        {
+            char name[128];
+            if (hasArgs)
+                snprintf(name, sizeof(name), "%s/%lld", bench->name, (long long)args[a]);
+            else
+                snprintf(name, sizeof(name), "%s", bench->name);
+
+            if (filter && !strstr(name, filter))
+                continue;
+
+            BenchmarkResult r = runOne(bench, name, args[a], minTime, repetitions);
+            results.push_back(r);
+
+            printf("%-40s %14.1f %14.1f %12lld\n", name, r.realNs, r.cpuNs, (long long)r.iterations);
+            fflush(stdout);
+        }
+    }
+
+    if (jsonPath)
+    {
+        writeJson(jsonPath, results);
+        printf("Results written to %s\n", jsonPath);
+    }
+    return 0;
+}
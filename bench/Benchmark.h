@@ -0,0 +1,96 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// Minimal Google-Benchmark-style harness, no external dependency.
+//
+// Usage:
+// static void BM_CarUpdate(BenchmarkState &state)
+// {
+//     Car car;
+//     while (state.keepRunning())
+//         car.update();
+// }
+// BENCHMARK(BM_CarUpdate);
+// BENCHMARK(BM_Traffic)->Arg(10)->Arg(100); // state.range() is the argument
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class BenchmarkState
+{
+public:
+    BenchmarkState(int64_t iterations, int64_t arg);
+
+    // Returns true while iterations remain; the first call starts the clock
+    bool keepRunning();
+
+    int64_t range() const { return arg; }
+    int64_t iterations() const { return maxIterations; }
+
+    // Exclude setup inside the loop from the measurement
+    void pauseTiming();
+    void resumeTiming();
+
+    // Work per iteration, reported as items_per_second / bytes_per_second
+    void setItemsProcessed(int64_t items) { itemsProcessed = items; }
+    void setBytesProcessed(int64_t bytes) { bytesProcessed = bytes; }
+
+    double getRealSeconds() const { return realSeconds; }
+    double getCpuSeconds() const { return cpuSeconds; }
+    int64_t getItemsProcessed() const { return itemsProcessed; }
+    int64_t getBytesProcessed() const { return bytesProcessed; }
+
+private:
+    int64_t maxIterations;
+    int64_t remaining;
+    int64_t arg;
+    bool started;
+    bool running;
+
+    int64_t itemsProcessed;
+    int64_t bytesProcessed;
+
+    double realStart;
+    double cpuStart;
+    double realSeconds;
+    double cpuSeconds;
+
+    void startTimer();
+    void stopTimer();
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkState &state);
+
+class Benchmark
+{
+public:
+    Benchmark(const char *name, BenchmarkFunction function);
+
+    Benchmark *Arg(int64_t arg);
+
+    const char *name;
+    BenchmarkFunction function;
+    std::vector<int64_t> args;
+
+    static std::vector<Benchmark *> &registry();
+};
+
+#define BENCHMARK_CONCAT_INNER(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_INNER(a, b)
+#define BENCHMARK(fn) \
+    static Benchmark *BENCHMARK_CONCAT(benchmark_, __LINE__) = (new Benchmark(#fn, fn))
+
+// Keeps the optimizer from deleting a computation whose result is unused
+template <typename T>
+inline void doNotOptimize(const T &value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    volatile const T *sink = &value;
+    (void)sink;
+#endif
+}
+
+#endif
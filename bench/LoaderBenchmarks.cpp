@@ -0,0 +1,378 @@
+// Asset loading hot paths on synthetic files, so no assets need to be present
+#include "Benchmark.h"
+#include "BlockCompression.h"
+#include "ImageDecoder.h"
+#include "Model_3DS.h"
+#include "PixelConvert.h"
+#include "TextureBuilder.h"
+#include "TextureFile.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+// Synthetic file writers
+//////////////////////////////////////////////////////////////////////
+
+static void putU16(std::vector<unsigned char> &out, unsigned int v)
+{
+    out.push_back((unsigned char)(v & 0xFF));
+    out.push_back((unsigned char)((v >> 8) & 0xFF));
+}
+
+static void putU32(std::vector<unsigned char> &out, unsigned int v)
+{
+    putU16(out, v & 0xFFFF);
+    putU16(out, v >> 16);
+}
+
+static void putFloat(std::vector<unsigned char> &out, float f)
+{
+    unsigned int v;
+    memcpy(&v, &f, sizeof(v));
+    putU32(out, v);
+}
+
+// Starts a 3DS chunk and returns its offset so endChunk() can patch the length
+static size_t beginChunk(std::vector<unsigned char> &out, unsigned int id)
+{
+    size_t start = out.size();
+    putU16(out, id);
+    putU32(out, 0);
+    return start;
+}
+
+static void endChunk(std::vector<unsigned char> &out, size_t start)
+{
+    unsigned int len = (unsigned int)(out.size() - start);
+    for (int i = 0; i < 4; i++)
+        out[start + 2 + i] = (unsigned char)((len >> (i * 8)) & 0xFF);
+}
+
+// One object with a side x side vertex grid, texcoords and two triangles per cell
+static void writeSynthetic3DS(const char *path, int side)
+{
+    std::vector<unsigned char> out;
+
+    size_t main = beginChunk(out, 0x4D4D);
+    size_t edit = beginChunk(out, 0x3D3D);
+    size_t object = beginChunk(out, 0x4000);
+    const char name[] = "grid";
+    out.insert(out.end(), name, name + sizeof(name));
+
+    size_t mesh = beginChunk(out, 0x4100);
+    int numVerts = side * side;
+
+    size_t verts = beginChunk(out, 0x4110);
+    putU16(out, numVerts);
+    for (int z = 0; z < side; z++)
+    {
+        for (int x = 0; x < side; x++)
+        {
+            putFloat(out, (float)x);
+            putFloat(out, (float)z);
+            putFloat(out, (float)((x * 7 + z * 3) % 5)); // Some height so normals vary
+        }
+    }
+    endChunk(out, verts);
+
+    size_t uvs = beginChunk(out, 0x4140);
+    putU16(out, numVerts);
+    for (int z = 0; z < side; z++)
+    {
+        for (int x = 0; x < side; x++)
+        {
+            putFloat(out, x / (float)side);
+            putFloat(out, z / (float)side);
+        }
+    }
+    endChunk(out, uvs);
+
+    size_t faces = beginChunk(out, 0x4120);
+    putU16(out, 2 * (side - 1) * (side - 1));
+    for (int z = 0; z < side - 1; z++)
+    {
+        for (int x = 0; x < side - 1; x++)
+        {
+            int i = z * side + x;
+            putU16(out, i);
+            putU16(out, i + 1);
+            putU16(out, i + side);
+            putU16(out, 0);
+            putU16(out, i + 1);
+            putU16(out, i + side + 1);
+            putU16(out, i + side);
+            putU16(out, 0);
+        }
+    }
+    endChunk(out, faces);
+
+    endChunk(out, mesh);
+    endChunk(out, object);
+    endChunk(out, edit);
+    endChunk(out, main);
+
+    FILE *file = fopen(path, "wb");
+    if (file)
+    {
+        fwrite(&out[0], 1, out.size(), file);
+        fclose(file);
+    }
+}
+
+static void writeSyntheticBMP(const char *path, int width, int height)
+{
+    int rowSize = ((width * 3 + 3) / 4) * 4;
+    std::vector<unsigned char> out;
+
+    out.push_back('B');
+    out.push_back('M');
+    putU32(out, 54 + rowSize * height);
+    putU32(out, 0);
+    putU32(out, 54); // Pixel data offset
+    putU32(out, 40); // BITMAPINFOHEADER size
+    putU32(out, width);
+    putU32(out, height);
+    putU16(out, 1);  // Planes
+    putU16(out, 24); // Bits per pixel
+    putU32(out, 0);  // No compression
+    putU32(out, rowSize * height);
+    putU32(out, 2835);
+    putU32(out, 2835);
+    putU32(out, 0);
+    putU32(out, 0);
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < rowSize; x++)
+            out.push_back((unsigned char)(x * 31 + y * 17));
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (file)
+    {
+        fwrite(&out[0], 1, out.size(), file);
+        fclose(file);
+    }
+}
+
+static void putBE32(std::vector<unsigned char> &out, unsigned int v)
+{
+    for (int i = 3; i >= 0; i--)
+        out.push_back((unsigned char)((v >> (i * 8)) & 0xFF));
+}
+
+// Deflate bit stream, least significant bit first
+static void putBits(std::vector<unsigned char> &out, uint32_t &buffer, int &count, uint32_t value, int bits)
+{
+    buffer |= value << count;
+    count += bits;
+    while (count >= 8)
+    {
+        out.push_back((unsigned char)(buffer & 0xFF));
+        buffer >>= 8;
+        count -= 8;
+    }
+}
+
+// A fixed Huffman code, written most significant bit first
+static void putCode(std::vector<unsigned char> &out, uint32_t &buffer, int &count, uint32_t code, int bits)
+{
+    uint32_t reversed = 0;
+    for (int i = 0; i < bits; i++)
+        reversed |= ((code >> i) & 1) << (bits - 1 - i);
+    putBits(out, buffer, count, reversed, bits);
+}
+
+// RGBA rows cycling through the five filter types, deflated as one fixed
+// Huffman block of literals. CRCs and the Adler checksum are left zero,
+// the decoder does not check them.
+static std::vector<unsigned char> writeSyntheticPNG(int width, int height)
+{
+    std::vector<unsigned char> out;
+    static const unsigned char SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    out.insert(out.end(), SIGNATURE, SIGNATURE + 8);
+
+    putBE32(out, 13);
+    out.insert(out.end(), "IHDR", "IHDR" + 4);
+    putBE32(out, width);
+    putBE32(out, height);
+    out.push_back(8); // Bits per sample
+    out.push_back(6); // RGBA
+    out.push_back(0);
+    out.push_back(0);
+    out.push_back(0); // Not interlaced
+    putBE32(out, 0);
+
+    std::vector<unsigned char> data;
+    data.push_back(0x78);
+    data.push_back(0x01);
+    uint32_t buffer = 0;
+    int count = 0;
+    putBits(data, buffer, count, 1, 1); // Last block
+    putBits(data, buffer, count, 1, 2); // Fixed codes
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = -1; x < width * 4; x++)
+        {
+            int byte = x < 0 ? y % 5 : (x * 7 + y * 3 + (x >> 4) * (y >> 3)) & 0xFF;
+            if (byte < 144)
+                putCode(data, buffer, count, 0x30 + byte, 8);
+            else
+                putCode(data, buffer, count, 0x190 + byte - 144, 9);
+        }
+    }
+    putCode(data, buffer, count, 0, 7); // End of block
+    putBits(data, buffer, count, 0, 7); // Flush to a byte
+    putBE32(data, 0);
+
+    putBE32(out, (unsigned int)data.size());
+    out.insert(out.end(), "IDAT", "IDAT" + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    putBE32(out, 0);
+
+    putBE32(out, 0);
+    out.insert(out.end(), "IEND", "IEND" + 4);
+    putBE32(out, 0);
+    return out;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Benchmarks
+//////////////////////////////////////////////////////////////////////
+
+// range() is the grid side, so range()^2 vertices (255 is the 16-bit index limit)
+static void BM_Model3DSLoad(BenchmarkState &state)
+{
+    char path[] = "bench_synthetic.3ds";
+    writeSynthetic3DS(path, (int)state.range());
+
+    int verts = 0;
+    while (state.keepRunning())
+    {
+        char name[sizeof(path)];
+        memcpy(name, path, sizeof(path));
+
+        Model_3DS *model = new Model_3DS();
+        model->Load(name);
+        verts += model->totalVerts;
+        delete model;
+    }
+    doNotOptimize(verts);
+    remove(path);
+
+    state.setItemsProcessed(state.iterations() * state.range() * state.range());
+}
+BENCHMARK(BM_Model3DSLoad)->Arg(32)->Arg(128)->Arg(255);
+
+// range() is the image side; odd sizes exercise the row padding path
+static void BM_BmpDecode(BenchmarkState &state)
+{
+    const char *path = "bench_synthetic.bmp";
+    int side = (int)state.range();
+    writeSyntheticBMP(path, side, side);
+
+    while (state.keepRunning())
+    {
+        AUX_RGBImageRec_TB *image = auxDIBImageLoadA_TB(path);
+        if (image)
+        {
+            doNotOptimize(image->data[0]);
+            free(image->data);
+            free(image);
+        }
+    }
+    remove(path);
+
+    state.setBytesProcessed(state.iterations() * side * side * 3);
+}
+BENCHMARK(BM_BmpDecode)->Arg(255)->Arg(1024)->Arg(2048);
+
+// range() is the image side, 24-bit BGR rows padded like a BMP, packed in place
+static void BM_SwapRedBlueRows(BenchmarkState &state)
+{
+    int side = (int)state.range();
+    size_t stride = ((size_t)side * 3 + 3) & ~(size_t)3;
+    std::vector<uint8_t> source(stride * side), pixels;
+    for (size_t i = 0; i < source.size(); i++)
+        source[i] = (uint8_t)(i * 7);
+
+    while (state.keepRunning())
+    {
+        pixels = source;
+        PixelConvert::swapRedBlueRows(&pixels[0], stride, &pixels[0], side, side, 3, false);
+        doNotOptimize(pixels[0]);
+    }
+
+    state.setBytesProcessed(state.iterations() * side * side * 3);
+}
+BENCHMARK(BM_SwapRedBlueRows)->Arg(255)->Arg(2048);
+
+// range() is the image side, RGBA
+static void BM_PngDecode(BenchmarkState &state)
+{
+    int side = (int)state.range();
+    std::vector<unsigned char> file = writeSyntheticPNG(side, side);
+
+    while (state.keepRunning())
+    {
+        DecodedImage image;
+        if (ImageDecoder::decodePNG(&file[0], file.size(), image))
+            doNotOptimize(image.pixels[0]);
+    }
+
+    state.setBytesProcessed(state.iterations() * side * side * 4);
+}
+BENCHMARK(BM_PngDecode)->Arg(256)->Arg(1024)->Arg(2048);
+
+// Writing a JPEG takes an encoder, so this decodes the shipped tire texture
+// (run from bin/ like the game) and measures nothing if it isn't there
+static void BM_JpegDecode(BenchmarkState &state)
+{
+    std::vector<unsigned char> file;
+    FILE *input = fopen("../src/textures/sporttire.jpg", "rb");
+    if (input)
+    {
+        unsigned char chunk[4096];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), input)) > 0)
+            file.insert(file.end(), chunk, chunk + n);
+        fclose(input);
+    }
+
+    int64_t pixels = 0;
+    while (state.keepRunning())
+    {
+        DecodedImage image;
+        if (!file.empty() && ImageDecoder::decodeJPEG(&file[0], file.size(), image))
+        {
+            doNotOptimize(image.pixels[0]);
+            pixels = (int64_t)image.width * image.height;
+        }
+    }
+
+    state.setBytesProcessed(state.iterations() * pixels * 3);
+}
+BENCHMARK(BM_JpegDecode);
+
+// range() is the image side; what the texture cooker spends per mip level
+static void BM_BC1Compress(BenchmarkState &state)
+{
+    int side = (int)state.range();
+    std::vector<uint8_t> pixels((size_t)side * side * 4);
+    for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] = (uint8_t)(i * 7 + (i >> 10) * 13);
+
+    std::vector<uint8_t> blocks;
+    while (state.keepRunning())
+    {
+        blocks.clear();
+        BlockCompression::compress(&pixels[0], side, side, DDS_FOURCC_DXT1, blocks);
+        doNotOptimize(blocks[0]);
+    }
+
+    state.setBytesProcessed(state.iterations() * side * side * 4);
+}
+BENCHMARK(BM_BC1Compress)->Arg(256)->Arg(1024);
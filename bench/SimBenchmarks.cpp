@@ -0,0 +1,114 @@
+// Simulation hot paths: player car physics and per-tick level collision logic
+#include "Benchmark.h"
+#include "Car.h"
+#include "Level1.h"
+#include "Level2.h"
+#include "JobSystem.h"
+#include <vector>
+
+static void BM_CarUpdate(BenchmarkState &state)
+{
+    Car car;
+    car.accelerate(true);
+
+    int64_t i = 0;
+    while (state.keepRunning())
+    {
+        // Weave left and right so the steering path is exercised too
+        bool left = (i++ / 60) % 2 == 0;
+        car.turnLeft(left);
+        car.turnRight(!left);
+        car.update();
+    }
+    doNotOptimize(car.getX());
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CarUpdate);
+
+// One simulation tick of Level1 with range() traffic slots, the car drives
+// forward so cars keep spawning ahead and despawning behind
+static void BM_Level1CheckCollisions(BenchmarkState &state)
+{
+    Level1 level;
+    level.setSeed(1234);
+    level.setTrafficSize((int)state.range());
+    level.init();
+
+    Car car;
+    car.accelerate(true);
+
+    bool crashed = false;
+    while (state.keepRunning())
+    {
+        car.update();
+        crashed ^= level.checkCollisions(car);
+    }
+    doNotOptimize(crashed);
+    state.setItemsProcessed(state.iterations() * state.range());
+}
+BENCHMARK(BM_Level1CheckCollisions)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+// Same tick with the per-car loop spread over a job system, one worker per core
+static void BM_Level1CheckCollisionsParallel(BenchmarkState &state)
+{
+    JobSystem jobs;
+
+    Level1 level;
+    level.setSeed(1234);
+    level.setTrafficSize((int)state.range());
+    level.setJobSystem(&jobs);
+    level.init();
+
+    Car car;
+    car.accelerate(true);
+
+    bool crashed = false;
+    while (state.keepRunning())
+    {
+        car.update();
+        crashed ^= level.checkCollisions(car);
+    }
+    doNotOptimize(crashed);
+    state.setItemsProcessed(state.iterations() * state.range());
+}
+BENCHMARK(BM_Level1CheckCollisionsParallel)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// Scheduling overhead: an almost empty body over range() items in 256-item chunks
+static void BM_JobSystemParallelFor(BenchmarkState &state)
+{
+    JobSystem jobs;
+    std::vector<float> values((size_t)state.range(), 1.0f);
+
+    while (state.keepRunning())
+    {
+        jobs.parallelFor(0, (int)values.size(), 256, [&](int first, int last)
+                         {
+                             for (int i = first; i < last; i++)
+                                 values[i] = values[i] * 0.5f + 1.0f;
+                         });
+    }
+    doNotOptimize(values[0]);
+    state.setItemsProcessed(state.iterations() * state.range());
+}
+BENCHMARK(BM_JobSystemParallelFor)->Arg(4096)->Arg(65536)->Arg(1048576);
+
+static void BM_Level2CheckCollisions(BenchmarkState &state)
+{
+    Level2 level;
+    level.setSeed(1234);
+    level.init();
+
+    Car car;
+    car.accelerate(true);
+    car.turnLeft(true);
+
+    bool crashed = false;
+    while (state.keepRunning())
+    {
+        car.update();
+        crashed ^= level.checkCollisions(car);
+    }
+    doNotOptimize(crashed);
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Level2CheckCollisions);
@@ -0,0 +1,412 @@
+#include "Audio.h"
+#include "Platform.h"
+#include "Profiler.h"
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static const char *SOUND_FILES[SOUND_COUNT] = {
+    "Sounds/engine.wav",
+    "Sounds/crash.wav",
+    "Sounds/pickup.wav",
+    "Sounds/horn.wav",
+};
+
+static const float MASTER_VOLUME = 0.8f;
+
+Audio::Audio()
+{
+    nextVoiceId = 1;
+    output = NULL;
+    running.store(false);
+
+    for (int i = 0; i < MAX_VOICES; i++)
+        voices[i].id = 0;
+}
+
+Audio::~Audio()
+{
+    stop();
+}
+
+bool Audio::start(AudioOutput *audioOutput)
+{
+    stop();
+
+    output = audioOutput;
+    if (!output || !output->open(SAMPLE_RATE, CHANNELS))
+    {
+        printf("Warning: audio disabled, could not open the %s output\n", output ? output->name() : "default");
+        delete output;
+        output = NULL;
+        return false;
+    }
+
+    for (int i = 0; i < SOUND_COUNT; i++)
+    {
+        if (!loadWav(SOUND_FILES[i], sounds[i]))
+        {
+            printf("Audio: could not load %s, using a generated stand-in\n", SOUND_FILES[i]);
+            synthesize((SoundId)i, sounds[i]);
+        }
+    }
+
+    commands.clear();
+    for (int i = 0; i < MAX_VOICES; i++)
+        voices[i].id = 0;
+
+    running.store(true);
+    mixer = std::thread(&Audio::mixerLoop, this);
+
+    printf("Audio: %s output, %d Hz\n", output->name(), SAMPLE_RATE);
+    fflush(stdout);
+    return true;
+}
+
+void Audio::stop()
+{
+    if (!running.exchange(false))
+        return;
+
+    if (mixer.joinable())
+        mixer.join();
+
+    output->close();
+    delete output;
+    output = NULL;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Game thread side
+//////////////////////////////////////////////////////////////////////
+
+uint32_t Audio::play(SoundId sound, float volume, float pitch, bool loop)
+{
+    if (!isRunning())
+        return 0;
+
+    Command c;
+    c.type = CMD_PLAY;
+    c.sound = (uint8_t)sound;
+    c.loop = loop ? 1 : 0;
+    c.voice = nextVoiceId;
+    c.volume = volume;
+    c.pitch = pitch;
+    if (!commands.push(c))
+        return 0;
+
+    nextVoiceId++;
+    if (nextVoiceId == 0)
+        nextVoiceId = 1;
+    return c.voice;
+}
+
+void Audio::setPitch(uint32_t voice, float pitch)
+{
+    if (!voice || !isRunning())
+        return;
+
+    Command c;
+    c.type = CMD_PITCH;
+    c.voice = voice;
+    c.pitch = pitch;
+    commands.push(c); // Dropped if the mixer is behind
+}
+
+void Audio::setVolume(uint32_t voice, float volume)
+{
+    if (!voice || !isRunning())
+        return;
+
+    Command c;
+    c.type = CMD_VOLUME;
+    c.voice = voice;
+    c.volume = volume;
+    commands.push(c);
+}
+
+void Audio::stopVoice(uint32_t voice)
+{
+    if (!voice || !isRunning())
+        return;
+
+    Command c;
+    c.type = CMD_STOP;
+    c.voice = voice;
+    commands.push(c);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Mixer thread side
+//////////////////////////////////////////////////////////////////////
+
+void Audio::mixerLoop()
+{
+    int16_t block[BLOCK_FRAMES * CHANNELS];
+
+    while (running.load(std::memory_order_relaxed))
+    {
+        drainCommands();
+        mix(block, BLOCK_FRAMES);
+        output->write(block, BLOCK_FRAMES); // Blocks until the output wants more
+    }
+}
+
+void Audio::drainCommands()
+{
+    Command c;
+    while (commands.pop(c))
+    {
+        if (c.type == CMD_PLAY)
+        {
+            // Take a free slot, or steal the one-shot closest to its end
+            int slot = -1;
+            double bestLeft = 0.0;
+            for (int i = 0; i < MAX_VOICES; i++)
+            {
+                if (voices[i].id == 0)
+                {
+                    slot = i;
+                    break;
+                }
+                if (!voices[i].loop)
+                {
+                    double left = sounds[voices[i].sound].samples.size() - voices[i].position;
+                    if (slot < 0 || left < bestLeft)
+                    {
+                        slot = i;
+                        bestLeft = left;
+                    }
+                }
+            }
+            if (slot < 0)
+                continue;
+
+            Voice &v = voices[slot];
+            v.id = c.voice;
+            v.sound = c.sound;
+            v.position = 0.0;
+            v.volume = c.volume;
+            v.pitch = c.pitch;
+            v.loop = c.loop != 0;
+            continue;
+        }
+
+        for (int i = 0; i < MAX_VOICES; i++)
+        {
+            Voice &v = voices[i];
+            if (v.id != c.voice)
+                continue;
+
+            if (c.type == CMD_PITCH)
+                v.pitch = c.pitch;
+            else if (c.type == CMD_VOLUME)
+                v.volume = c.volume;
+            else if (c.type == CMD_STOP)
+                v.id = 0;
+            break;
+        }
+    }
+}
+
+void Audio::mix(int16_t *out, int frames)
+{
+    PROFILE_ZONE("Audio::mix");
+
+    float accum[BLOCK_FRAMES];
+    for (int i = 0; i < frames; i++)
+        accum[i] = 0.0f;
+
+    for (int v = 0; v < MAX_VOICES; v++)
+    {
+        Voice &voice = voices[v];
+        if (voice.id == 0)
+            continue;
+
+        const Sound &sound = sounds[voice.sound];
+        const float *src = sound.samples.empty() ? NULL : &sound.samples[0];
+        size_t length = sound.samples.size();
+        double step = (double)sound.sampleRate / SAMPLE_RATE * voice.pitch;
+        double pos = voice.position;
+        float gain = voice.volume * MASTER_VOLUME;
+
+        for (int i = 0; i < frames; i++)
+        {
+            if (pos >= length)
+            {
+                if (!voice.loop || length == 0)
+                {
+                    voice.id = 0;
+                    break;
+                }
+                pos = fmod(pos, (double)length);
+            }
+
+            size_t i0 = (size_t)pos;
+            size_t i1 = i0 + 1 < length ? i0 + 1 : (voice.loop ? 0 : i0);
+            float frac = (float)(pos - i0);
+            accum[i] += (src[i0] + (src[i1] - src[i0]) * frac) * gain;
+            pos += step;
+        }
+        voice.position = pos;
+    }
+
+    for (int i = 0; i < frames; i++)
+    {
+        float s = accum[i];
+        if (s > 1.0f)
+            s = 1.0f;
+        if (s < -1.0f)
+            s = -1.0f;
+        out[i] = (int16_t)(s * 32767.0f);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+// Loading
+//////////////////////////////////////////////////////////////////////
+
+static unsigned int readU16(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned int readU32(const unsigned char *p)
+{
+    return readU16(p) | (readU16(p + 2) << 16);
+}
+
+// 8 or 16-bit PCM, any rate, channels are averaged down to mono
+bool Audio::loadWav(const char *path, Sound &sound)
+{
+    Platform::MappedFile file;
+    if (!Platform::mapFile(path, file))
+        return false;
+
+    const unsigned char *data = file.data;
+    size_t size = file.size;
+    bool ok = false;
+
+    if (size >= 12 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WAVE", 4) == 0)
+    {
+        unsigned int format = 0, channels = 0, rate = 0, bits = 0;
+        size_t pos = 12;
+
+        while (pos + 8 <= size)
+        {
+            unsigned int chunkSize = readU32(data + pos + 4);
+            const unsigned char *chunk = data + pos + 8;
+            if (chunkSize > size - pos - 8)
+                chunkSize = (unsigned int)(size - pos - 8);
+
+            if (memcmp(data + pos, "fmt ", 4) == 0 && chunkSize >= 16)
+            {
+                format = readU16(chunk);
+                channels = readU16(chunk + 2);
+                rate = readU32(chunk + 4);
+                bits = readU16(chunk + 14);
+            }
+            else if (memcmp(data + pos, "data", 4) == 0)
+            {
+                if (format != 1 || channels == 0 || rate == 0 || (bits != 8 && bits != 16))
+                    break;
+
+                unsigned int frameBytes = channels * bits / 8;
+                size_t frames = chunkSize / frameBytes;
+                sound.samples.resize(frames);
+                sound.sampleRate = (int)rate;
+
+                for (size_t f = 0; f < frames; f++)
+                {
+                    const unsigned char *p = chunk + f * frameBytes;
+                    float sum = 0.0f;
+                    for (unsigned int c = 0; c < channels; c++)
+                    {
+                        if (bits == 16)
+                            sum += (int16_t)readU16(p + c * 2) / 32768.0f;
+                        else
+                            sum += (p[c] - 128) / 128.0f;
+                    }
+                    sound.samples[f] = sum / channels;
+                }
+                ok = frames > 0;
+                break;
+            }
+
+            pos += 8 + chunkSize + (chunkSize & 1); // Chunks are word aligned
+        }
+    }
+
+    Platform::unmapFile(file);
+    if (!ok)
+        printf("Warning: %s is not an 8/16-bit PCM WAV\n", path);
+    return ok;
+}
+
+// Stand-in sounds for when the WAV files are not shipped
+void Audio::synthesize(SoundId id, Sound &sound)
+{
+    const int rate = SAMPLE_RATE;
+    sound.sampleRate = rate;
+
+    if (id == SOUND_ENGINE)
+    {
+        // One second of a 60 Hz rumble, a whole number of periods so it loops cleanly
+        sound.samples.resize(rate);
+        for (int i = 0; i < rate; i++)
+        {
+            double t = 2.0 * M_PI * 60.0 * i / rate;
+            sound.samples[i] = (float)(0.35 * sin(t) + 0.2 * sin(2 * t) + 0.12 * sin(3 * t) + 0.06 * sin(5 * t));
+        }
+    }
+    else if (id == SOUND_CRASH)
+    {
+        // Decaying low-passed noise
+        int n = rate * 8 / 10;
+        sound.samples.resize(n);
+        uint32_t noise = 0x12345678;
+        float smooth = 0.0f;
+        for (int i = 0; i < n; i++)
+        {
+            noise = noise * 1664525u + 1013904223u;
+            float white = (noise >> 8) / 8388608.0f - 1.0f;
+            smooth += (white - smooth) * 0.3f;
+            sound.samples[i] = smooth * expf(-5.0f * i / rate);
+        }
+    }
+    else if (id == SOUND_PICKUP)
+    {
+        // Rising chirp
+        int n = rate / 4;
+        sound.samples.resize(n);
+        double phase = 0.0;
+        for (int i = 0; i < n; i++)
+        {
+            double t = (double)i / n;
+            phase += 2.0 * M_PI * (600.0 + 800.0 * t) / rate;
+            sound.samples[i] = (float)(0.5 * sin(phase) * (1.0 - t));
+        }
+    }
+    else if (id == SOUND_HORN)
+    {
+        // Two-tone horn with a short attack and release
+        int n = rate / 2;
+        sound.samples.resize(n);
+        int ramp = rate / 100;
+        for (int i = 0; i < n; i++)
+        {
+            double t = (double)i / rate;
+            float env = 1.0f;
+            if (i < ramp)
+                env = (float)i / ramp;
+            else if (i > n - ramp)
+                env = (float)(n - i) / ramp;
+            float a = sin(2.0 * M_PI * 400.0 * t) > 0.0 ? 1.0f : -1.0f;
+            float b = sin(2.0 * M_PI * 500.0 * t) > 0.0 ? 1.0f : -1.0f;
+            sound.samples[i] = 0.2f * (a + b) * env;
+        }
+    }
+}
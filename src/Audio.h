@@ -0,0 +1,104 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include "AudioOutput.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+enum SoundId
+{
+    SOUND_ENGINE,
+    SOUND_CRASH,
+    SOUND_PICKUP,
+    SOUND_HORN,
+    SOUND_COUNT
+};
+
+// Software mixer running on its own thread.
+//
+// Every sound is decoded once at start() into mono float PCM. The game
+// thread never touches the mixer state, it only pushes small commands
+// into a lock-free single-producer ring that the mixer drains at the
+// start of each block, so playing a sound costs a few stores and never
+// blocks a frame. Voices are resampled with linear interpolation, which
+// is also how pitch is applied.
+class Audio
+{
+public:
+    Audio();
+    ~Audio();
+
+    // Loads the sounds and starts mixing into output, taking ownership of it
+    bool start(AudioOutput *output);
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+    // Game thread only. play() returns a voice handle for the setters,
+    // or 0 when audio is not running or the command ring is full.
+    uint32_t play(SoundId sound, float volume = 1.0f, float pitch = 1.0f, bool loop = false);
+    void setPitch(uint32_t voice, float pitch);
+    void setVolume(uint32_t voice, float volume);
+    void stopVoice(uint32_t voice);
+
+    static const int SAMPLE_RATE = 44100;
+    static const int CHANNELS = 1;
+    static const int BLOCK_FRAMES = 512; // ~12 ms
+    static const int MAX_VOICES = 16;
+
+private:
+    enum CommandType
+    {
+        CMD_PLAY,
+        CMD_PITCH,
+        CMD_VOLUME,
+        CMD_STOP
+    };
+
+    struct Command
+    {
+        uint8_t type;
+        uint8_t sound;
+        uint8_t loop;
+        uint32_t voice;
+        float volume;
+        float pitch;
+    };
+
+    struct Sound
+    {
+        std::vector<float> samples;
+        int sampleRate;
+    };
+
+    struct Voice
+    {
+        uint32_t id; // 0 when the slot is free
+        int sound;
+        double position; // In source samples
+        float volume;
+        float pitch;
+        bool loop;
+    };
+
+    SpscQueue<Command, 256> commands;
+
+    Sound sounds[SOUND_COUNT];
+    Voice voices[MAX_VOICES]; // Mixer thread only
+    uint32_t nextVoiceId;     // Game thread only
+
+    AudioOutput *output;
+    std::atomic<bool> running;
+    std::thread mixer;
+
+    void mixerLoop();
+    void drainCommands();
+    void mix(int16_t *out, int frames);
+
+    static bool loadWav(const char *path, Sound &sound);
+    static void synthesize(SoundId id, Sound &sound);
+};
+
+#endif
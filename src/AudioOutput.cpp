@@ -0,0 +1,137 @@
+#include "AudioOutput.h"
+#include "Platform.h"
+#include <chrono>
+#include <thread>
+
+// How far ahead of the wall clock a paced output may run
+static const uint64_t PACE_SLACK_NS = 20000000; // 20 ms
+
+//////////////////////////////////////////////////////////////////////
+// PacedAudioOutput
+//////////////////////////////////////////////////////////////////////
+
+PacedAudioOutput::PacedAudioOutput()
+{
+    rate = 0;
+    startNs = 0;
+    framesWritten = 0;
+}
+
+void PacedAudioOutput::startPacing(int sampleRate)
+{
+    rate = sampleRate;
+    startNs = Platform::nowNs();
+    framesWritten = 0;
+}
+
+void PacedAudioOutput::pace(int frames)
+{
+    framesWritten += frames;
+    uint64_t dueNs = startNs + framesWritten * 1000000000ULL / rate;
+    uint64_t now = Platform::nowNs();
+    if (dueNs > now + PACE_SLACK_NS)
+        std::this_thread::sleep_for(std::chrono::nanoseconds(dueNs - now - PACE_SLACK_NS));
+}
+
+//////////////////////////////////////////////////////////////////////
+// NullAudioOutput
+//////////////////////////////////////////////////////////////////////
+
+bool NullAudioOutput::open(int sampleRate, int channels)
+{
+    (void)channels;
+    startPacing(sampleRate);
+    return true;
+}
+
+void NullAudioOutput::write(const int16_t *samples, int frames)
+{
+    (void)samples;
+    pace(frames);
+}
+
+//////////////////////////////////////////////////////////////////////
+// WavFileAudioOutput
+//////////////////////////////////////////////////////////////////////
+
+static void putU16(FILE *file, unsigned int v)
+{
+    fputc(v & 0xFF, file);
+    fputc((v >> 8) & 0xFF, file);
+}
+
+static void putU32(FILE *file, unsigned int v)
+{
+    putU16(file, v & 0xFFFF);
+    putU16(file, v >> 16);
+}
+
+WavFileAudioOutput::WavFileAudioOutput(const char *filePath)
+{
+    path = filePath;
+    file = NULL;
+    channels = 1;
+    dataBytes = 0;
+}
+
+WavFileAudioOutput::~WavFileAudioOutput()
+{
+    close();
+}
+
+bool WavFileAudioOutput::open(int sampleRate, int channelCount)
+{
+    file = fopen(path, "wb");
+    if (!file)
+    {
+        printf("Warning: could not write audio to %s\n", path);
+        return false;
+    }
+
+    channels = channelCount;
+    dataBytes = 0;
+    writeHeader(sampleRate); // Sizes are patched in close()
+    startPacing(sampleRate);
+    return true;
+}
+
+void WavFileAudioOutput::writeHeader(int sampleRate)
+{
+    fwrite("RIFF", 1, 4, file);
+    putU32(file, 36 + dataBytes);
+    fwrite("WAVEfmt ", 1, 8, file);
+    putU32(file, 16);
+    putU16(file, 1); // PCM
+    putU16(file, channels);
+    putU32(file, sampleRate);
+    putU32(file, sampleRate * channels * 2);
+    putU16(file, channels * 2);
+    putU16(file, 16);
+    fwrite("data", 1, 4, file);
+    putU32(file, dataBytes);
+}
+
+void WavFileAudioOutput::write(const int16_t *samples, int frames)
+{
+    if (file)
+    {
+        // Samples are little endian in the file, byte by byte keeps this portable
+        for (int i = 0; i < frames * channels; i++)
+            putU16(file, (uint16_t)samples[i]);
+        dataBytes += frames * channels * 2;
+    }
+    pace(frames);
+}
+
+void WavFileAudioOutput::close()
+{
+    if (!file)
+        return;
+
+    fseek(file, 4, SEEK_SET);
+    putU32(file, 36 + dataBytes);
+    fseek(file, 40, SEEK_SET);
+    putU32(file, dataBytes);
+    fclose(file);
+    file = NULL;
+}
@@ -0,0 +1,66 @@
+#ifndef AUDIO_OUTPUT_H
+#define AUDIO_OUTPUT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Where the mixer sends its blocks of interleaved 16-bit samples.
+// write() is called from the mixer thread only and is expected to block
+// until the device (or the wall clock) is ready for more, which is what
+// paces the mixer.
+class AudioOutput
+{
+public:
+    virtual ~AudioOutput() {}
+    virtual bool open(int sampleRate, int channels) = 0;
+    virtual void write(const int16_t *samples, int frames) = 0;
+    virtual void close() = 0;
+    virtual const char *name() const = 0;
+};
+
+// Base for outputs without a device clock, keeps them at real time speed
+class PacedAudioOutput : public AudioOutput
+{
+protected:
+    PacedAudioOutput();
+    void startPacing(int sampleRate);
+    void pace(int frames);
+
+private:
+    int rate;
+    uint64_t startNs;
+    uint64_t framesWritten;
+};
+
+// Discards everything, for headless runs and machines without audio
+class NullAudioOutput : public PacedAudioOutput
+{
+public:
+    bool open(int sampleRate, int channels);
+    void write(const int16_t *samples, int frames);
+    void close() {}
+    const char *name() const { return "null"; }
+};
+
+// Records the mix to a WAV file so it can be checked without a sound card
+class WavFileAudioOutput : public PacedAudioOutput
+{
+public:
+    explicit WavFileAudioOutput(const char *path);
+    ~WavFileAudioOutput();
+
+    bool open(int sampleRate, int channels);
+    void write(const int16_t *samples, int frames);
+    void close();
+    const char *name() const { return "wav file"; }
+
+private:
+    const char *path;
+    FILE *file;
+    int channels;
+    uint32_t dataBytes;
+
+    void writeHeader(int sampleRate);
+};
+
+#endif
@@ -0,0 +1,356 @@
+#include "BlockCompression.h"
+#include "TextureFile.h"
+#include <math.h>
+#include <string.h>
+
+static int quantize(float value, int levels)
+{
+    int q = (int)(value * levels / 255.0f + 0.5f);
+    return q < 0 ? 0 : q > levels ? levels : q;
+}
+
+static int to565(const float color[3])
+{
+    return quantize(color[0], 31) << 11 | quantize(color[1], 63) << 5 | quantize(color[2], 31);
+}
+
+static void from565(int color, int rgb[3])
+{
+    int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+    rgb[0] = r << 3 | r >> 2;
+    rgb[1] = g << 2 | g >> 4;
+    rgb[2] = b << 3 | b >> 2;
+}
+
+// The four-color palette of a block whose first endpoint is the larger
+static void colorPalette(int c0, int c1, int palette[4][3])
+{
+    from565(c0, palette[0]);
+    from565(c1, palette[1]);
+    for (int c = 0; c < 3; c++)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+}
+
+// Nearest palette entry for every pixel; returns the summed squared error
+static int pickColorIndices(const uint8_t *block, int c0, int c1, uint32_t &indices)
+{
+    int palette[4][3];
+    colorPalette(c0, c1, palette);
+
+    indices = 0;
+    int error = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        const uint8_t *p = block + i * 4;
+        int best = 0, bestDistance = 1 << 30;
+        for (int k = 0; k < 4; k++)
+        {
+            int dr = p[0] - palette[k][0], dg = p[1] - palette[k][1], db = p[2] - palette[k][2];
+            int distance = dr * dr + dg * dg + db * db;
+            if (distance < bestDistance)
+            {
+                best = k;
+                bestDistance = distance;
+            }
+        }
+        indices |= (uint32_t)best << (i * 2);
+        error += bestDistance;
+    }
+    return error;
+}
+
+static void writeColorBlock(uint8_t *out, int c0, int c1, uint32_t indices)
+{
+    out[0] = (uint8_t)c0;
+    out[1] = (uint8_t)(c0 >> 8);
+    out[2] = (uint8_t)c1;
+    out[3] = (uint8_t)(c1 >> 8);
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (uint8_t)(indices >> (i * 8));
+}
+
+// Endpoints in the order that selects the four-color mode. Equal endpoints
+// would select BC1's three-color mode, where index 3 is transparent, so
+// they only ever use index 0.
+static int encodeEndpoints(const uint8_t *block, const float a[3], const float b[3], int &c0, int &c1,
+                           uint32_t &indices)
+{
+    c0 = to565(a);
+    c1 = to565(b);
+    if (c0 < c1)
+    {
+        int swap = c0;
+        c0 = c1;
+        c1 = swap;
+    }
+    int error = pickColorIndices(block, c0, c1, indices);
+    if (c0 == c1)
+        indices = 0;
+    return error;
+}
+
+static void encodeColor(const uint8_t *block, uint8_t *out)
+{
+    float mean[3] = {0, 0, 0};
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++)
+            mean[c] += block[i * 4 + c];
+    for (int c = 0; c < 3; c++)
+        mean[c] /= 16.0f;
+
+    // Covariance rr, rg, rb, gg, gb, bb
+    float cov[6] = {0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < 16; i++)
+    {
+        float r = block[i * 4] - mean[0], g = block[i * 4 + 1] - mean[1], b = block[i * 4 + 2] - mean[2];
+        cov[0] += r * r;
+        cov[1] += r * g;
+        cov[2] += r * b;
+        cov[3] += g * g;
+        cov[4] += g * b;
+        cov[5] += b * b;
+    }
+
+    // Principal axis by power iteration
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float length = sqrtf(x * x + y * y + z * z);
+        if (length < 1e-6f)
+            break; // Flat block, any axis will do
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    float minT = 1e9f, maxT = -1e9f;
+    for (int i = 0; i < 16; i++)
+    {
+        float t = (block[i * 4] - mean[0]) * axis[0] + (block[i * 4 + 1] - mean[1]) * axis[1] +
+                  (block[i * 4 + 2] - mean[2]) * axis[2];
+        minT = t < minT ? t : minT;
+        maxT = t > maxT ? t : maxT;
+    }
+    float hi[3], lo[3];
+    for (int c = 0; c < 3; c++)
+    {
+        hi[c] = mean[c] + axis[c] * maxT;
+        lo[c] = mean[c] + axis[c] * minT;
+    }
+
+    int c0, c1;
+    uint32_t indices;
+    int error = encodeEndpoints(block, hi, lo, c0, c1, indices);
+
+    // Least squares endpoints for these indices: each pixel is w * a + (1 - w) * b
+    if (c0 != c1 && error > 0)
+    {
+        static const float WEIGHTS[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+        float aa = 0, ab = 0, bb = 0, ax[3] = {0, 0, 0}, bx[3] = {0, 0, 0};
+        for (int i = 0; i < 16; i++)
+        {
+            float w = WEIGHTS[(indices >> (i * 2)) & 3];
+            aa += w * w;
+            ab += w * (1 - w);
+            bb += (1 - w) * (1 - w);
+            for (int c = 0; c < 3; c++)
+            {
+                ax[c] += w * block[i * 4 + c];
+                bx[c] += (1 - w) * block[i * 4 + c];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if (fabsf(det) > 1e-6f)
+        {
+            float a[3], b[3];
+            for (int c = 0; c < 3; c++)
+            {
+                a[c] = (bb * ax[c] - ab * bx[c]) / det;
+                b[c] = (aa * bx[c] - ab * ax[c]) / det;
+            }
+            int r0, r1;
+            uint32_t refined;
+            int refinedError = encodeEndpoints(block, a, b, r0, r1, refined);
+            if (refinedError < error)
+            {
+                c0 = r0;
+                c1 = r1;
+                indices = refined;
+            }
+        }
+    }
+
+    writeColorBlock(out, c0, c1, indices);
+}
+
+// One channel in the eight-value mode: endpoints are the block's range
+static void encodeChannel(const uint8_t *block, int channel, uint8_t *out)
+{
+    int lo = 255, hi = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int v = block[i * 4 + channel];
+        lo = v < lo ? v : lo;
+        hi = v > hi ? v : hi;
+    }
+
+    out[0] = (uint8_t)hi;
+    out[1] = (uint8_t)lo;
+    uint64_t bits = 0;
+    if (hi > lo)
+    {
+        int range = hi - lo;
+        for (int i = 0; i < 16; i++)
+        {
+            // Step 0..7 from hi to lo; codes 0 and 1 are the endpoints, 2..7 the steps between
+            int step = ((hi - block[i * 4 + channel]) * 7 + range / 2) / range;
+            int code = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+            bits |= (uint64_t)code << (i * 3);
+        }
+    }
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (uint8_t)(bits >> (i * 8));
+}
+
+void BlockCompression::encodeBC1(const uint8_t block[64], uint8_t out[8])
+{
+    encodeColor(block, out);
+}
+
+void BlockCompression::encodeBC3(const uint8_t block[64], uint8_t out[16])
+{
+    encodeChannel(block, 3, out);
+    encodeColor(block, out + 8);
+}
+
+void BlockCompression::encodeBC5(const uint8_t block[64], uint8_t out[16])
+{
+    encodeChannel(block, 0, out);
+    encodeChannel(block, 1, out + 8);
+}
+
+void BlockCompression::compress(const uint8_t *pixels, int width, int height, uint32_t fourCC,
+                                std::vector<uint8_t> &out)
+{
+    int blockBytes = ddsBlockBytes(fourCC);
+    out.reserve(out.size() + ddsLevelSize(width, height, blockBytes));
+    for (int by = 0; by < height; by += 4)
+    {
+        for (int bx = 0; bx < width; bx += 4)
+        {
+            uint8_t block[64];
+            for (int y = 0; y < 4; y++)
+            {
+                int sy = by + y < height ? by + y : height - 1;
+                for (int x = 0; x < 4; x++)
+                {
+                    int sx = bx + x < width ? bx + x : width - 1;
+                    memcpy(block + (y * 4 + x) * 4, pixels + ((size_t)sy * width + sx) * 4, 4);
+                }
+            }
+
+            size_t at = out.size();
+            out.resize(at + blockBytes);
+            if (fourCC == DDS_FOURCC_DXT1)
+                encodeBC1(block, &out[at]);
+            else if (fourCC == DDS_FOURCC_DXT5)
+                encodeBC3(block, &out[at]);
+            else
+                encodeBC5(block, &out[at]);
+        }
+    }
+}
+
+static void decodeColor(const uint8_t *in, uint8_t *block, bool bc1)
+{
+    int c0 = in[0] | in[1] << 8, c1 = in[2] | in[3] << 8;
+    int palette[4][3];
+    colorPalette(c0, c1, palette);
+    int alpha[4] = {255, 255, 255, 255};
+    if (bc1 && c0 <= c1)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+        alpha[3] = 0;
+    }
+
+    uint32_t indices = in[4] | in[5] << 8 | in[6] << 16 | (uint32_t)in[7] << 24;
+    for (int i = 0; i < 16; i++)
+    {
+        int k = (indices >> (i * 2)) & 3;
+        block[i * 4] = (uint8_t)palette[k][0];
+        block[i * 4 + 1] = (uint8_t)palette[k][1];
+        block[i * 4 + 2] = (uint8_t)palette[k][2];
+        block[i * 4 + 3] = (uint8_t)alpha[k];
+    }
+}
+
+static void decodeChannel(const uint8_t *in, uint8_t *block, int channel)
+{
+    int a0 = in[0], a1 = in[1];
+    int palette[8] = {a0, a1};
+    if (a0 > a1)
+    {
+        for (int k = 1; k < 7; k++)
+            palette[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+    }
+    else
+    {
+        for (int k = 1; k < 5; k++)
+            palette[k + 1] = ((5 - k) * a0 + k * a1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; i++)
+        bits |= (uint64_t)in[2 + i] << (i * 8);
+    for (int i = 0; i < 16; i++)
+        block[i * 4 + channel] = (uint8_t)palette[(bits >> (i * 3)) & 7];
+}
+
+void BlockCompression::decompress(const uint8_t *blocks, int width, int height, uint32_t fourCC, uint8_t *pixels)
+{
+    int blockBytes = ddsBlockBytes(fourCC);
+    for (int by = 0; by < height; by += 4)
+    {
+        for (int bx = 0; bx < width; bx += 4, blocks += blockBytes)
+        {
+            uint8_t block[64];
+            if (fourCC == DDS_FOURCC_DXT1)
+                decodeColor(blocks, block, true);
+            else if (fourCC == DDS_FOURCC_DXT5)
+            {
+                decodeColor(blocks + 8, block, false);
+                decodeChannel(blocks, block, 3);
+            }
+            else
+            {
+                decodeChannel(blocks, block, 0);
+                decodeChannel(blocks + 8, block, 1);
+                for (int i = 0; i < 16; i++)
+                {
+                    float x = block[i * 4] / 127.5f - 1.0f, y = block[i * 4 + 1] / 127.5f - 1.0f;
+                    float zz = 1.0f - x * x - y * y;
+                    block[i * 4 + 2] = (uint8_t)((zz > 0 ? sqrtf(zz) : 0.0f) * 127.5f + 127.5f);
+                    block[i * 4 + 3] = 255;
+                }
+            }
+
+            for (int y = 0; y < 4 && by + y < height; y++)
+            {
+                int columns = width - bx < 4 ? width - bx : 4;
+                memcpy(pixels + ((size_t)(by + y) * width + bx) * 4, block + y * 16, columns * 4);
+            }
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <stdint.h>
+#include <vector>
+
+// BC1, BC3 and BC5 (DXT1, DXT5 and ATI2) encoding for the texture cooker,
+// and decoding for drivers without compressed texture support.
+// Colors are fitted along the principal axis of each block, then the two
+// endpoints are refined once by least squares for the chosen indices.
+// Single channels (BC3 alpha, BC5 x and y) use their range and the
+// eight-value mode.
+class BlockCompression
+{
+public:
+    // pixels: width * height RGBA. Edge blocks repeat the last row and column.
+    // Appends the blocks, rows in the order they are in pixels, to out.
+    // fourCC is one of the DDS_FOURCC_* in TextureFile.h; BC5 takes red and green.
+    static void compress(const uint8_t *pixels, int width, int height, uint32_t fourCC, std::vector<uint8_t> &out);
+
+    // The reverse, into width * height RGBA. BC5 rebuilds blue as the z of a
+    // unit normal so a normal map still looks like one.
+    static void decompress(const uint8_t *blocks, int width, int height, uint32_t fourCC, uint8_t *pixels);
+
+    // One 4x4 block of RGBA pixels, row by row
+    static void encodeBC1(const uint8_t block[64], uint8_t out[8]);
+    static void encodeBC3(const uint8_t block[64], uint8_t out[16]);
+    static void encodeBC5(const uint8_t block[64], uint8_t out[16]);
+};
+
+#endif
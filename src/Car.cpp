@@ -1,18 +1,50 @@
 #include "Car.h"
+#include "Lighting.h"
+#include "Profiler.h"
+#include "Shadows.h"
+#include "Transparency.h"
 #include <cmath>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+// Headlight bulbs relative to the car, front left and front right
+static const float HEADLIGHT_X[2] = {0.7f, -0.3f};
+static const float HEADLIGHT_Y = -0.3f;
+static const float HEADLIGHT_Z = 2.2f;
+static const float BEAM_COLOR[4] = {1.0f, 1.0f, 0.8f, 0.2f}; // Transparent yellow
+
+// The PBR model is scaled to this length and its wheels put on the ground,
+// which is this far below the car's origin
+static const float PBR_LENGTH = 4.4f;
+static const float PBR_GROUND = -1.0f;
+
 Car::Car()
 {
     modelLoaded = false;
+    pbrLoaded = false;
     reset(0, 0);
 }
 
 void Car::init()
 {
+    // Sized from its bounds, +z is already the front
+    if (pbrMesh.load("Models/Car_Modeling.obj"))
+    {
+        pbrMesh.upload();
+        pbrMaterials.resize(pbrMesh.groups.size());
+        for (size_t i = 0; i < pbrMesh.groups.size(); i++)
+            pbrMaterials[i].load(("Textures/Car_Modeling_" + pbrMesh.groups[i].material).c_str());
+
+        pbrScale = PBR_LENGTH / (pbrMesh.boundsMax[2] - pbrMesh.boundsMin[2]);
+        pbrOffset[0] = -(pbrMesh.boundsMin[0] + pbrMesh.boundsMax[0]) * 0.5f * pbrScale;
+        pbrOffset[1] = PBR_GROUND - pbrMesh.boundsMin[1] * pbrScale;
+        pbrOffset[2] = -(pbrMesh.boundsMin[2] + pbrMesh.boundsMax[2]) * 0.5f * pbrScale;
+        pbrLoaded = true;
+        return;
+    }
+
     // Load the 3D car model
     carModel.Load((char *)"Models/car/your_car.3ds");
 
@@ -63,11 +95,35 @@ void Car::reset(float startX, float startZ)
     speed = 0.0f;
     tiltAngle = 0.0f;
     isAccelerating = false;
+    isBraking = false;
+    isTurningLeft = false;
     isTurningRight = false;
     lightsOn = true;
     boostMultiplier = 1.0f;
 }
 
+Car::State Car::getState() const
+{
+    State state;
+    state.x = x;
+    state.z = z;
+    state.rotation = rotation;
+    state.speed = speed;
+    state.tiltAngle = tiltAngle;
+    state.lightsOn = lightsOn;
+    return state;
+}
+
+void Car::setState(const State &state)
+{
+    x = state.x;
+    z = state.z;
+    rotation = state.rotation;
+    speed = state.speed;
+    tiltAngle = state.tiltAngle;
+    lightsOn = state.lightsOn;
+}
+
 void Car::accelerate(bool on) { isAccelerating = on; }
 void Car::brake(bool on) { isBraking = on; }
 void Car::turnLeft(bool on) { isTurningLeft = on; }
@@ -80,6 +136,8 @@ void Car::setBoost(bool on)
 
 void Car::update()
 {
+    PROFILE_ZONE("Car::update");
+
     // Speed control
     float effectiveAccel = ACCELERATION * boostMultiplier;
     float effectiveMax = MAX_SPEED * boostMultiplier;
@@ -143,19 +201,29 @@ void Car::update()
 
 void Car::draw()
 {
+    PROFILE_GPU_ZONE("Car::draw");
+
     glPushMatrix();
     glTranslatef(x, 1.0f, z); // Lift car above ground (raised for 3D model)
     glRotatef(rotation, 0, 1, 0);
     glRotatef(tiltAngle, 0, 0, 1); // Apply tilt (Roll)
 
     // Draw 3D model if loaded, otherwise fall back to primitive shapes
-    if (modelLoaded)
+    if (pbrLoaded)
+    {
+        glPushMatrix();
+        glTranslatef(pbrOffset[0], pbrOffset[1], pbrOffset[2]);
+        glScalef(pbrScale, pbrScale, pbrScale);
+        PbrShading::draw(pbrMesh, &pbrMaterials[0]);
+        glPopMatrix();
+    }
+    else if (modelLoaded)
     {
         glPushMatrix();
 
         // Enable textures for the 3D model
         glEnable(GL_TEXTURE_2D);
-        glEnable(GL_LIGHTING);
+        Lighting::enable();
 
         // Set up metallic/shiny material properties for the car
         GLfloat matSpecular[] = {1.0f, 1.0f, 1.0f, 1.0f}; // Bright white specular highlights
@@ -186,10 +254,14 @@ void Car::draw()
     }
 
     // Headlights
+    bool fixedLights = !Lighting::isActive(); // Otherwise addLights() already queued them
     if (lightsOn)
     {
-        glEnable(GL_LIGHT1);
-        glEnable(GL_LIGHT2);
+        if (fixedLights)
+        {
+            glEnable(GL_LIGHT1);
+            glEnable(GL_LIGHT2);
+        }
 
         // Light properties
         GLfloat lightCol[] = {1.0f, 1.0f, 0.8f, 1.0f}; // Yellowish
@@ -206,83 +278,73 @@ void Car::draw()
         GLfloat Kl = 0.1f;
         GLfloat Kq = 0.05f;
 
-        // Enable Blending for light beams
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
         // Left Headlight
         glPushMatrix();
-        glTranslatef(0.7f, -0.3f, 2.2f); // Front Left (adjusted to match 3D model headlights)
+        glTranslatef(HEADLIGHT_X[0], HEADLIGHT_Y, HEADLIGHT_Z); // Front Left (adjusted to match 3D model headlights)
 
         // Visual representation (The bulb)
-        glDisable(GL_LIGHTING);
+        Lighting::disable();
         glColor3f(1.0f, 1.0f, 0.5f);
         glutSolidSphere(0.1, 10, 10);
 
-        // Light Beam (Volumetric effect)
-        glColor4f(1.0f, 1.0f, 0.8f, 0.2f); // Transparent yellow
+        // Light Beam (Volumetric effect), drawn after the opaque scene
         glPushMatrix();
         glRotatef(10, 1, 0, 0); // Angle down slightly (was 20, now 10)
-        // Cone logic: Tip at 0, Base at Length
-        // glutSolidCone draws Base at 0, Tip at Length
-        // We want the opposite: Tip at 0, Base at Length
-        // So we translate to Length, and scale Z by -1 to flip it back to 0
-        glTranslatef(0.0f, 0.0f, 4.0f);
-        glScalef(1.0f, 1.0f, -1.0f);
-        glutSolidCone(0.5, 4.0, 10, 10);
+        Transparency::addBeam(0.5f, 4.0f, BEAM_COLOR);
         glPopMatrix();
 
-        glEnable(GL_LIGHTING);
+        Lighting::enable();
 
         // The Light Source
-        GLfloat pos1[] = {0.0f, 0.0f, 0.0f, 1.0f}; // Relative to this pushmatrix
-        glLightfv(GL_LIGHT1, GL_POSITION, pos1);
-        glLightfv(GL_LIGHT1, GL_DIFFUSE, lightCol);
-        glLightfv(GL_LIGHT1, GL_AMBIENT, lightAmb);
-        glLightfv(GL_LIGHT1, GL_SPOT_DIRECTION, spotDir);
-        glLightf(GL_LIGHT1, GL_SPOT_CUTOFF, spotCutoff);
-        glLightf(GL_LIGHT1, GL_SPOT_EXPONENT, spotExp);
-        glLightf(GL_LIGHT1, GL_CONSTANT_ATTENUATION, Kc);
-        glLightf(GL_LIGHT1, GL_LINEAR_ATTENUATION, Kl);
-        glLightf(GL_LIGHT1, GL_QUADRATIC_ATTENUATION, Kq);
+        if (fixedLights)
+        {
+            GLfloat pos1[] = {0.0f, 0.0f, 0.0f, 1.0f}; // Relative to this pushmatrix
+            glLightfv(GL_LIGHT1, GL_POSITION, pos1);
+            glLightfv(GL_LIGHT1, GL_DIFFUSE, lightCol);
+            glLightfv(GL_LIGHT1, GL_AMBIENT, lightAmb);
+            glLightfv(GL_LIGHT1, GL_SPOT_DIRECTION, spotDir);
+            glLightf(GL_LIGHT1, GL_SPOT_CUTOFF, spotCutoff);
+            glLightf(GL_LIGHT1, GL_SPOT_EXPONENT, spotExp);
+            glLightf(GL_LIGHT1, GL_CONSTANT_ATTENUATION, Kc);
+            glLightf(GL_LIGHT1, GL_LINEAR_ATTENUATION, Kl);
+            glLightf(GL_LIGHT1, GL_QUADRATIC_ATTENUATION, Kq);
+        }
 
         glPopMatrix();
 
         // Right Headlight
         glPushMatrix();
-        glTranslatef(-0.3f, -0.3f, 2.2f); // Front Right (adjusted to match 3D model headlights)
+        glTranslatef(HEADLIGHT_X[1], HEADLIGHT_Y, HEADLIGHT_Z); // Front Right (adjusted to match 3D model headlights)
 
         // Visual representation
-        glDisable(GL_LIGHTING);
+        Lighting::disable();
         glColor3f(1.0f, 1.0f, 0.5f);
         glutSolidSphere(0.1, 10, 10);
 
-        // Light Beam (Volumetric effect)
-        glColor4f(1.0f, 1.0f, 0.8f, 0.2f); // Transparent yellow
+        // Light Beam (Volumetric effect), drawn after the opaque scene
         glPushMatrix();
         glRotatef(10, 1, 0, 0); // Angle down slightly (was 20, now 10)
-        glTranslatef(0.0f, 0.0f, 4.0f);
-        glScalef(1.0f, 1.0f, -1.0f);
-        glutSolidCone(0.5, 4.0, 10, 10);
+        Transparency::addBeam(0.5f, 4.0f, BEAM_COLOR);
         glPopMatrix();
 
-        glEnable(GL_LIGHTING);
+        Lighting::enable();
 
         // The Light Source
-        GLfloat pos2[] = {0.0f, 0.0f, 0.0f, 1.0f};
-        glLightfv(GL_LIGHT2, GL_POSITION, pos2);
-        glLightfv(GL_LIGHT2, GL_DIFFUSE, lightCol);
-        glLightfv(GL_LIGHT2, GL_AMBIENT, lightAmb);
-        glLightfv(GL_LIGHT2, GL_SPOT_DIRECTION, spotDir);
-        glLightf(GL_LIGHT2, GL_SPOT_CUTOFF, spotCutoff);
-        glLightf(GL_LIGHT2, GL_SPOT_EXPONENT, spotExp);
-        glLightf(GL_LIGHT2, GL_CONSTANT_ATTENUATION, Kc);
-        glLightf(GL_LIGHT2, GL_LINEAR_ATTENUATION, Kl);
-        glLightf(GL_LIGHT2, GL_QUADRATIC_ATTENUATION, Kq);
+        if (fixedLights)
+        {
+            GLfloat pos2[] = {0.0f, 0.0f, 0.0f, 1.0f};
+            glLightfv(GL_LIGHT2, GL_POSITION, pos2);
+            glLightfv(GL_LIGHT2, GL_DIFFUSE, lightCol);
+            glLightfv(GL_LIGHT2, GL_AMBIENT, lightAmb);
+            glLightfv(GL_LIGHT2, GL_SPOT_DIRECTION, spotDir);
+            glLightf(GL_LIGHT2, GL_SPOT_CUTOFF, spotCutoff);
+            glLightf(GL_LIGHT2, GL_SPOT_EXPONENT, spotExp);
+            glLightf(GL_LIGHT2, GL_CONSTANT_ATTENUATION, Kc);
+            glLightf(GL_LIGHT2, GL_LINEAR_ATTENUATION, Kl);
+            glLightf(GL_LIGHT2, GL_QUADRATIC_ATTENUATION, Kq);
+        }
 
         glPopMatrix();
-
-        glDisable(GL_BLEND);
     }
     else
     {
@@ -293,6 +355,69 @@ void Car::draw()
     glPopMatrix();
 }
 
+// Same spotlights draw() sets up for the fixed-function path, in world space
+Light Car::getHeadlight(int index) const
+{
+    float rad = rotation * M_PI / 180.0f;
+    float s = sin(rad);
+    float c = cos(rad);
+
+    Light light;
+    light.dirX = s;       // Spot direction (0, -0.5, 1) turned with the car
+    light.dirY = -0.5f;
+    light.dirZ = c;
+    light.r = 1.0f;
+    light.g = 1.0f;
+    light.b = 0.8f;
+    light.spotCutoff = 30.0f;
+    light.spotExponent = 10.0f;
+    light.constant = 1.0f;
+    light.linear = 0.1f;
+    light.quadratic = 0.05f;
+    light.range = 40.0f;
+    light.x = x + HEADLIGHT_X[index] * c + HEADLIGHT_Z * s;
+    light.y = 1.0f + HEADLIGHT_Y;
+    light.z = z - HEADLIGHT_X[index] * s + HEADLIGHT_Z * c;
+    light.shadowMap = Shadows::isActive() ? index : -1; // Game::drawShadows() renders one per headlight
+    return light;
+}
+
+void Car::addLights()
+{
+    if (!lightsOn)
+        return;
+
+    for (int i = 0; i < 2; i++)
+        Lighting::addLight(getHeadlight(i));
+}
+
+void Car::drawShadowCaster()
+{
+    glPushMatrix();
+    glTranslatef(x, 1.0f, z);
+    glRotatef(rotation, 0, 1, 0);
+    glRotatef(tiltAngle, 0, 0, 1);
+
+    if (pbrLoaded)
+    {
+        glTranslatef(pbrOffset[0], pbrOffset[1], pbrOffset[2]);
+        glScalef(pbrScale, pbrScale, pbrScale);
+        pbrMesh.bind(-1);
+        for (size_t g = 0; g < pbrMesh.groups.size(); g++)
+            pbrMesh.draw(g);
+        pbrMesh.unbind(-1);
+    }
+    else if (modelLoaded)
+        carModel.Draw();
+    else
+    {
+        drawBody();
+        drawWheels();
+    }
+
+    glPopMatrix();
+}
+
 void Car::drawBody()
 {
     // Main body
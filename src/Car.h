@@ -2,7 +2,10 @@
 #define CAR_H
 
 #include <GL/glut.h>
+#include "Lighting.h"
 #include "Model_3DS.h"
+#include "ObjMesh.h"
+#include "PbrShading.h"
 
 class Car
 {
@@ -13,6 +16,9 @@ public:
     void reset(float x, float z);
     void update();
     void draw();
+    void addLights(); // Headlights for the shader lighting path
+    Light getHeadlight(int index) const; // 0 = left, 1 = right, in world space
+    void drawShadowCaster(); // The body alone, for shadow maps
 
     // Controls
     void accelerate(bool on);
@@ -27,11 +33,24 @@ public:
     float getZ() const { return z; }
     float getRotation() const { return rotation; }
     float getSpeed() const { return speed; }
+    float getMaxSpeed() const { return MAX_SPEED; } // Without boost
     bool isLightsOn() const { return lightsOn; }
 
     // Setters
     void setZ(float newZ) { z = newZ; }
 
+    // Everything draw() needs, copied from the simulation to the render thread
+    struct State
+    {
+        float x, z;
+        float rotation;
+        float speed;
+        float tiltAngle;
+        bool lightsOn;
+    };
+    State getState() const;
+    void setState(const State &state);
+
 private:
     float x, z;
     float rotation; // Degrees
@@ -59,6 +78,13 @@ private:
     // 3D Model
     Model_3DS carModel;
     bool modelLoaded;
+
+    // Metal/roughness model, drawn in preference to the 3DS one
+    ObjMesh pbrMesh;
+    std::vector<PbrMaterial> pbrMaterials; // One per mesh group
+    bool pbrLoaded;
+    float pbrScale;
+    float pbrOffset[3];
 };
 
 #endif
@@ -0,0 +1,57 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+// Plain data components for level objects, stored densely by Registry.
+// An object is whatever set of these its entity has: a traffic car is
+// Transform + Velocity + Collider + Renderable + AIDriver, a power-up is
+// Transform + Collider + Renderable + Pickup, a cone has no Velocity.
+
+struct Transform
+{
+    float x, z;
+    float rotation; // Degrees around y
+};
+
+// Traffic drives along +z
+struct Velocity
+{
+    float speed; // Units per tick
+};
+
+// Axis aligned box centred on the Transform
+struct Collider
+{
+    float width, length;
+};
+
+enum RenderKind
+{
+    RENDER_TRAFFIC_CAR,
+    RENDER_NO_TRAFFIC,
+    RENDER_BOOST,
+    RENDER_CONE,
+    RENDER_PERSON
+};
+
+struct Renderable
+{
+    int kind;       // RenderKind
+    int colorIndex; // Traffic cars: 0 = red, 1 = yellow, 2 = orange
+};
+
+struct Pickup
+{
+    int type; // 0 = No Traffic, 1 = Boost
+};
+
+// Lane following traffic, driven by TrafficSystem
+struct AIDriver
+{
+    int lane;
+    float desiredSpeed; // Units per tick on a free road
+    int cooldown;       // Ticks until the next lane change is allowed
+    float targetX;      // Shoulder x while pulling off the road
+    bool isMovingAside; // Flashed while in an outer lane, leaving the road
+};
+
+#endif
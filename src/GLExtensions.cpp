@@ -0,0 +1,135 @@
+#include "GLExtensions.h"
+#include <string.h>
+
+bool GLExtensions::loaded = false;
+
+bool GLExtensions::hasTimerQuery = false;
+GLExtensions::GenQueriesProc GLExtensions::genQueries = 0;
+GLExtensions::DeleteQueriesProc GLExtensions::deleteQueries = 0;
+GLExtensions::QueryCounterProc GLExtensions::queryCounter = 0;
+GLExtensions::GetQueryObjectivProc GLExtensions::getQueryObjectiv = 0;
+GLExtensions::GetQueryObjectui64vProc GLExtensions::getQueryObjectui64v = 0;
+
+bool GLExtensions::hasShaders = false;
+GLExtensions::CreateShaderProc GLExtensions::createShader = 0;
+GLExtensions::ShaderSourceProc GLExtensions::shaderSource = 0;
+GLExtensions::CompileShaderProc GLExtensions::compileShader = 0;
+GLExtensions::GetShaderivProc GLExtensions::getShaderiv = 0;
+GLExtensions::GetShaderInfoLogProc GLExtensions::getShaderInfoLog = 0;
+GLExtensions::DeleteShaderProc GLExtensions::deleteShader = 0;
+GLExtensions::CreateProgramProc GLExtensions::createProgram = 0;
+GLExtensions::AttachShaderProc GLExtensions::attachShader = 0;
+GLExtensions::LinkProgramProc GLExtensions::linkProgram = 0;
+GLExtensions::GetProgramivProc GLExtensions::getProgramiv = 0;
+GLExtensions::GetProgramInfoLogProc GLExtensions::getProgramInfoLog = 0;
+GLExtensions::UseProgramProc GLExtensions::useProgram = 0;
+GLExtensions::GetUniformLocationProc GLExtensions::getUniformLocation = 0;
+GLExtensions::Uniform1iProc GLExtensions::uniform1i = 0;
+GLExtensions::Uniform1fProc GLExtensions::uniform1f = 0;
+GLExtensions::UniformMatrix3fvProc GLExtensions::uniformMatrix3fv = 0;
+GLExtensions::GetAttribLocationProc GLExtensions::getAttribLocation = 0;
+GLExtensions::VertexAttribPointerProc GLExtensions::vertexAttribPointer = 0;
+GLExtensions::EnableVertexAttribArrayProc GLExtensions::enableVertexAttribArray = 0;
+GLExtensions::DisableVertexAttribArrayProc GLExtensions::disableVertexAttribArray = 0;
+GLExtensions::ActiveTextureProc GLExtensions::activeTexture = 0;
+
+bool GLExtensions::hasBufferObjects = false;
+GLExtensions::GenBuffersProc GLExtensions::genBuffers = 0;
+GLExtensions::BindBufferProc GLExtensions::bindBuffer = 0;
+GLExtensions::BufferDataProc GLExtensions::bufferData = 0;
+GLExtensions::BufferSubDataProc GLExtensions::bufferSubData = 0;
+
+bool GLExtensions::hasUniformBuffers = false;
+GLExtensions::GetUniformBlockIndexProc GLExtensions::getUniformBlockIndex = 0;
+GLExtensions::UniformBlockBindingProc GLExtensions::uniformBlockBinding = 0;
+GLExtensions::BindBufferBaseProc GLExtensions::bindBufferBase = 0;
+
+bool GLExtensions::hasFramebuffers = false;
+GLExtensions::GenFramebuffersProc GLExtensions::genFramebuffers = 0;
+GLExtensions::BindFramebufferProc GLExtensions::bindFramebuffer = 0;
+GLExtensions::FramebufferTexture2DProc GLExtensions::framebufferTexture2D = 0;
+GLExtensions::CheckFramebufferStatusProc GLExtensions::checkFramebufferStatus = 0;
+GLExtensions::BlitFramebufferProc GLExtensions::blitFramebuffer = 0;
+
+bool GLExtensions::hasS3TC = false;
+bool GLExtensions::hasRGTC = false;
+GLExtensions::CompressedTexImage2DProc GLExtensions::compressedTexImage2D = 0;
+
+template <typename T>
+static bool loadProc(T &proc, const char *name)
+{
+    proc = (T)glutGetProcAddress(name);
+    return proc != 0;
+}
+
+void GLExtensions::load()
+{
+    if (loaded)
+        return;
+    loaded = true;
+
+    hasTimerQuery = loadProc(genQueries, "glGenQueries") &&
+                    loadProc(deleteQueries, "glDeleteQueries") &&
+                    loadProc(queryCounter, "glQueryCounter") &&
+                    loadProc(getQueryObjectiv, "glGetQueryObjectiv") &&
+                    loadProc(getQueryObjectui64v, "glGetQueryObjectui64v");
+
+    hasShaders = loadProc(createShader, "glCreateShader") &&
+                 loadProc(shaderSource, "glShaderSource") &&
+                 loadProc(compileShader, "glCompileShader") &&
+                 loadProc(getShaderiv, "glGetShaderiv") &&
+                 loadProc(getShaderInfoLog, "glGetShaderInfoLog") &&
+                 loadProc(deleteShader, "glDeleteShader") &&
+                 loadProc(createProgram, "glCreateProgram") &&
+                 loadProc(attachShader, "glAttachShader") &&
+                 loadProc(linkProgram, "glLinkProgram") &&
+                 loadProc(getProgramiv, "glGetProgramiv") &&
+                 loadProc(getProgramInfoLog, "glGetProgramInfoLog") &&
+                 loadProc(useProgram, "glUseProgram") &&
+                 loadProc(getUniformLocation, "glGetUniformLocation") &&
+                 loadProc(uniform1i, "glUniform1i") &&
+                 loadProc(uniform1f, "glUniform1f") &&
+                 loadProc(uniformMatrix3fv, "glUniformMatrix3fv") &&
+                 loadProc(getAttribLocation, "glGetAttribLocation") &&
+                 loadProc(vertexAttribPointer, "glVertexAttribPointer") &&
+                 loadProc(enableVertexAttribArray, "glEnableVertexAttribArray") &&
+                 loadProc(disableVertexAttribArray, "glDisableVertexAttribArray") &&
+                 loadProc(activeTexture, "glActiveTexture");
+
+    hasBufferObjects = loadProc(genBuffers, "glGenBuffers") &&
+                       loadProc(bindBuffer, "glBindBuffer") &&
+                       loadProc(bufferData, "glBufferData") &&
+                       loadProc(bufferSubData, "glBufferSubData");
+
+    hasUniformBuffers = hasBufferObjects &&
+                        loadProc(getUniformBlockIndex, "glGetUniformBlockIndex") &&
+                        loadProc(uniformBlockBinding, "glUniformBlockBinding") &&
+                        loadProc(bindBufferBase, "glBindBufferBase");
+
+    hasFramebuffers = loadProc(genFramebuffers, "glGenFramebuffers") &&
+                      loadProc(bindFramebuffer, "glBindFramebuffer") &&
+                      loadProc(framebufferTexture2D, "glFramebufferTexture2D") &&
+                      loadProc(checkFramebufferStatus, "glCheckFramebufferStatus") &&
+                      loadProc(blitFramebuffer, "glBlitFramebuffer");
+
+    bool compressed = loadProc(compressedTexImage2D, "glCompressedTexImage2D");
+    hasS3TC = compressed && hasExtension("GL_EXT_texture_compression_s3tc");
+    hasRGTC = compressed && (hasExtension("GL_ARB_texture_compression_rgtc") ||
+                             hasExtension("GL_EXT_texture_compression_rgtc"));
+}
+
+bool GLExtensions::hasExtension(const char *name)
+{
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    if (!extensions)
+        return false;
+
+    // Whole words only, some names are prefixes of others
+    size_t length = strlen(name);
+    for (const char *p = strstr(extensions, name); p; p = strstr(p + length, name))
+    {
+        if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,200 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <GL/freeglut.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Opengl32 on Windows only exports GL 1.1, so anything newer is fetched
+// at runtime through glutGetProcAddress(). Call load() once a context exists
+// and check the has* flags before using a feature.
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+
+#ifndef GL_VERSION_1_3
+#define GL_TEXTURE0 0x84C0
+#endif
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+#ifndef GL_VERSION_1_5
+typedef ptrdiff_t GLintptr;
+typedef ptrdiff_t GLsizeiptr;
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STATIC_DRAW 0x88E4
+#define GL_DYNAMIC_DRAW 0x88E8
+#endif
+#ifndef GL_VERSION_2_0
+typedef char GLchar;
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_INFO_LOG_LENGTH 0x8B84
+#endif
+#ifndef GL_UNIFORM_BUFFER
+#define GL_UNIFORM_BUFFER 0x8A11
+#endif
+#ifndef GL_INVALID_INDEX
+#define GL_INVALID_INDEX 0xFFFFFFFFu
+#endif
+#ifndef GL_TEXTURE_BASE_LEVEL
+#define GL_TEXTURE_BASE_LEVEL 0x813C
+#endif
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RG_RGTC2
+#define GL_COMPRESSED_RG_RGTC2 0x8DBD
+#endif
+#ifndef GL_VERSION_1_4
+#define GL_DEPTH_COMPONENT24 0x81A6
+#define GL_TEXTURE_COMPARE_MODE 0x884C
+#define GL_TEXTURE_COMPARE_FUNC 0x884D
+#define GL_COMPARE_R_TO_TEXTURE 0x884E
+#endif
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_READ_FRAMEBUFFER 0x8CA8
+#define GL_DRAW_FRAMEBUFFER 0x8CA9
+#define GL_DEPTH_ATTACHMENT 0x8D00
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#endif
+
+class GLExtensions
+{
+public:
+    typedef void(APIENTRY *GenQueriesProc)(GLsizei n, GLuint *ids);
+    typedef void(APIENTRY *DeleteQueriesProc)(GLsizei n, const GLuint *ids);
+    typedef void(APIENTRY *QueryCounterProc)(GLuint id, GLenum target);
+    typedef void(APIENTRY *GetQueryObjectivProc)(GLuint id, GLenum pname, GLint *params);
+    typedef void(APIENTRY *GetQueryObjectui64vProc)(GLuint id, GLenum pname, uint64_t *params);
+
+    typedef GLuint(APIENTRY *CreateShaderProc)(GLenum type);
+    typedef void(APIENTRY *ShaderSourceProc)(GLuint shader, GLsizei count, const GLchar *const *strings,
+                                             const GLint *lengths);
+    typedef void(APIENTRY *CompileShaderProc)(GLuint shader);
+    typedef void(APIENTRY *GetShaderivProc)(GLuint shader, GLenum pname, GLint *params);
+    typedef void(APIENTRY *GetShaderInfoLogProc)(GLuint shader, GLsizei size, GLsizei *length, GLchar *log);
+    typedef void(APIENTRY *DeleteShaderProc)(GLuint shader);
+    typedef GLuint(APIENTRY *CreateProgramProc)();
+    typedef void(APIENTRY *AttachShaderProc)(GLuint program, GLuint shader);
+    typedef void(APIENTRY *LinkProgramProc)(GLuint program);
+    typedef void(APIENTRY *GetProgramivProc)(GLuint program, GLenum pname, GLint *params);
+    typedef void(APIENTRY *GetProgramInfoLogProc)(GLuint program, GLsizei size, GLsizei *length, GLchar *log);
+    typedef void(APIENTRY *UseProgramProc)(GLuint program);
+    typedef GLint(APIENTRY *GetUniformLocationProc)(GLuint program, const GLchar *name);
+    typedef void(APIENTRY *Uniform1iProc)(GLint location, GLint value);
+    typedef void(APIENTRY *Uniform1fProc)(GLint location, GLfloat value);
+    typedef void(APIENTRY *UniformMatrix3fvProc)(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value);
+    typedef GLint(APIENTRY *GetAttribLocationProc)(GLuint program, const GLchar *name);
+    typedef void(APIENTRY *VertexAttribPointerProc)(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                                    GLsizei stride, const void *pointer);
+    typedef void(APIENTRY *EnableVertexAttribArrayProc)(GLuint index);
+    typedef void(APIENTRY *DisableVertexAttribArrayProc)(GLuint index);
+    typedef void(APIENTRY *ActiveTextureProc)(GLenum texture);
+
+    typedef void(APIENTRY *GenBuffersProc)(GLsizei n, GLuint *buffers);
+    typedef void(APIENTRY *BindBufferProc)(GLenum target, GLuint buffer);
+    typedef void(APIENTRY *BufferDataProc)(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
+    typedef void(APIENTRY *BufferSubDataProc)(GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
+    typedef GLuint(APIENTRY *GetUniformBlockIndexProc)(GLuint program, const GLchar *name);
+    typedef void(APIENTRY *UniformBlockBindingProc)(GLuint program, GLuint index, GLuint binding);
+    typedef void(APIENTRY *BindBufferBaseProc)(GLenum target, GLuint index, GLuint buffer);
+
+    typedef void(APIENTRY *GenFramebuffersProc)(GLsizei n, GLuint *framebuffers);
+    typedef void(APIENTRY *BindFramebufferProc)(GLenum target, GLuint framebuffer);
+    typedef void(APIENTRY *FramebufferTexture2DProc)(GLenum target, GLenum attachment, GLenum textureTarget,
+                                                     GLuint texture, GLint level);
+    typedef GLenum(APIENTRY *CheckFramebufferStatusProc)(GLenum target);
+    typedef void(APIENTRY *BlitFramebufferProc)(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0,
+                                                GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter);
+
+    typedef void(APIENTRY *CompressedTexImage2DProc)(GLenum target, GLint level, GLenum format, GLsizei width,
+                                                     GLsizei height, GLint border, GLsizei size, const void *data);
+
+    static void load();
+
+    // True if the driver lists the extension
+    static bool hasExtension(const char *name);
+
+    // GL 3.3 / ARB_timer_query
+    static bool hasTimerQuery;
+    static GenQueriesProc genQueries;
+    static DeleteQueriesProc deleteQueries;
+    static QueryCounterProc queryCounter;
+    static GetQueryObjectivProc getQueryObjectiv;
+    static GetQueryObjectui64vProc getQueryObjectui64v;
+
+    // GL 2.0 shaders
+    static bool hasShaders;
+    static CreateShaderProc createShader;
+    static ShaderSourceProc shaderSource;
+    static CompileShaderProc compileShader;
+    static GetShaderivProc getShaderiv;
+    static GetShaderInfoLogProc getShaderInfoLog;
+    static DeleteShaderProc deleteShader;
+    static CreateProgramProc createProgram;
+    static AttachShaderProc attachShader;
+    static LinkProgramProc linkProgram;
+    static GetProgramivProc getProgramiv;
+    static GetProgramInfoLogProc getProgramInfoLog;
+    static UseProgramProc useProgram;
+    static GetUniformLocationProc getUniformLocation;
+    static Uniform1iProc uniform1i;
+    static Uniform1fProc uniform1f;
+    static UniformMatrix3fvProc uniformMatrix3fv;
+    static GetAttribLocationProc getAttribLocation;
+    static VertexAttribPointerProc vertexAttribPointer;
+    static EnableVertexAttribArrayProc enableVertexAttribArray;
+    static DisableVertexAttribArrayProc disableVertexAttribArray;
+    static ActiveTextureProc activeTexture; // GL 1.3, but only shaders sample more than one unit
+
+    // GL 1.5 buffer objects, for vertex and index buffers
+    static bool hasBufferObjects;
+    static GenBuffersProc genBuffers;
+    static BindBufferProc bindBuffer;
+    static BufferDataProc bufferData;
+    static BufferSubDataProc bufferSubData;
+
+    // GL 3.1 / ARB_uniform_buffer_object, on top of the buffer objects
+    static bool hasUniformBuffers;
+    static GetUniformBlockIndexProc getUniformBlockIndex;
+    static UniformBlockBindingProc uniformBlockBinding;
+    static BindBufferBaseProc bindBufferBase;
+
+    // GL 3.0 / ARB_framebuffer_object
+    static bool hasFramebuffers;
+    static GenFramebuffersProc genFramebuffers;
+    static BindFramebufferProc bindFramebuffer;
+    static FramebufferTexture2DProc framebufferTexture2D;
+    static CheckFramebufferStatusProc checkFramebufferStatus;
+    static BlitFramebufferProc blitFramebuffer;
+
+    // GL 1.3 compressed textures; S3TC is BC1-3, RGTC is BC4-5
+    static bool hasS3TC;
+    static bool hasRGTC;
+    static CompressedTexImage2DProc compressedTexImage2D;
+
+private:
+    static bool loaded;
+};
+
+#endif
@@ -6,7 +6,9 @@
 // GLTexture.cpp: implementation of the GLTexture class.
 // This class loads a texture file and prepares it
 // to be used in OpenGL. It can open a bitmap or a
-// targa file. The min filter is set to mipmap b/c
+// targa file (or a png or jpeg through ImageDecoder). A cooked .dds
+// of the same name (tools/TextureCooker.cpp) is used instead when it
+// exists: its mips are streamed in as they are (TextureStreamer). The min filter is set to mipmap b/c
 // they look better and the performance cost on
 // modern video cards in negligible. I leave all of
 // the texture management to the application. I have
@@ -35,11 +37,20 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "GLTexture.h"
+#include "ImageDecoder.h"
+#include "PixelConvert.h"
+#include "Profiler.h"
+#include "TextureStreamer.h"
+
+#ifdef _WIN32
+#include <windows.h> // Resource loading
+#endif
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <vector>
 
 // Cross-platform helper: duplicate a string
 static char *str_dup(const char *str)
@@ -109,56 +120,38 @@ static AUX_RGBImageRec *auxDIBImageLoad(const char *filename)
 	int rowSize = ((width * 3 + 3) / 4) * 4;
 	int imageSize = rowSize * height;
 
-	// Allocate memory for image data
-	unsigned char *rawData = (unsigned char *)malloc(imageSize);
-	if (!rawData)
-	{
-		fclose(file);
-		return NULL;
-	}
-
-	// Seek to pixel data and read
-	fseek(file, dataOffset, SEEK_SET);
-	if (fread(rawData, 1, imageSize, file) != (size_t)imageSize)
-	{
-		free(rawData);
-		fclose(file);
-		return NULL;
-	}
-	fclose(file);
-
 	// Create the result structure
 	AUX_RGBImageRec *result = (AUX_RGBImageRec *)malloc(sizeof(AUX_RGBImageRec));
 	if (!result)
 	{
-		free(rawData);
+		fclose(file);
 		return NULL;
 	}
 
+	// Read the padded rows straight into the result, they're packed in place below
 	result->sizeX = width;
 	result->sizeY = height;
-	result->data = (unsigned char *)malloc(width * height * 3);
+	result->data = (unsigned char *)malloc(imageSize);
 	if (!result->data)
 	{
-		free(rawData);
 		free(result);
+		fclose(file);
 		return NULL;
 	}
 
-	// Convert BGR to RGB and remove padding
-	for (int y = 0; y < height; y++)
+	// Seek to pixel data and read
+	fseek(file, dataOffset, SEEK_SET);
+	if (fread(result->data, 1, imageSize, file) != (size_t)imageSize)
 	{
-		for (int x = 0; x < width; x++)
-		{
-			int srcIdx = y * rowSize + x * 3;
-			int dstIdx = y * width * 3 + x * 3;
-			result->data[dstIdx + 0] = rawData[srcIdx + 2]; // R
-			result->data[dstIdx + 1] = rawData[srcIdx + 1]; // G
-			result->data[dstIdx + 2] = rawData[srcIdx + 0]; // B
-		}
+		free(result->data);
+		free(result);
+		fclose(file);
+		return NULL;
 	}
+	fclose(file);
 
-	free(rawData);
+	// Convert BGR to RGB and remove padding
+	PixelConvert::swapRedBlueRows(result->data, rowSize, result->data, width, height, 3, false);
 	return result;
 }
 
@@ -168,6 +161,8 @@ static AUX_RGBImageRec *auxDIBImageLoad(const char *filename)
 
 GLTexture::GLTexture()
 {
+	texture[0] = 0;
+	paletted = false;
 }
 
 GLTexture::~GLTexture()
@@ -176,6 +171,8 @@ GLTexture::~GLTexture()
 
 void GLTexture::Load(char *name)
 {
+	PROFILE_ZONE("GLTexture::Load");
+
 	// make the texture name all lower case
 	texturename = str_to_lower(str_dup(name));
 
@@ -183,11 +180,24 @@ void GLTexture::Load(char *name)
 	if (strstr(texturename, "\""))
 		texturename = strtok(texturename, "\"");
 
+	// a cooked texture skips decoding and mipmapping on the CPU
+	const char *dot = strrchr(texturename, '.');
+	if (dot)
+	{
+		std::vector<char> cooked(dot - texturename + 5);
+		memcpy(&cooked[0], texturename, dot - texturename);
+		memcpy(&cooked[dot - texturename], ".dds", 5);
+		if (LoadDDS(&cooked[0]))
+			return;
+	}
+
 	// check the file extension to see what type of texture
 	if (strstr(texturename, ".bmp"))
 		LoadBMP(texturename);
 	if (strstr(texturename, ".tga"))
 		LoadTGA(texturename);
+	if (strstr(texturename, ".png") || strstr(texturename, ".jpg") || strstr(texturename, ".jpeg"))
+		LoadImage(texturename);
 }
 
 void GLTexture::LoadFromResource(char *name)
@@ -225,18 +235,8 @@ void GLTexture::LoadBMP(char *name)
 		return;
 	}
 
-	// Skip textures that are too large - they cause OpenGL issues
-	if (TextureImage[0]->sizeX > 1024 || TextureImage[0]->sizeY > 1024)
-	{
-		// Free the large image
-		if (TextureImage[0]->data)
-			free(TextureImage[0]->data);
-		free(TextureImage[0]);
-
-		// Build a simple colored texture as placeholder
-		BuildColorTexture(128, 128, 128);
-		return;
-	}
+	// gluBuild2DMipmaps scales images past GL_MAX_TEXTURE_SIZE down itself.
+	// Large textures are better cooked to a .dds, which is streamed.
 
 	// Just in case we want to use the width and height later
 	width = TextureImage[0]->sizeX;
@@ -265,6 +265,61 @@ void GLTexture::LoadBMP(char *name)
 	}
 }
 
+void GLTexture::LoadImage(char *name)
+{
+	DecodedImage image;
+	if (!ImageDecoder::load(name, image))
+		return;
+
+	width = image.width;
+	height = image.height;
+
+	// Files are stored top row first, bitmaps and targas bottom row first.
+	// Flip so texture coordinates mean the same thing for every format.
+	size_t rowSize = (size_t)width * image.channels;
+	std::vector<unsigned char> row(rowSize);
+	for (int y = 0; y < height / 2; y++)
+	{
+		unsigned char *top = &image.pixels[y * rowSize];
+		unsigned char *bottom = &image.pixels[(height - 1 - y) * rowSize];
+		memcpy(&row[0], top, rowSize);
+		memcpy(top, bottom, rowSize);
+		memcpy(bottom, &row[0], rowSize);
+	}
+
+	static const GLenum FORMATS[5] = {0, GL_LUMINANCE, GL_LUMINANCE_ALPHA, GL_RGB, GL_RGBA};
+	GLenum format = FORMATS[image.channels];
+
+	// Generate the OpenGL texture id
+	glGenTextures(1, &texture[0]);
+
+	// Bind this texture to its id
+	glBindTexture(GL_TEXTURE_2D, texture[0]);
+
+	// Use mipmapping filter
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Rows of gray or RGB images are not always a multiple of 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	// Generate the mipmaps
+	gluBuild2DMipmaps(GL_TEXTURE_2D, image.channels, width, height, format, GL_UNSIGNED_BYTE, &image.pixels[0]);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+bool GLTexture::LoadDDS(char *name)
+{
+	// Only the small mips are uploaded now, TextureStreamer adds the rest as it's drawn
+	GLuint streamed = TextureStreamer::open(name, width, height);
+	if (streamed == 0)
+		return false;
+
+	texture[0] = streamed;
+	return true;
+}
+
 void GLTexture::LoadTGA(char *name)
 {
 	GLubyte TGAheader[12] = {0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0}; // Uncompressed TGA header
@@ -272,7 +327,6 @@ void GLTexture::LoadTGA(char *name)
 	GLubyte header[6];											  // First 6 useful bytes of the header
 	GLuint bytesPerPixel;										  // Holds the number of bytes per pixel used
 	GLuint imageSize;											  // Used to store the image size
-	GLuint temp;												  // Temporary variable
 	GLuint type = GL_RGBA;										  // Set the default type to RBGA (32 BPP)
 	GLubyte *imageData;											  // Image data (up to 32 Bits)
 	GLuint bpp;													  // Image color depth in bits per pixel.
@@ -325,13 +379,8 @@ void GLTexture::LoadTGA(char *name)
 		return;
 	}
 
-	// Loop through the image data and swap the 1st and 3rd bytes (red and blue)
-	for (GLuint i = 0; i < int(imageSize); i += bytesPerPixel)
-	{
-		temp = imageData[i];
-		imageData[i] = imageData[i + 2];
-		imageData[i + 2] = temp;
-	}
+	// Swap red and blue, and flip images stored top row first (descriptor bit 5)
+	PixelConvert::swapRedBlueRows(imageData, width * bytesPerPixel, imageData, width, height, bytesPerPixel, (header[5] & 0x20) != 0);
 
 	// We are done with the file so close it
 	fclose(file);
@@ -357,6 +406,7 @@ void GLTexture::LoadTGA(char *name)
 	free(imageData);
 }
 
+#ifdef _WIN32
 void GLTexture::LoadBMPResource(char *name)
 {
 	// Find the bitmap in the bitmap resources
@@ -425,7 +475,6 @@ void GLTexture::LoadTGAResource(char *name)
 	GLubyte TGAheader[12] = {0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0}; // Uncompressed TGA header
 	GLuint bytesPerPixel;										  // Holds the number of bytes per pixel used
 	GLuint imageSize;											  // Used to store the image size
-	GLuint temp;												  // Temporary variable
 	GLuint type = GL_RGBA;										  // Set the default type to RBGA (32 BPP)
 	GLubyte *imageData;											  // Image data (up to 32 Bits)
 	GLuint bpp;													  // Image color depth in bits per pixel.
@@ -477,13 +526,8 @@ void GLTexture::LoadTGAResource(char *name)
 	// Load the data in
 	memcpy(imageData, (GLubyte *)buffer + 18, imageSize);
 
-	// Loop through the image data and swap the 1st and 3rd bytes (red and blue)
-	for (GLuint i = 0; i < int(imageSize); i += bytesPerPixel)
-	{
-		temp = imageData[i];
-		imageData[i] = imageData[i + 2];
-		imageData[i + 2] = temp;
-	}
+	// Swap red and blue, and flip images stored top row first (descriptor bit 5)
+	PixelConvert::swapRedBlueRows(imageData, width * bytesPerPixel, imageData, width, height, bytesPerPixel, (top->header[5] & 0x20) != 0);
 
 	// Set the type
 	if (bpp == 24)
@@ -508,6 +552,21 @@ void GLTexture::LoadTGAResource(char *name)
 	free(top);
 }
 
+#else
+
+// Executable resources only exist on Windows
+void GLTexture::LoadBMPResource(char *name)
+{
+	(void)name;
+}
+
+void GLTexture::LoadTGAResource(char *name)
+{
+	(void)name;
+}
+
+#endif
+
 void GLTexture::BuildColorTexture(unsigned char r, unsigned char g, unsigned char b)
 {
 	unsigned char data[12]; // a 2x2 texture at 24 bits
@@ -534,4 +593,53 @@ void GLTexture::BuildColorTexture(unsigned char r, unsigned char g, unsigned cha
 
 	// Generate the texture
 	gluBuild2DMipmaps(GL_TEXTURE_2D, 3, 2, 2, GL_RGB, GL_UNSIGNED_BYTE, data);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+// The palette shared by BuildPaletteColor, one texel per distinct color
+static const int PALETTE_SIZE = 64;
+static GLuint paletteTexture = 0;
+static std::vector<unsigned int> paletteColors; // 0xRRGGBB, in texel order
+
+void GLTexture::BuildPaletteColor(unsigned char r, unsigned char g, unsigned char b)
+{
+	unsigned int color = r << 16 | g << 8 | b;
+	size_t index = 0;
+	while (index < paletteColors.size() && paletteColors[index] != color)
+		index++;
+
+	if (index == paletteColors.size())
+	{
+		// A full palette falls back to a texture of its own
+		if (index == PALETTE_SIZE * PALETTE_SIZE)
+		{
+			BuildColorTexture(r, g, b);
+			return;
+		}
+
+		if (paletteTexture == 0)
+		{
+			std::vector<unsigned char> black(PALETTE_SIZE * PALETTE_SIZE * 3);
+			glGenTextures(1, &paletteTexture);
+			glBindTexture(GL_TEXTURE_2D, paletteTexture);
+
+			// No filtering or mips, so a color never bleeds into its neighbours
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, PALETTE_SIZE, PALETTE_SIZE, 0, GL_RGB, GL_UNSIGNED_BYTE, &black[0]);
+		}
+
+		unsigned char texel[3] = {r, g, b};
+		glBindTexture(GL_TEXTURE_2D, paletteTexture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, (GLint)(index % PALETTE_SIZE), (GLint)(index / PALETTE_SIZE), 1, 1, GL_RGB, GL_UNSIGNED_BYTE, texel);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		paletteColors.push_back(color);
+	}
+
+	texture[0] = paletteTexture;
+	paletted = true;
+	paletteCoord[0] = (index % PALETTE_SIZE + 0.5f) / PALETTE_SIZE;
+	paletteCoord[1] = (index / PALETTE_SIZE + 0.5f) / PALETTE_SIZE;
 }
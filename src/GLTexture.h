@@ -6,7 +6,9 @@
 // GLTexture.h: interface for the GLTexture class.
 // This class loads a texture file and prepares it
 // to be used in OpenGL. It can open a bitmap or a
-// targa file. The min filter is set to mipmap b/c
+// targa file (or a png or jpeg through ImageDecoder). A cooked .dds
+// of the same name (tools/TextureCooker.cpp) is used instead when it
+// exists: its mips are uploaded as they are. The min filter is set to mipmap b/c
 // they look better and the performance cost on
 // modern video cards in negligible. I leave all of
 // the texture management to the application. I have
@@ -32,12 +34,15 @@
 // tex3.BuildColorTexture(255, 0, 0);	// Builds a solid red texture
 // tex3.Use();				 // Binds the targa for use
 //
+// // Or share one texture between many colors, one texel each.
+// // Draw with glTexCoord2fv(tex4.paletteCoord) instead of texcoords.
+// tex4.BuildPaletteColor(255, 0, 0);
+//
 //////////////////////////////////////////////////////////////////////
 
 #ifndef GLTEXTURE_H
 #define GLTEXTURE_H
 
-#include <windows.h> // Header File For Windows
 #include <GL/glut.h>
 
 class GLTexture
@@ -47,13 +52,18 @@ public:
 	unsigned int texture[1];												   // OpenGL's number for the texture
 	int width;																   // Texture's width
 	int height;																   // Texture's height
+	bool paletted;															   // True: texture[0] is the shared color palette
+	float paletteCoord[2];													   // Where this texture's color is in the palette
 	void Use();																   // Binds the texture for use
 	void BuildColorTexture(unsigned char r, unsigned char g, unsigned char b); // Sometimes we want a texture of uniform color
+	void BuildPaletteColor(unsigned char r, unsigned char g, unsigned char b); // A uniform color as one texel of the shared palette
 	void LoadTGAResource(char *name);										   // Load a targa from the resources
 	void LoadBMPResource(char *name);										   // Load a bitmap from the resources
 	void LoadFromResource(char *name);										   // Load the texture from a resource
 	void LoadTGA(char *name);												   // Loads a targa file
 	void LoadBMP(char *name);												   // Loads a bitmap file
+	void LoadImage(char *name);												   // Loads a png or jpeg file
+	bool LoadDDS(char *name);												   // Loads a cooked, block compressed dds file
 	void Load(char *name);													   // Load the texture
 	GLTexture();															   // Constructor
 	virtual ~GLTexture();													   // Destructor
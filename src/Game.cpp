@@ -1,10 +1,18 @@
 #include "Game.h"
 #include "Level1.h"
 #include "Level2.h"
+#include "Lighting.h"
+#include "PbrShading.h"
+#include "Platform.h"
+#include "Profiler.h"
+#include "Shadows.h"
+#include "TextureStreamer.h"
+#include "TraceWriter.h"
+#include "Transparency.h"
+#include <chrono>
 #include <cmath>
+#include <cstdio>
 #include <iostream>
-#include <mmsystem.h>
-#pragma comment(lib, "winmm.lib")
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -17,13 +25,56 @@ Game::Game()
     cameraDistance = 8.0f; // Increased distance for larger 3D model
     cameraHeight = 4.0f;   // Raised camera for better view
     dayTime = 0.5f;        // Noon
+    sunPosition[0] = sunPosition[2] = 0.0f;
+    sunPosition[1] = 100.0f;
     currentLevel = nullptr;
+    tick = 0;
+    audioOutput = nullptr;
+    engineVoice = 0;
+    simRunning = false;
+    jobs = nullptr;
+    workerCount = -1;
+    shaderLighting = true;
+    view = &snapshots.readBuffer();
+    viewLevel = nullptr;
+    level1Data = LevelData::defaultRoad();
+    level2Data = LevelData::defaultParking();
+    setSeed(0);
 }
 
 Game::~Game()
 {
+    shutdown();
     if (currentLevel)
         delete currentLevel;
+    delete jobs;
+}
+
+void Game::shutdown()
+{
+    stopSimulation();
+    journal.finishRecording(tick);
+    audio.stop();
+    delete audioOutput; // Only set if init() never ran
+    audioOutput = nullptr;
+#if EGYPT_PROFILE
+    TraceWriter::get().stop();
+#endif
+}
+
+bool Game::recordInput(const char *path)
+{
+    return journal.startRecording(path, seed);
+}
+
+bool Game::replayInput(const char *path)
+{
+    if (!journal.openReplay(path))
+        return false;
+
+    // The journal's seed wins so traffic matches the recording
+    setSeed(journal.getSeed());
+    return true;
 }
 
 void Game::init()
@@ -33,20 +84,49 @@ void Game::init()
     glEnable(GL_LIGHT0);
     glEnable(GL_NORMALIZE);
     glEnable(GL_COLOR_MATERIAL);
+    if (shaderLighting && Lighting::init())
+    {
+        PbrShading::init();
+        Shadows::init();
+    }
+    Lighting::enable();
+
+    initSimulation();
+
+    // Models live on the render-side copies, the simulation never loads any
+    viewLevel1.setJobSystem(jobs);
+    viewCar.init();
+    viewLevel1.loadAssets();
+    viewLevel2.loadAssets();
+}
+
+void Game::initSimulation()
+{
+    loadLevels();
+
+    jobs = new JobSystem(workerCount);
+    printf("Job system: %d worker threads\n", jobs->getWorkerCount());
 
-    // Load 3D car model
-    playerCar.init();
     playerCar.reset(0, 0);
+
+    audio.start(audioOutput ? audioOutput : Platform::createAudioOutput());
+    audioOutput = nullptr;
 }
 
 void Game::update()
 {
+    PROFILE_ZONE("Game::update");
+
+    processInput();
+
     if (currentState == LEVEL1)
     {
         if (!currentLevel)
         {
-            currentLevel = new Level1();
-            currentLevel->init();
+            Level1 *level = new Level1();
+            level->setLevelData(level1Data);
+            level->setJobSystem(jobs);
+            startLevel(level);
             playerCar.reset(0, 0);
         }
 
@@ -55,7 +135,7 @@ void Game::update()
 
         if (currentLevel->checkCollisions(playerCar))
         {
-            PlaySound(TEXT("Sounds/crash.wav"), NULL, SND_FILENAME | SND_ASYNC);
+            audio.play(SOUND_CRASH);
             currentState = GAME_OVER;
         }
 
@@ -75,8 +155,9 @@ void Game::update()
     {
         if (!currentLevel)
         {
-            currentLevel = new Level2();
-            currentLevel->init();
+            Level2 *level = new Level2();
+            level->setLevelData(level2Data);
+            startLevel(level);
             playerCar.reset(0, 0); // Start at 0,0 for parking
         }
 
@@ -85,7 +166,7 @@ void Game::update()
 
         if (currentLevel->checkCollisions(playerCar))
         {
-            PlaySound(TEXT("Sounds/crash.wav"), NULL, SND_FILENAME | SND_ASYNC);
+            audio.play(SOUND_CRASH);
             currentState = GAME_OVER;
         }
 
@@ -94,16 +175,158 @@ void Game::update()
             currentState = WIN; // Parked!
         }
     }
-    glutPostRedisplay();
+
+    updateAudio();
+
+    tick++;
+    if (journal.isReplaying() && journal.isReplayFinished(tick))
+    {
+        printf("Replay finished at tick %u\n", tick);
+        fflush(stdout);
+        journal.stopReplay();
+    }
+
+    publishSnapshot();
+}
+
+// Compiled levels are optional, without them the built-in layouts are used
+void Game::loadLevels()
+{
+    const char *paths[2] = {"Levels/level1.lvb", "Levels/level2.lvb"};
+    LevelData *data[2] = {&level1Data, &level2Data};
+    const uint32_t kinds[2] = {LEVEL_ROAD, LEVEL_PARKING};
+
+    for (int i = 0; i < 2; i++)
+    {
+        LevelData loaded;
+        if (!loaded.load(paths[i]))
+            continue;
+        if (loaded.kind != kinds[i])
+        {
+            printf("Warning: %s is the wrong kind of level, using the built-in one\n", paths[i]);
+            continue;
+        }
+        *data[i] = loaded;
+        printf("Level: %s (%u colliders)\n", paths[i], (unsigned)loaded.colliders.size());
+    }
+    fflush(stdout);
+
+    viewLevel1.setLevelData(level1Data);
+    viewLevel2.setLevelData(level2Data);
+}
+
+void Game::startSimulation()
+{
+    if (simRunning)
+        return;
+    simRunning = true;
+    simThread = std::thread(&Game::simulationLoop, this);
+}
+
+void Game::stopSimulation()
+{
+    simRunning = false;
+    if (simThread.joinable())
+        simThread.join();
+}
+
+void Game::simulationLoop()
+{
+    const uint64_t TICK_NS = 16000000; // Same 16 ms step the GLUT timer used
+    uint64_t next = Platform::nowNs();
+
+    while (simRunning)
+    {
+        update();
+
+        next += TICK_NS;
+        uint64_t now = Platform::nowNs();
+        if (next > now)
+            std::this_thread::sleep_for(std::chrono::nanoseconds(next - now));
+        else if (now - next > 5 * TICK_NS)
+            next = now; // Fell far behind (debugger, suspend), don't try to catch up
+    }
+}
+
+void Game::publishSnapshot()
+{
+    GameSnapshot &snapshot = snapshots.writeBuffer();
+    snapshot.tick = tick;
+    snapshot.state = currentState;
+    snapshot.car = playerCar.getState();
+    snapshot.level = 0;
+    if (currentLevel)
+        currentLevel->capture(snapshot);
+    snapshot.dayTime = dayTime;
+    snapshot.isThirdPerson = isThirdPerson;
+    snapshots.publish();
+}
+
+void Game::applySnapshot(const GameSnapshot &snapshot)
+{
+    view = &snapshot;
+    viewCar.setState(snapshot.car);
+
+    Level *previousLevel = viewLevel;
+    viewLevel = nullptr;
+    if (snapshot.level == 1)
+    {
+        viewLevel1.apply(snapshot);
+        viewLevel = &viewLevel1;
+    }
+    else if (snapshot.level == 2)
+    {
+        viewLevel2.apply(snapshot);
+        viewLevel = &viewLevel2;
+    }
+    if (viewLevel != previousLevel)
+        Shadows::invalidate();
+}
+
+void Game::updateAudio()
+{
+    if (currentLevel)
+    {
+        for (int n = currentLevel->takePickups(); n > 0; n--)
+            audio.play(SOUND_PICKUP);
+    }
+
+    bool driving = currentState == LEVEL1 || currentState == LEVEL2;
+    if (!driving)
+    {
+        audio.stopVoice(engineVoice);
+        engineVoice = 0;
+        return;
+    }
+
+    if (!engineVoice)
+        engineVoice = audio.play(SOUND_ENGINE, 0.5f, 0.7f, true);
+
+    // Idle at 0.7x, about 2x at top speed and higher still with a boost
+    float rev = std::abs(playerCar.getSpeed()) / playerCar.getMaxSpeed();
+    audio.setPitch(engineVoice, 0.7f + 1.3f * rev);
+}
+
+void Game::setSeed(uint64_t newSeed)
+{
+    seed = newSeed;
+    levelSeeds.seed(newSeed);
+}
+
+void Game::startLevel(Level *level)
+{
+    currentLevel = level;
+    currentLevel->setSeed(levelSeeds.split());
+    currentLevel->init();
 }
 
 void Game::setCamera()
 {
-    float carX = playerCar.getX();
-    float carZ = playerCar.getZ();
-    float carRot = playerCar.getRotation() * M_PI / 180.0f;
+    float carX = viewCar.getX();
+    float carZ = viewCar.getZ();
+    float carRot = viewCar.getRotation() * M_PI / 180.0f;
 
-    if (isThirdPerson)
+    if (view->isThirdPerson)
     {
         // Camera behind and above
         float camX = carX - sin(carRot) * cameraDistance;
@@ -134,7 +357,7 @@ void Game::setupLights()
     // range -1 to 1.
     // brightness = ( -cos(dayTime * 2 * M_PI) + 1.0 ) / 2.0;
 
-    float brightness = (-cos(dayTime * 2 * M_PI) + 1.0f) / 2.0f;
+    float brightness = (-cos(view->dayTime * 2 * M_PI) + 1.0f) / 2.0f;
 
     // Interpolate Sky Color
     // Night: 0.0, 0.0, 0.1
@@ -155,8 +378,16 @@ void Game::setupLights()
     // sin(0) = 0, cos(0) = 1.
     // We want Y to be -100 at 0.0, 100 at 0.5.
     // -cos(0) = -1. -cos(pi) = 1.
-    lightPos[0] = sin(dayTime * 2 * M_PI) * 100.0f;
-    lightPos[1] = -cos(dayTime * 2 * M_PI) * 100.0f;
+    lightPos[0] = sin(view->dayTime * 2 * M_PI) * 100.0f;
+    lightPos[1] = -cos(view->dayTime * 2 * M_PI) * 100.0f;
+    for (int c = 0; c < 3; c++)
+        sunPosition[c] = lightPos[c];
+
+    if (Lighting::isActive())
+    {
+        Lighting::beginFrame(lightPos, ambient, diffuse);
+        return;
+    }
 
     GLfloat lightAmb[] = {ambient, ambient, ambient, 1.0f};
     GLfloat lightDif[] = {diffuse, diffuse, diffuse, 1.0f};
@@ -168,22 +399,34 @@ void Game::setupLights()
 
 void Game::render()
 {
+    PROFILE_FRAME_BEGIN();
+    if (snapshots.acquire())
+        applySnapshot(snapshots.readBuffer());
+    drawFrame();
+    glutSwapBuffers();
+    PROFILE_FRAME_END();
+}
+
+void Game::drawFrame()
+{
+    PROFILE_GPU_ZONE("Game::render");
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glLoadIdentity();
 
-    if (currentState == MENU)
+    if (view->state == MENU)
     {
         drawMenu();
     }
-    else if (currentState == GAME_OVER)
+    else if (view->state == GAME_OVER)
     {
         drawGameOver();
     }
-    else if (currentState == LEVEL1_WIN)
+    else if (view->state == LEVEL1_WIN)
     {
         drawLevel1Win();
     }
-    else if (currentState == WIN)
+    else if (view->state == WIN)
     {
         drawWin();
     }
@@ -192,47 +435,200 @@ void Game::render()
         setCamera();
         setupLights();
 
-        // Draw Ground
-        glColor3f(0.9f, 0.8f, 0.6f); // Sand
-        // Draw Ground (Tessellated for lighting)
-        glColor3f(0.9f, 0.8f, 0.6f); // Sand
-        glNormal3f(0, 1, 0);
+        // Calculate brightness again for logic (or store it)
+        float brightness = (-cos(view->dayTime * 2 * M_PI) + 1.0f) / 2.0f;
+        bool isNight = (brightness < 0.3f); // Turn on lights when it gets dark enough
 
-        float groundSize = 200.0f;
-        float tileSize = 2.0f; // Smaller tiles for better lighting
+        if (viewLevel)
+            viewLevel->prepareFrame(viewCar);
 
-        glBegin(GL_QUADS);
-        for (float x = -groundSize / 2; x < groundSize / 2; x += tileSize)
+        // The shader path takes every light of the frame before anything is drawn
+        if (Lighting::isActive())
         {
-            for (float z = -groundSize / 2; z < groundSize / 2; z += tileSize)
-            {
-                glVertex3f(x, 0, z);
-                glVertex3f(x + tileSize, 0, z);
-                glVertex3f(x + tileSize, 0, z + tileSize);
-                glVertex3f(x, 0, z + tileSize);
-            }
+            if (viewLevel)
+                viewLevel->addLights(viewCar, isNight);
+            viewCar.addLights();
+            drawShadows();
+            Lighting::upload();
         }
-        glEnd();
 
-        if (currentLevel)
+        drawGround();
+
+        if (viewLevel)
+            viewLevel->render(viewCar, isNight);
+        viewCar.draw();
+        Transparency::draw(); // The light beams queued by the level and the car
+    }
+
+    drawHUD();
+    drawProfilerOverlay();
+
+    // Mips for what was just drawn, ready from the next frame
+    TextureStreamer::update();
+}
+
+// Shadow maps for the sun and the headlights, between the lights being set
+// and uploaded. Buildings and lamps are redrawn only when Shadows' cache of
+// them goes stale, the cars every frame.
+void Game::drawShadows()
+{
+    if (!Shadows::isActive())
+        return;
+    PROFILE_GPU_ZONE("Game::drawShadows");
+
+    if (Shadows::beginSun(sunPosition, viewCar.getX(), viewCar.getZ()))
+    {
+        for (int c = 0; c < Lighting::SUN_CASCADES && Shadows::isStaticStale(); c++)
         {
-            // Calculate brightness again for logic (or store it)
-            float brightness = (-cos(dayTime * 2 * M_PI) + 1.0f) / 2.0f;
-            bool isNight = (brightness < 0.3f); // Turn on lights when it gets dark enough
-            currentLevel->render(playerCar, isNight);
+            Shadows::beginCascade(c, true);
+            if (viewLevel)
+                viewLevel->drawShadowCasters(viewCar, true);
+            Shadows::endPass();
+        }
+        for (int c = 0; c < Lighting::SUN_CASCADES; c++)
+        {
+            Shadows::beginCascade(c, false);
+            if (viewLevel)
+                viewLevel->drawShadowCasters(viewCar, false);
+            viewCar.drawShadowCaster();
+            Shadows::endPass();
         }
-        playerCar.draw();
     }
 
-    drawHUD();
-    glutSwapBuffers();
+    // The car's own body is behind its headlights, it would only shadow itself
+    for (int i = 0; i < Lighting::SPOT_SHADOWS && viewCar.isLightsOn(); i++)
+    {
+        Shadows::beginSpot(i, viewCar.getHeadlight(i));
+        if (viewLevel)
+        {
+            viewLevel->drawShadowCasters(viewCar, true);
+            viewLevel->drawShadowCasters(viewCar, false);
+        }
+        Shadows::endPass();
+    }
+
+    Shadows::finish();
+}
+
+void Game::drawGround()
+{
+    PROFILE_GPU_ZONE("Game::drawGround");
+
+    // Draw Ground
+    glColor3f(0.9f, 0.8f, 0.6f); // Sand
+    // Draw Ground (Tessellated for lighting)
+    glColor3f(0.9f, 0.8f, 0.6f); // Sand
+    glNormal3f(0, 1, 0);
+
+    float groundSize = 200.0f;
+    float tileSize = 2.0f; // Smaller tiles for better lighting
+
+    glBegin(GL_QUADS);
+    for (float x = -groundSize / 2; x < groundSize / 2; x += tileSize)
+    {
+        for (float z = -groundSize / 2; z < groundSize / 2; z += tileSize)
+        {
+            glVertex3f(x, 0, z);
+            glVertex3f(x + tileSize, 0, z);
+            glVertex3f(x + tileSize, 0, z + tileSize);
+            glVertex3f(x, 0, z + tileSize);
+        }
+    }
+    glEnd();
 }
 
 void Game::handleInput(unsigned char key, int x, int y)
 {
     if (key == 27)
+    {
+        shutdown();
         exit(0); // ESC
+    }
+
+    queueInput(INPUT_KEY, key);
+}
+
+void Game::handleSpecialInput(int key, int x, int y)
+{
+#if EGYPT_PROFILE
+    // Profiler overlay is a view toggle, it is not part of the journal
+    if (key == GLUT_KEY_F3)
+    {
+        Profiler::get().toggleOverlay();
+        return;
+    }
+#endif
+
+    queueInput(INPUT_SPECIAL_DOWN, key);
+}
+
+void Game::handleSpecialInputUp(int key, int x, int y)
+{
+    queueInput(INPUT_SPECIAL_UP, key);
+}
+
+void Game::handleMouse(int button, int state, int x, int y)
+{
+    if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN)
+        queueInput(INPUT_MOUSE, button);
+}
+
+void Game::queueInput(InputEventType type, int key)
+{
+    InputEvent e;
+    e.tick = 0; // Stamped by the simulation when it applies the event
+    e.type = (uint8_t)type;
+    e.key = (uint8_t)key;
+    if (!inputQueue.push(e))
+        printf("Warning: input queue full, event dropped\n");
+}
+
+void Game::processInput()
+{
+    InputEvent e;
+
+    if (journal.isReplaying())
+    {
+        // Live input is ignored while a journal drives the game
+        while (inputQueue.pop(e))
+        {
+        }
+        while (journal.nextEvent(tick, e))
+            applyInput(e);
+        return;
+    }
+
+    // Events are applied at the start of the tick they are recorded on,
+    // so playback sees exactly the same order relative to the simulation
+    while (inputQueue.pop(e))
+    {
+        e.tick = tick;
+        journal.record(e);
+        applyInput(e);
+    }
+}
+
+void Game::applyInput(const InputEvent &e)
+{
+    switch (e.type)
+    {
+    case INPUT_KEY:
+        applyKey(e.key);
+        break;
+    case INPUT_SPECIAL_DOWN:
+        applySpecialKey(e.key, true);
+        break;
+    case INPUT_SPECIAL_UP:
+        applySpecialKey(e.key, false);
+        break;
+    case INPUT_MOUSE:
+        isThirdPerson = !isThirdPerson;
+        break;
+    }
+}
 
+void Game::applyKey(unsigned char key)
+{
     if (currentState == MENU)
     {
         if (key == 13)
@@ -258,6 +654,9 @@ void Game::handleInput(unsigned char key, int x, int y)
         if (key == 'l' || key == 'L')
             playerCar.toggleLights();
 
+        if (key == 'h' || key == 'H')
+            audio.play(SOUND_HORN);
+
         // Developer Cheat Code: Skip Level 1
         if ((key == 'o' || key == 'O') && currentState == LEVEL1)
         {
@@ -266,61 +665,31 @@ void Game::handleInput(unsigned char key, int x, int y)
     }
 }
 
-void Game::handleSpecialInput(int key, int x, int y)
-{
-    if (currentState == LEVEL1 || currentState == LEVEL2)
-    {
-        switch (key)
-        {
-        case GLUT_KEY_UP:
-            playerCar.accelerate(true);
-            break;
-        case GLUT_KEY_DOWN:
-            playerCar.brake(true);
-            break;
-        case GLUT_KEY_LEFT:
-            playerCar.turnLeft(true);
-            break;
-        case GLUT_KEY_RIGHT:
-            playerCar.turnRight(true);
-            break;
-        }
-    }
-}
-
-void Game::handleSpecialInputUp(int key, int x, int y)
+void Game::applySpecialKey(int key, bool down)
 {
     if (currentState == LEVEL1 || currentState == LEVEL2)
     {
         switch (key)
         {
         case GLUT_KEY_UP:
-            playerCar.accelerate(false);
+            playerCar.accelerate(down);
             break;
         case GLUT_KEY_DOWN:
-            playerCar.brake(false);
+            playerCar.brake(down);
             break;
         case GLUT_KEY_LEFT:
-            playerCar.turnLeft(false);
+            playerCar.turnLeft(down);
             break;
         case GLUT_KEY_RIGHT:
-            playerCar.turnRight(false);
+            playerCar.turnRight(down);
             break;
         }
     }
 }
 
-void Game::handleMouse(int button, int state, int x, int y)
-{
-    if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN)
-    {
-        isThirdPerson = !isThirdPerson;
-    }
-}
-
 void Game::drawText(float x, float y, std::string text)
 {
-    glDisable(GL_LIGHTING);
+    Lighting::disable();
     glMatrixMode(GL_PROJECTION);
     glPushMatrix();
     glLoadIdentity();
@@ -340,7 +709,7 @@ void Game::drawText(float x, float y, std::string text)
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
     glMatrixMode(GL_MODELVIEW);
-    glEnable(GL_LIGHTING);
+    Lighting::enable();
 }
 
 void Game::drawMenu()
@@ -373,27 +742,71 @@ void Game::drawWin()
 
 void Game::drawHUD()
 {
-    if (currentState != MENU)
+    if (view->state != MENU)
     {
-        std::string mode = isThirdPerson ? "3rd Person" : "1st Person";
+        std::string mode = view->isThirdPerson ? "3rd Person" : "1st Person";
         drawText(10, 580, "Camera: " + mode + " (Click to toggle)");
-        drawText(10, 550, "Controls: Arrows to Move, L for Lights");
+        drawText(10, 550, "Controls: Arrows to Move, L for Lights, F3 for Profiler");
 
-        if (currentState == LEVEL1)
+        if (view->state == LEVEL1)
         {
-            int dist = (int)playerCar.getZ();
+            int dist = (int)viewCar.getZ();
             if (dist < 0)
                 dist = 0;
-            std::string distStr = "Distance: " + std::to_string(dist) + " / 1000 m";
+            std::string distStr = "Distance: " + std::to_string(dist) + " / " +
+                                  std::to_string((int)viewLevel1.getRoad().finishZ) + " m";
             drawText(10, 520, distStr);
         }
-        else if (currentState == LEVEL2)
+        else if (view->state == LEVEL2)
         {
             drawText(10, 520, "Park in the white spot!");
         }
     }
 }
 
+void Game::drawProfilerOverlay()
+{
+#if EGYPT_PROFILE
+    Profiler &profiler = Profiler::get();
+    if (!profiler.isOverlayVisible())
+        return;
+
+    char line[128];
+    float y = 580.0f;
+
+    sprintf(line, "Frame %.1f ms  p50 %.1f  p95 %.1f  p99 %.1f",
+            profiler.getLastFrameMs(), profiler.getFramePercentile(50.0f),
+            profiler.getFramePercentile(95.0f), profiler.getFramePercentile(99.0f));
+    drawText(400, y, line);
+
+    y -= 20.0f;
+    sprintf(line, "Textures %.1f / %.0f MB  %d streaming", TextureStreamer::getResidentBytes() / 1048576.0,
+            TextureStreamer::getBudget() / 1048576.0, TextureStreamer::getPendingCount());
+    drawText(400, y, line);
+
+    for (int i = 0; i < profiler.getStatCount(); i++)
+    {
+        const Profiler::StatInfo &stat = profiler.getStat(i);
+        y -= 20.0f;
+        sprintf(line, "%-28s %d", stat.name, stat.perFrame);
+        drawText(400, y, line);
+    }
+
+    for (int i = 0; i < profiler.getZoneCount() && y > 40.0f; i++)
+    {
+        const Profiler::ZoneInfo &zone = profiler.getZone(i);
+        y -= 20.0f;
+
+        std::string name = std::string(zone.depth > 0 ? zone.depth * 2 : 0, ' ') + zone.name;
+        if (zone.gpu)
+            sprintf(line, "%-28s cpu %5.2f  gpu %5.2f", name.c_str(), zone.cpuMs, zone.gpuMs);
+        else
+            sprintf(line, "%-28s cpu %5.2f", name.c_str(), zone.cpuMs);
+        drawText(400, y, line);
+    }
+#endif
+}
+
 void Game::reshape(int w, int h)
 {
     if (h == 0)
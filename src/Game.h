@@ -3,17 +3,18 @@
 
 #include <GL/glut.h>
 #include <string>
+#include "Audio.h"
 #include "Car.h"
+#include "GameSnapshot.h"
 #include "Level.h"
-
-enum GameState {
-    MENU,
-    LEVEL1,
-    LEVEL1_WIN,
-    LEVEL2,
-    GAME_OVER,
-    WIN
-};
+#include "LevelData.h"
+#include "Random.h"
+#include "InputJournal.h"
+#include "JobSystem.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+#include <atomic>
+#include <thread>
 
 class Game {
 public:
@@ -21,6 +22,11 @@ public:
     ~Game();
 
     void init();
+
+    // Only what update() needs, never OpenGL: for headless runs without a
+    // window. init() calls it.
+    void initSimulation();
+
     void update();
     void render();
     void handleInput(unsigned char key, int x, int y);
@@ -29,10 +35,74 @@ public:
     void handleMouse(int button, int state, int x, int y);
     void reshape(int w, int h);
 
+    // Seed for all level traffic; the same seed replays the same run
+    void setSeed(uint64_t seed);
+    uint64_t getSeed() const { return seed; }
+
+    // Input journal: record live input, or drive the game from a recording
+    bool recordInput(const char *path);
+    bool replayInput(const char *path);
+    bool isReplaying() const { return journal.isReplaying(); }
+    uint32_t getTick() const { return tick; }
+    void shutdown();
+
+    // Replaces the platform sound device, e.g. with a file or null output.
+    // Takes ownership; call before init().
+    void setAudioOutput(AudioOutput *output) { audioOutput = output; }
+
+    // Worker threads for the per-tick parallel loops, -1 picks one per core
+    // and 0 runs them serially; call before init()
+    void setWorkerCount(int count) { workerCount = count; }
+
+    // false keeps the fixed-function lights even where shaders work; call before init()
+    void setShaderLighting(bool enabled) { shaderLighting = enabled; }
+
+    // Runs update() on its own thread at 60 Hz. render() then only draws the
+    // newest snapshot, hasNewFrame() tells the GLUT loop when to redraw.
+    void startSimulation();
+    void stopSimulation();
+    bool hasNewFrame() const { return snapshots.hasNew(); }
+
 private:
     GameState currentState;
     Car playerCar;
     Level* currentLevel;
+
+    // Level descriptions, Levels/*.lvb or the built-in ones
+    LevelData level1Data;
+    LevelData level2Data;
+
+    // Each new level gets its own seed drawn from this stream
+    uint64_t seed;
+    Random levelSeeds;
+
+    // Simulation tick counter and input queued for the next tick.
+    // GLUT callbacks push events, the simulation pops them.
+    uint32_t tick;
+    SpscQueue<InputEvent, 256> inputQueue;
+    InputJournal journal;
+
+    // Simulation thread and the snapshots it hands to the renderer
+    std::thread simThread;
+    std::atomic<bool> simRunning;
+    TripleBuffer<GameSnapshot> snapshots;
+
+    // Shared by the simulation and render threads
+    JobSystem *jobs;
+    int workerCount;
+    bool shaderLighting;
+
+    // Render-side copies rebuilt from each new snapshot, only these touch OpenGL
+    const GameSnapshot *view;
+    Car viewCar;
+    Level1 viewLevel1;
+    Level2 viewLevel2;
+    Level *viewLevel;
+
+    // Sound effects, the engine loop follows the car's speed
+    Audio audio;
+    AudioOutput *audioOutput;
+    uint32_t engineVoice;
     
     // Camera settings
     bool isThirdPerson;
@@ -41,8 +111,10 @@ private:
 
     // Lighting
     float dayTime; // 0.0 to 1.0 representing time of day
+    float sunPosition[3]; // Set by setupLights()
     
     void setupLights();
+    void drawShadows();
     void setCamera();
     void drawText(float x, float y, std::string text);
     void drawMenu();
@@ -50,6 +122,21 @@ private:
     void drawLevel1Win();
     void drawWin();
     void drawHUD();
+    void drawFrame();
+    void drawGround();
+    void drawProfilerOverlay();
+    void startLevel(Level *level);
+    void loadLevels();
+    void simulationLoop();
+    void publishSnapshot();
+    void applySnapshot(const GameSnapshot &snapshot);
+    void updateAudio();
+
+    void queueInput(InputEventType type, int key);
+    void processInput();
+    void applyInput(const InputEvent &e);
+    void applyKey(unsigned char key);
+    void applySpecialKey(int key, bool down);
 };
 
 #endif
@@ -0,0 +1,41 @@
+#ifndef GAME_SNAPSHOT_H
+#define GAME_SNAPSHOT_H
+
+#include "Car.h"
+#include "Level1.h"
+#include "Level2.h"
+#include <stdint.h>
+
+enum GameState {
+    MENU,
+    LEVEL1,
+    LEVEL1_WIN,
+    LEVEL2,
+    GAME_OVER,
+    WIN
+};
+
+// Everything the render thread draws, written by the simulation once per tick.
+// Game keeps three of these in a TripleBuffer so the simulation can fill one
+// while the renderer draws another and neither waits for the other.
+struct GameSnapshot {
+    GameSnapshot() : tick(0), state(MENU), level(0), dayTime(0.5f), isThirdPerson(true) {
+        car.x = car.z = 0.0f;
+        car.rotation = car.speed = car.tiltAngle = 0.0f;
+        car.lightsOn = true;
+    }
+
+    uint32_t tick;
+    GameState state;
+    Car::State car;
+
+    // 0 when no level is running, otherwise which of the states below is valid
+    int level;
+    Level1State level1;
+    Level2State level2;
+
+    float dayTime;
+    bool isThirdPerson;
+};
+
+#endif
@@ -0,0 +1,1187 @@
+#include "ImageDecoder.h"
+#include "Platform.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *failure = "";
+
+static bool fail(const char *reason)
+{
+    failure = reason;
+    return false;
+}
+
+const char *ImageDecoder::getError()
+{
+    return failure;
+}
+
+static uint32_t readBE32(const unsigned char *p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static int readBE16(const unsigned char *p)
+{
+    return p[0] << 8 | p[1];
+}
+
+bool ImageDecoder::load(const char *path, DecodedImage &image)
+{
+    Platform::MappedFile file;
+    if (!Platform::mapFile(path, file))
+    {
+        printf("Warning: could not open %s\n", path);
+        fflush(stdout);
+        return false;
+    }
+
+    static const unsigned char PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    bool ok;
+    if (file.size >= 8 && memcmp(file.data, PNG_SIGNATURE, 8) == 0)
+        ok = decodePNG(file.data, file.size, image);
+    else if (file.size >= 2 && file.data[0] == 0xFF && file.data[1] == 0xD8)
+        ok = decodeJPEG(file.data, file.size, image);
+    else
+        ok = fail("not a PNG or JPEG file");
+
+    if (!ok)
+    {
+        printf("Warning: could not decode %s: %s\n", path, failure);
+        fflush(stdout);
+    }
+
+    Platform::unmapFile(file);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Inflate (RFC 1951) for the zlib stream inside PNG IDAT chunks
+
+static const int INFLATE_FAST_BITS = 10;
+
+struct InflateHuffman
+{
+    uint16_t fast[1 << INFLATE_FAST_BITS]; // symbol << 4 | length, 0 if the code is longer
+    uint32_t maxCode[17];                  // Exclusive bound of each length's codes, left aligned to 16 bits
+    uint16_t firstCode[16];
+    uint16_t firstSymbol[16];              // Index into symbols of the first code of each length
+    uint16_t symbols[288];
+};
+
+static int reverseBits(int code, int length)
+{
+    int reversed = 0;
+    for (int i = 0; i < length; i++)
+    {
+        reversed = reversed << 1 | (code & 1);
+        code >>= 1;
+    }
+    return reversed;
+}
+
+static bool buildInflateHuffman(InflateHuffman &h, const uint8_t *lengths, int count)
+{
+    int counts[16] = {0};
+    for (int i = 0; i < count; i++)
+        counts[lengths[i]]++;
+    counts[0] = 0;
+
+    int nextCode[16];
+    int code = 0, index = 0;
+    for (int length = 1; length < 16; length++)
+    {
+        nextCode[length] = code;
+        h.firstCode[length] = (uint16_t)code;
+        h.firstSymbol[length] = (uint16_t)index;
+        code += counts[length];
+        index += counts[length];
+        if (code > (1 << length))
+            return fail("oversubscribed Huffman code");
+        h.maxCode[length] = (uint32_t)code << (16 - length);
+        code <<= 1;
+    }
+    h.maxCode[16] = 0x10000;
+
+    memset(h.fast, 0, sizeof(h.fast));
+    for (int symbol = 0; symbol < count; symbol++)
+    {
+        int length = lengths[symbol];
+        if (length == 0)
+            continue;
+        int c = nextCode[length]++;
+        h.symbols[h.firstSymbol[length] + c - h.firstCode[length]] = (uint16_t)symbol;
+        if (length <= INFLATE_FAST_BITS)
+        {
+            for (int j = reverseBits(c, length); j < (1 << INFLATE_FAST_BITS); j += 1 << length)
+                h.fast[j] = (uint16_t)(symbol << 4 | length);
+        }
+    }
+    return true;
+}
+
+// Least significant bit first, refilled eight bytes at a time
+struct InflateBits
+{
+    const uint8_t *p, *end;
+    uint64_t buffer;
+    int count;
+    int overrun; // Zero bytes fed past the end
+
+    void refill()
+    {
+        if (end - p >= 8)
+        {
+            uint64_t v;
+            memcpy(&v, p, 8);
+            buffer |= v << count;
+            p += (63 - count) >> 3;
+            count |= 56;
+        }
+        else
+        {
+            while (count <= 56)
+            {
+                if (p < end)
+                    buffer |= (uint64_t)*p++ << count;
+                else
+                    overrun++;
+                count += 8;
+            }
+        }
+    }
+
+    uint32_t take(int n)
+    {
+        if (count < n)
+            refill();
+        uint32_t v = (uint32_t)(buffer & ((1ull << n) - 1));
+        buffer >>= n;
+        count -= n;
+        return v;
+    }
+
+    int decode(const InflateHuffman &h)
+    {
+        if (count < 16)
+            refill();
+        int entry = h.fast[buffer & ((1 << INFLATE_FAST_BITS) - 1)];
+        if (entry)
+        {
+            buffer >>= entry & 15;
+            count -= entry & 15;
+            return entry >> 4;
+        }
+
+        uint32_t code = (uint32_t)reverseBits((int)(buffer & 0xFFFF), 16);
+        int length = INFLATE_FAST_BITS + 1;
+        while (code >= h.maxCode[length])
+            length++;
+        if (length == 16)
+            return -1;
+        buffer >>= length;
+        count -= length;
+        return h.symbols[h.firstSymbol[length] + (code >> (16 - length)) - h.firstCode[length]];
+    }
+};
+
+static const uint16_t LENGTH_BASE[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                         31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DISTANCE_BASE[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                           193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static bool inflateBlock(InflateBits &bits, const InflateHuffman &literals, const InflateHuffman &distances,
+                         uint8_t *out, size_t &pos, size_t size)
+{
+    for (;;)
+    {
+        int symbol = bits.decode(literals);
+        if (symbol < 256)
+        {
+            if (symbol < 0)
+                return fail("bad Huffman code");
+            if (pos >= size)
+                return fail("image data too long");
+            out[pos++] = (uint8_t)symbol;
+            continue;
+        }
+        if (symbol == 256)
+            return true;
+
+        symbol -= 257;
+        if (symbol >= 29)
+            return fail("bad length code");
+        size_t length = LENGTH_BASE[symbol] + bits.take(LENGTH_EXTRA[symbol]);
+        int d = bits.decode(distances);
+        if (d < 0 || d >= 30)
+            return fail("bad distance code");
+        size_t distance = DISTANCE_BASE[d] + bits.take(DISTANCE_EXTRA[d]);
+        if (distance > pos)
+            return fail("distance before start of data");
+        if (length > size - pos)
+            return fail("image data too long");
+
+        uint8_t *dst = out + pos;
+        const uint8_t *src = dst - distance;
+        pos += length;
+        if (distance >= 8 && pos + 8 <= size)
+        {
+            // Chunks never read bytes this copy has yet to write
+            for (size_t i = 0; i < length; i += 8)
+                memcpy(dst + i, src + i, 8);
+        }
+        else
+        {
+            for (size_t i = 0; i < length; i++)
+                dst[i] = src[i];
+        }
+    }
+}
+
+// Inflates a zlib stream into exactly size bytes
+static bool zlibInflate(const uint8_t *data, size_t dataSize, uint8_t *out, size_t size)
+{
+    if (dataSize < 2 || (data[0] & 15) != 8 || (data[0] << 8 | data[1]) % 31 != 0 || (data[1] & 0x20))
+        return fail("bad zlib header");
+
+    InflateBits bits = {data + 2, data + dataSize, 0, 0, 0};
+    InflateHuffman literals, distances;
+    size_t pos = 0;
+    bool last;
+    do
+    {
+        last = bits.take(1) != 0;
+        int type = bits.take(2);
+        if (type == 0)
+        {
+            // Stored: hand the whole bytes still buffered back to the stream
+            bits.take(bits.count & 7);
+            if ((bits.count >> 3) < bits.overrun)
+                return fail("truncated image data");
+            bits.p -= (bits.count >> 3) - bits.overrun;
+            bits.overrun = 0;
+            bits.buffer = 0;
+            bits.count = 0;
+            if (bits.end - bits.p < 4)
+                return fail("truncated image data");
+            size_t length = bits.p[0] | bits.p[1] << 8;
+            size_t check = bits.p[2] | bits.p[3] << 8;
+            bits.p += 4;
+            if (length != (~check & 0xFFFF))
+                return fail("bad stored block");
+            if (length > (size_t)(bits.end - bits.p) || length > size - pos)
+                return fail("bad stored block length");
+            memcpy(out + pos, bits.p, length);
+            bits.p += length;
+            pos += length;
+            continue;
+        }
+
+        uint8_t lengths[288 + 32];
+        if (type == 1)
+        {
+            memset(lengths, 8, 144);
+            memset(lengths + 144, 9, 112);
+            memset(lengths + 256, 7, 24);
+            memset(lengths + 280, 8, 8);
+            buildInflateHuffman(literals, lengths, 288);
+            memset(lengths, 5, 30);
+            buildInflateHuffman(distances, lengths, 30);
+        }
+        else if (type == 2)
+        {
+            static const uint8_t ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+            int literalCount = bits.take(5) + 257;
+            int distanceCount = bits.take(5) + 1;
+            int codeCount = bits.take(4) + 4;
+            uint8_t codeLengths[19] = {0};
+            for (int i = 0; i < codeCount; i++)
+                codeLengths[ORDER[i]] = (uint8_t)bits.take(3);
+            InflateHuffman lengthCode;
+            if (!buildInflateHuffman(lengthCode, codeLengths, 19))
+                return false;
+
+            int total = literalCount + distanceCount;
+            for (int n = 0; n < total;)
+            {
+                int symbol = bits.decode(lengthCode);
+                if (symbol < 0)
+                    return fail("bad code lengths");
+                if (symbol < 16)
+                {
+                    lengths[n++] = (uint8_t)symbol;
+                    continue;
+                }
+                int repeat;
+                uint8_t value = 0;
+                if (symbol == 16)
+                {
+                    if (n == 0)
+                        return fail("bad code lengths");
+                    value = lengths[n - 1];
+                    repeat = 3 + bits.take(2);
+                }
+                else if (symbol == 17)
+                    repeat = 3 + bits.take(3);
+                else
+                    repeat = 11 + bits.take(7);
+                if (n + repeat > total)
+                    return fail("bad code lengths");
+                memset(lengths + n, value, repeat);
+                n += repeat;
+            }
+            if (!buildInflateHuffman(literals, lengths, literalCount) ||
+                !buildInflateHuffman(distances, lengths + literalCount, distanceCount))
+                return false;
+        }
+        else
+            return fail("bad block type");
+
+        if (!inflateBlock(bits, literals, distances, out, pos, size))
+            return false;
+        if (bits.overrun > 8)
+            return fail("truncated image data");
+    } while (!last);
+
+    if (pos != size)
+        return fail("image data too short");
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// PNG
+
+struct PngInfo
+{
+    int width, height;
+    int depth, colorType;
+    int samples;                // Per pixel in the file
+    int channels;               // Per pixel in the result
+    int filterBytes;            // Distance to the corresponding byte of the pixel on the left
+    unsigned char palette[256 * 4];
+    bool hasAlphaPalette;
+};
+
+static size_t pngStride(const PngInfo &info, int width)
+{
+    return ((size_t)width * info.samples * info.depth + 7) / 8;
+}
+
+static int paeth(int a, int b, int c)
+{
+    int pa = b - c, pb = a - c, pc = pa + pb;
+    pa = pa < 0 ? -pa : pa;
+    pb = pb < 0 ? -pb : pb;
+    pc = pc < 0 ? -pc : pc;
+    if (pa <= pb && pa <= pc)
+        return a;
+    return pb <= pc ? b : c;
+}
+
+static bool unfilterRow(uint8_t *row, const uint8_t *prior, size_t stride, int bpp, int filter)
+{
+    switch (filter)
+    {
+    case 0:
+        break;
+    case 1: // Sub
+        for (size_t i = bpp; i < stride; i++)
+            row[i] = (uint8_t)(row[i] + row[i - bpp]);
+        break;
+    case 2: // Up
+        for (size_t i = 0; i < stride; i++)
+            row[i] = (uint8_t)(row[i] + prior[i]);
+        break;
+    case 3: // Average
+        for (int i = 0; i < bpp; i++)
+            row[i] = (uint8_t)(row[i] + (prior[i] >> 1));
+        for (size_t i = bpp; i < stride; i++)
+            row[i] = (uint8_t)(row[i] + ((row[i - bpp] + prior[i]) >> 1));
+        break;
+    case 4: // Paeth
+        for (int i = 0; i < bpp; i++)
+            row[i] = (uint8_t)(row[i] + prior[i]);
+        for (size_t i = bpp; i < stride; i++)
+            row[i] = (uint8_t)(row[i] + paeth(row[i - bpp], prior[i], prior[i - bpp]));
+        break;
+    default:
+        return fail("bad filter type");
+    }
+    return true;
+}
+
+// Unfiltered row to 8-bit pixels
+static void convertRow(const PngInfo &info, const uint8_t *src, int width, uint8_t *dst)
+{
+    if (info.depth == 16)
+    {
+        int count = width * info.samples;
+        for (int i = 0; i < count; i++)
+            dst[i] = src[i * 2];
+        return;
+    }
+
+    if (info.colorType == 3)
+    {
+        int shift = 8 - info.depth, mask = (1 << info.depth) - 1;
+        for (int x = 0; x < width; x++)
+        {
+            int bit = x * info.depth;
+            int index = (src[bit >> 3] >> (shift - (bit & 7))) & mask;
+            memcpy(dst, info.palette + index * 4, info.channels);
+            dst += info.channels;
+        }
+        return;
+    }
+
+    if (info.depth == 8)
+    {
+        memcpy(dst, src, (size_t)width * info.samples);
+        return;
+    }
+
+    // 1, 2 or 4-bit gray, scaled to the full range
+    static const uint8_t SCALE[5] = {0, 0xFF, 0x55, 0, 0x11};
+    int shift = 8 - info.depth, mask = (1 << info.depth) - 1;
+    for (int x = 0; x < width; x++)
+    {
+        int bit = x * info.depth;
+        dst[x] = (uint8_t)(((src[bit >> 3] >> (shift - (bit & 7))) & mask) * SCALE[info.depth]);
+    }
+}
+
+bool ImageDecoder::decodePNG(const unsigned char *data, size_t size, DecodedImage &image)
+{
+    if (size < 8 + 25)
+        return fail("truncated PNG");
+
+    PngInfo info;
+    memset(&info, 0, sizeof(info));
+    int interlace = 0;
+    int paletteSize = 0;
+    std::vector<uint8_t> compressed;
+    bool haveHeader = false;
+
+    const unsigned char *p = data + 8, *end = data + size;
+    for (;;)
+    {
+        if (end - p < 12)
+            return fail("truncated PNG");
+        uint32_t length = readBE32(p);
+        const unsigned char *type = p + 4, *chunk = p + 8;
+        if (length > (size_t)(end - chunk) - 4)
+            return fail("truncated PNG");
+        p = chunk + length + 4;
+
+        if (memcmp(type, "IHDR", 4) == 0)
+        {
+            if (length != 13)
+                return fail("bad IHDR");
+            info.width = (int)readBE32(chunk);
+            info.height = (int)readBE32(chunk + 4);
+            info.depth = chunk[8];
+            info.colorType = chunk[9];
+            interlace = chunk[12];
+            static const int SAMPLES[7] = {1, 0, 3, 1, 2, 0, 4};
+            if (info.colorType > 6 || SAMPLES[info.colorType] == 0)
+                return fail("bad color type");
+            info.samples = SAMPLES[info.colorType];
+            bool depthOk = info.depth == 8 || (info.depth == 16 && info.colorType != 3) ||
+                           ((info.depth == 1 || info.depth == 2 || info.depth == 4) &&
+                            (info.colorType == 0 || info.colorType == 3));
+            if (!depthOk || chunk[10] != 0 || chunk[11] != 0 || interlace > 1)
+                return fail("unsupported PNG format");
+            if (info.width <= 0 || info.height <= 0 || info.width > (1 << 16) || info.height > (1 << 16))
+                return fail("bad PNG size");
+            info.channels = info.colorType == 3 ? 3 : info.samples;
+            info.filterBytes = (info.samples * info.depth + 7) / 8;
+            haveHeader = true;
+        }
+        else if (memcmp(type, "PLTE", 4) == 0)
+        {
+            paletteSize = length / 3;
+            if (paletteSize > 256 || length % 3 != 0)
+                return fail("bad palette");
+            for (int i = 0; i < paletteSize; i++)
+            {
+                memcpy(info.palette + i * 4, chunk + i * 3, 3);
+                info.palette[i * 4 + 3] = 255;
+            }
+        }
+        else if (memcmp(type, "tRNS", 4) == 0)
+        {
+            // Only palette alpha; a gray or RGB color key is ignored
+            if (info.colorType == 3)
+            {
+                for (uint32_t i = 0; i < length && i < 256; i++)
+                    info.palette[i * 4 + 3] = chunk[i];
+                info.hasAlphaPalette = true;
+            }
+        }
+        else if (memcmp(type, "IDAT", 4) == 0)
+            compressed.insert(compressed.end(), chunk, chunk + length);
+        else if (memcmp(type, "IEND", 4) == 0)
+            break;
+        else if (!(type[0] & 0x20))
+            return fail("unknown critical PNG chunk");
+    }
+
+    if (!haveHeader || compressed.empty())
+        return fail("PNG has no image data");
+    if (info.colorType == 3)
+    {
+        if (paletteSize == 0)
+            return fail("PNG has no palette");
+        if (info.hasAlphaPalette)
+            info.channels = 4;
+    }
+
+    // Adam7 passes, a plain image is one pass over every pixel
+    static const int PASS_X[7] = {0, 4, 0, 2, 0, 1, 0}, PASS_Y[7] = {0, 0, 4, 0, 2, 0, 1};
+    static const int STEP_X[7] = {8, 8, 4, 4, 2, 2, 1}, STEP_Y[7] = {8, 8, 8, 4, 4, 2, 2};
+    int passCount = interlace ? 7 : 1;
+    int passWidth[7], passHeight[7];
+    size_t rawSize = 0;
+    for (int pass = 0; pass < passCount; pass++)
+    {
+        int startX = interlace ? PASS_X[pass] : 0, startY = interlace ? PASS_Y[pass] : 0;
+        int stepX = interlace ? STEP_X[pass] : 1, stepY = interlace ? STEP_Y[pass] : 1;
+        passWidth[pass] = (info.width - startX + stepX - 1) / stepX;
+        passHeight[pass] = (info.height - startY + stepY - 1) / stepY;
+        if (passWidth[pass] > 0 && passHeight[pass] > 0)
+            rawSize += (pngStride(info, passWidth[pass]) + 1) * passHeight[pass];
+    }
+
+    std::vector<uint8_t> raw(rawSize);
+    if (!zlibInflate(&compressed[0], compressed.size(), &raw[0], rawSize))
+        return false;
+
+    image.width = info.width;
+    image.height = info.height;
+    image.channels = info.channels;
+    image.pixels.resize((size_t)info.width * info.height * info.channels);
+
+    std::vector<uint8_t> zeroRow(pngStride(info, info.width), 0);
+    std::vector<uint8_t> passRow(interlace ? (size_t)info.width * info.channels : 0);
+    uint8_t *row = &raw[0];
+    for (int pass = 0; pass < passCount; pass++)
+    {
+        int w = passWidth[pass], h = passHeight[pass];
+        if (w <= 0 || h <= 0)
+            continue;
+        size_t stride = pngStride(info, w);
+        const uint8_t *prior = &zeroRow[0];
+        for (int y = 0; y < h; y++)
+        {
+            if (!unfilterRow(row + 1, prior, stride, info.filterBytes, row[0]))
+                return false;
+            if (!interlace)
+                convertRow(info, row + 1, w, &image.pixels[(size_t)y * w * info.channels]);
+            else
+            {
+                convertRow(info, row + 1, w, &passRow[0]);
+                uint8_t *dst = &image.pixels[((size_t)(PASS_Y[pass] + y * STEP_Y[pass]) * info.width + PASS_X[pass]) *
+                                             info.channels];
+                for (int x = 0; x < w; x++)
+                    memcpy(dst + (size_t)x * STEP_X[pass] * info.channels, &passRow[x * info.channels], info.channels);
+            }
+            prior = row + 1;
+            row += stride + 1;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Baseline JPEG
+
+static const int JPEG_FAST_BITS = 9;
+
+struct JpegHuffman
+{
+    uint8_t fast[1 << JPEG_FAST_BITS]; // Index into values, 255 if the code is longer
+    uint8_t sizes[256];
+    uint8_t values[256];
+    int32_t maxCode[18];               // Exclusive bound of each length's codes, left aligned to 16 bits
+    int32_t delta[17];                 // Value index minus code for each length
+    bool defined;
+};
+
+static bool buildJpegHuffman(JpegHuffman &h, const uint8_t counts[16])
+{
+    int code = 0, index = 0;
+    uint16_t codes[256];
+    for (int length = 1; length <= 16; length++)
+    {
+        h.delta[length] = index - code;
+        for (int i = 0; i < counts[length - 1]; i++)
+        {
+            h.sizes[index] = (uint8_t)length;
+            codes[index++] = (uint16_t)code++;
+        }
+        if (code > (1 << length))
+            return fail("bad Huffman table");
+        h.maxCode[length] = code << (16 - length);
+        code <<= 1;
+    }
+    h.maxCode[17] = 0x7FFFFFFF;
+
+    memset(h.fast, 255, sizeof(h.fast));
+    for (int i = 0; i < index; i++)
+    {
+        int length = h.sizes[i];
+        if (length <= JPEG_FAST_BITS && i < 255)
+        {
+            int first = codes[i] << (JPEG_FAST_BITS - length);
+            memset(h.fast + first, i, 1 << (JPEG_FAST_BITS - length));
+        }
+    }
+    h.defined = true;
+    return true;
+}
+
+// Most significant bit first; stops at a marker and feeds zeros from there
+struct JpegBits
+{
+    const uint8_t *p, *end;
+    uint32_t buffer;
+    int count;
+    bool atMarker;
+
+    void reset(const uint8_t *start)
+    {
+        p = start;
+        buffer = 0;
+        count = 0;
+        atMarker = false;
+    }
+
+    void refill()
+    {
+        while (count <= 24)
+        {
+            uint32_t byte = 0;
+            if (!atMarker && p < end)
+            {
+                byte = *p++;
+                if (byte == 0xFF)
+                {
+                    if (p < end && *p == 0)
+                        p++; // Stuffed zero
+                    else
+                    {
+                        atMarker = true;
+                        p--;
+                        byte = 0;
+                    }
+                }
+            }
+            buffer |= byte << (24 - count);
+            count += 8;
+        }
+    }
+
+    int take(int n)
+    {
+        if (n == 0)
+            return 0;
+        if (count < n)
+            refill();
+        int v = (int)(buffer >> (32 - n));
+        buffer <<= n;
+        count -= n;
+        return v;
+    }
+
+    // Reads an n-bit magnitude category and sign extends it
+    int receive(int n)
+    {
+        int v = take(n);
+        return n > 0 && v < (1 << (n - 1)) ? v - (1 << n) + 1 : v;
+    }
+
+    int decode(const JpegHuffman &h)
+    {
+        if (count < 16)
+            refill();
+        int index = h.fast[buffer >> (32 - JPEG_FAST_BITS)];
+        if (index < 255)
+        {
+            int length = h.sizes[index];
+            buffer <<= length;
+            count -= length;
+            return h.values[index];
+        }
+
+        int32_t code = (int32_t)(buffer >> 16);
+        int length = JPEG_FAST_BITS + 1;
+        while (code >= h.maxCode[length])
+            length++;
+        if (length > 16)
+            return -1;
+        index = (code >> (16 - length)) + h.delta[length];
+        buffer <<= length;
+        count -= length;
+        return h.values[index];
+    }
+};
+
+// Natural order position of each zigzag index
+static const uint8_t ZIGZAG[64 + 16] = {0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+                                        12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+                                        35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+                                        58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+                                        // Runs past the end land on 63 instead of out of bounds
+                                        63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63};
+
+struct JpegComponent
+{
+    int id;
+    int h, v;          // Sampling factors
+    int quant;
+    int dcTable, acTable;
+    int dcPredictor;
+    int blocksX, blocksY; // Blocks actually coded in a single component scan
+    int stride;          // Plane width, padded to whole MCUs
+    std::vector<uint8_t> plane;
+};
+
+// Integer IDCT of libjpeg's jidctint.c (islow): 13 fractional bits for the
+// constants, 2 extra bits kept between the passes
+#define CONST_BITS 13
+#define PASS1_BITS 2
+#define FIX_0_298631336 2446
+#define FIX_0_390180644 3196
+#define FIX_0_541196100 4433
+#define FIX_0_765366865 6270
+#define FIX_0_899976223 7373
+#define FIX_1_175875602 9633
+#define FIX_1_501321110 12299
+#define FIX_1_847759065 15137
+#define FIX_1_961570560 16069
+#define FIX_2_053119869 16819
+#define FIX_2_562915447 20995
+#define FIX_3_072711026 25172
+
+// 8-bit JPEG coefficients fit in 11 bits plus sign, which is what keeps the
+// 32-bit IDCT from overflowing. A corrupt file can hold anything, so the DC
+// predictor and the dequantized coefficients are limited to that range.
+#define MAX_COEFFICIENT 2047
+
+static int clampCoefficient(int64_t v)
+{
+    return (int)(v < -MAX_COEFFICIENT ? -MAX_COEFFICIENT : v > MAX_COEFFICIENT ? MAX_COEFFICIENT : v);
+}
+
+static uint8_t clampSample(int v)
+{
+    return (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+}
+
+// One 8-point pass over in[0], in[s], ... in[7 * s]; leaves the even part in
+// e10..e13 and the odd part in t0..t3
+#define IDCT_1D(in, s)                                                                                       \
+    int z2 = in[2 * s], z3 = in[6 * s];                                                                      \
+    int z1 = (z2 + z3) * FIX_0_541196100;                                                                    \
+    int t2 = z1 - z3 * FIX_1_847759065;                                                                      \
+    int t3 = z1 + z2 * FIX_0_765366865;                                                                      \
+    int t0 = (in[0] + in[4 * s]) * (1 << CONST_BITS);                                                        \
+    int t1 = (in[0] - in[4 * s]) * (1 << CONST_BITS);                                                        \
+    int e10 = t0 + t3, e13 = t0 - t3, e11 = t1 + t2, e12 = t1 - t2;                                          \
+    t0 = in[7 * s];                                                                                          \
+    t1 = in[5 * s];                                                                                          \
+    t2 = in[3 * s];                                                                                          \
+    t3 = in[1 * s];                                                                                          \
+    z1 = t0 + t3;                                                                                            \
+    z2 = t1 + t2;                                                                                            \
+    z3 = t0 + t2;                                                                                            \
+    int z4 = t1 + t3;                                                                                        \
+    int z5 = (z3 + z4) * FIX_1_175875602;                                                                    \
+    t0 *= FIX_0_298631336;                                                                                   \
+    t1 *= FIX_2_053119869;                                                                                   \
+    t2 *= FIX_3_072711026;                                                                                   \
+    t3 *= FIX_1_501321110;                                                                                   \
+    z1 *= -FIX_0_899976223;                                                                                  \
+    z2 *= -FIX_2_562915447;                                                                                  \
+    z3 = z3 * -FIX_1_961570560 + z5;                                                                         \
+    z4 = z4 * -FIX_0_390180644 + z5;                                                                         \
+    t0 += z1 + z3;                                                                                           \
+    t1 += z2 + z4;                                                                                           \
+    t2 += z2 + z3;                                                                                           \
+    t3 += z1 + z4;
+
+static void inverseDCT(const int *coefficients, uint8_t *out, int stride)
+{
+    int work[64];
+    for (int c = 0; c < 8; c++)
+    {
+        const int *in = coefficients + c;
+        int *w = work + c;
+        if (!(in[8] | in[16] | in[24] | in[32] | in[40] | in[48] | in[56]))
+        {
+            int dc = in[0] * (1 << PASS1_BITS);
+            for (int i = 0; i < 8; i++)
+                w[i * 8] = dc;
+            continue;
+        }
+        IDCT_1D(in, 8)
+        const int shift = CONST_BITS - PASS1_BITS, round = 1 << (shift - 1);
+        w[0] = (e10 + t3 + round) >> shift;
+        w[56] = (e10 - t3 + round) >> shift;
+        w[8] = (e11 + t2 + round) >> shift;
+        w[48] = (e11 - t2 + round) >> shift;
+        w[16] = (e12 + t1 + round) >> shift;
+        w[40] = (e12 - t1 + round) >> shift;
+        w[24] = (e13 + t0 + round) >> shift;
+        w[32] = (e13 - t0 + round) >> shift;
+    }
+
+    for (int r = 0; r < 8; r++, out += stride)
+    {
+        const int *in = work + r * 8;
+        if (!(in[1] | in[2] | in[3] | in[4] | in[5] | in[6] | in[7]))
+        {
+            uint8_t dc = clampSample(((in[0] + (1 << (PASS1_BITS + 2))) >> (PASS1_BITS + 3)) + 128);
+            memset(out, dc, 8);
+            continue;
+        }
+        IDCT_1D(in, 1)
+        const int shift = CONST_BITS + PASS1_BITS + 3, round = 1 << (shift - 1);
+        out[0] = clampSample(((e10 + t3 + round) >> shift) + 128);
+        out[7] = clampSample(((e10 - t3 + round) >> shift) + 128);
+        out[1] = clampSample(((e11 + t2 + round) >> shift) + 128);
+        out[6] = clampSample(((e11 - t2 + round) >> shift) + 128);
+        out[2] = clampSample(((e12 + t1 + round) >> shift) + 128);
+        out[5] = clampSample(((e12 - t1 + round) >> shift) + 128);
+        out[3] = clampSample(((e13 + t0 + round) >> shift) + 128);
+        out[4] = clampSample(((e13 - t0 + round) >> shift) + 128);
+    }
+}
+
+struct JpegDecoder
+{
+    uint16_t quant[4][64]; // Zigzag order
+    JpegHuffman dc[4], ac[4];
+    JpegComponent components[4];
+    int componentCount;
+    int width, height;
+    int maxH, maxV;
+    int mcusX, mcusY;
+    int restartInterval;
+    JpegBits bits;
+
+    bool decodeBlock(JpegComponent &c, uint8_t *out)
+    {
+        int coefficients[64];
+        memset(coefficients, 0, sizeof(coefficients));
+        const uint16_t *q = quant[c.quant];
+
+        int t = bits.decode(dc[c.dcTable]);
+        if (t < 0 || t > 16)
+            return fail("bad Huffman code");
+        c.dcPredictor = clampCoefficient((int64_t)c.dcPredictor + bits.receive(t));
+        coefficients[0] = clampCoefficient((int64_t)c.dcPredictor * q[0]);
+
+        const JpegHuffman &table = ac[c.acTable];
+        for (int k = 1; k < 64;)
+        {
+            int rs = bits.decode(table);
+            if (rs < 0)
+                return fail("bad Huffman code");
+            int run = rs >> 4, s = rs & 15;
+            if (s == 0)
+            {
+                if (run != 15)
+                    break; // End of block
+                k += 16;
+                continue;
+            }
+            k += run;
+            if (k > 63)
+                return fail("coefficient out of range");
+            coefficients[ZIGZAG[k]] = clampCoefficient((int64_t)bits.receive(s) * q[k]);
+            k++;
+        }
+        inverseDCT(coefficients, out, c.stride);
+        return true;
+    }
+
+    // Skips to just past the next RSTn marker
+    bool restart(const uint8_t *end)
+    {
+        const uint8_t *p = bits.p;
+        while (end - p >= 2 && !(p[0] == 0xFF && p[1] != 0 && p[1] != 0xFF))
+            p++;
+        if (end - p < 2 || p[0] != 0xFF || p[1] < 0xD0 || p[1] > 0xD7)
+            return fail("missing restart marker");
+        bits.reset(p + 2);
+        for (int i = 0; i < componentCount; i++)
+            components[i].dcPredictor = 0;
+        return true;
+    }
+
+    bool decodeScan(JpegComponent **scan, int scanCount, const uint8_t *end)
+    {
+        for (int i = 0; i < scanCount; i++)
+        {
+            if (!dc[scan[i]->dcTable].defined || !ac[scan[i]->acTable].defined)
+                return fail("missing Huffman table");
+            scan[i]->dcPredictor = 0;
+        }
+
+        int left = restartInterval;
+        if (scanCount == 1)
+        {
+            // Non-interleaved: the component's own blocks, one per MCU
+            JpegComponent &c = *scan[0];
+            for (int by = 0; by < c.blocksY; by++)
+                for (int bx = 0; bx < c.blocksX; bx++)
+                {
+                    if (restartInterval && left-- == 0)
+                    {
+                        if (!restart(end))
+                            return false;
+                        left = restartInterval - 1;
+                    }
+                    if (!decodeBlock(c, &c.plane[(size_t)by * 8 * c.stride + bx * 8]))
+                        return false;
+                }
+            return true;
+        }
+
+        for (int my = 0; my < mcusY; my++)
+            for (int mx = 0; mx < mcusX; mx++)
+            {
+                if (restartInterval && left-- == 0)
+                {
+                    if (!restart(end))
+                        return false;
+                    left = restartInterval - 1;
+                }
+                for (int i = 0; i < scanCount; i++)
+                {
+                    JpegComponent &c = *scan[i];
+                    for (int y = 0; y < c.v; y++)
+                        for (int x = 0; x < c.h; x++)
+                        {
+                            size_t row = (size_t)(my * c.v + y) * 8, column = (size_t)(mx * c.h + x) * 8;
+                            if (!decodeBlock(c, &c.plane[row * c.stride + column]))
+                                return false;
+                        }
+                }
+            }
+        return true;
+    }
+
+    // Box upsamples chroma and converts to gray or RGB
+    void output(DecodedImage &image)
+    {
+        image.width = width;
+        image.height = height;
+        image.channels = componentCount == 1 ? 1 : 3;
+        image.pixels.resize((size_t)width * height * image.channels);
+
+        if (componentCount == 1)
+        {
+            const JpegComponent &c = components[0];
+            for (int y = 0; y < height; y++)
+                memcpy(&image.pixels[(size_t)y * width], &c.plane[(size_t)y * c.stride], width);
+            return;
+        }
+
+        const JpegComponent *planes[3] = {&components[0], &components[1], &components[2]};
+        std::vector<uint8_t> rows(width * 3);
+        for (int y = 0; y < height; y++)
+        {
+            // Widen each plane's row to full resolution first, the
+            // conversion loop then reads three plain arrays
+            for (int i = 0; i < 3; i++)
+            {
+                const JpegComponent &c = *planes[i];
+                const uint8_t *src = &c.plane[(size_t)(y / (maxV / c.v)) * c.stride];
+                uint8_t *dst = &rows[i * width];
+                int scale = maxH / c.h;
+                if (scale == 1)
+                    memcpy(dst, src, width);
+                else
+                    for (int x = 0; x < width; x++)
+                        dst[x] = src[x / scale];
+            }
+
+            const uint8_t *luma = &rows[0], *cb = &rows[width], *cr = &rows[width * 2];
+            uint8_t *out = &image.pixels[(size_t)y * width * 3];
+            for (int x = 0; x < width; x++, out += 3)
+            {
+                // JFIF YCbCr with 16 fractional bits, as libjpeg's jdcolor.c
+                int l = luma[x], blue = cb[x] - 128, red = cr[x] - 128;
+                out[0] = clampSample(l + ((91881 * red + 32768) >> 16));
+                out[1] = clampSample(l + ((-22554 * blue - 46802 * red + 32768) >> 16));
+                out[2] = clampSample(l + ((116130 * blue + 32768) >> 16));
+            }
+        }
+    }
+};
+
+bool ImageDecoder::decodeJPEG(const unsigned char *data, size_t size, DecodedImage &image)
+{
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+        return fail("not a JPEG file");
+
+    // Large, hold it off the stack
+    std::vector<JpegDecoder> storage(1);
+    JpegDecoder &d = storage[0];
+    memset(d.quant, 0, sizeof(d.quant));
+    memset(d.dc, 0, sizeof(d.dc));
+    memset(d.ac, 0, sizeof(d.ac));
+    d.componentCount = 0;
+    d.restartInterval = 0;
+    d.bits.end = data + size;
+
+    const unsigned char *p = data + 2, *end = data + size;
+    bool haveFrame = false, haveScan = false;
+    for (;;)
+    {
+        // Next marker, skipping fill bytes
+        while (p < end && *p != 0xFF)
+            p++;
+        while (p < end && *p == 0xFF)
+            p++;
+        if (p >= end)
+            break;
+        int marker = *p++;
+        if (marker == 0) // Stuffed byte in entropy data the scan left unread
+            continue;
+        if (marker == 0xD9) // EOI
+            break;
+        if (marker == 0xD8 || (marker >= 0xD0 && marker <= 0xD7))
+            continue;
+
+        if (end - p < 2)
+            return fail("truncated JPEG");
+        int length = readBE16(p);
+        if (length < 2 || length > end - p)
+            return fail("truncated JPEG");
+        const unsigned char *segment = p + 2, *segmentEnd = p + length;
+        p = segmentEnd;
+
+        if (marker == 0xDB) // DQT
+        {
+            while (segment < segmentEnd)
+            {
+                int precision = segment[0] >> 4, id = segment[0] & 15;
+                segment++;
+                if (id > 3 || segmentEnd - segment < 64 * (precision + 1))
+                    return fail("bad quantization table");
+                for (int k = 0; k < 64; k++)
+                    d.quant[id][k] = (uint16_t)(precision ? readBE16(segment + k * 2) : segment[k]);
+                segment += 64 * (precision + 1);
+            }
+        }
+        else if (marker == 0xC4) // DHT
+        {
+            while (segment < segmentEnd)
+            {
+                if (segmentEnd - segment < 17)
+                    return fail("bad Huffman table");
+                int tableClass = segment[0] >> 4, id = segment[0] & 15;
+                const uint8_t *counts = segment + 1;
+                int total = 0;
+                for (int i = 0; i < 16; i++)
+                    total += counts[i];
+                segment += 17;
+                if (tableClass > 1 || id > 3 || total > 256 || segmentEnd - segment < total)
+                    return fail("bad Huffman table");
+                JpegHuffman &h = tableClass == 0 ? d.dc[id] : d.ac[id];
+                if (!buildJpegHuffman(h, counts))
+                    return false;
+                memcpy(h.values, segment, total);
+                segment += total;
+            }
+        }
+        else if (marker == 0xC0 || marker == 0xC1) // SOF0/SOF1
+        {
+            if (length < 8 || segment[0] != 8)
+                return fail("unsupported JPEG precision");
+            d.height = readBE16(segment + 1);
+            d.width = readBE16(segment + 3);
+            d.componentCount = segment[5];
+            if (d.width == 0 || d.height == 0)
+                return fail("bad JPEG size");
+            if ((d.componentCount != 1 && d.componentCount != 3) || length != 8 + 3 * d.componentCount)
+                return fail("unsupported JPEG components");
+
+            d.maxH = d.maxV = 1;
+            for (int i = 0; i < d.componentCount; i++)
+            {
+                JpegComponent &c = d.components[i];
+                const uint8_t *s = segment + 6 + i * 3;
+                c.id = s[0];
+                c.h = s[1] >> 4;
+                c.v = s[1] & 15;
+                c.quant = s[2];
+                if (c.h < 1 || c.h > 4 || c.v < 1 || c.v > 4 || c.quant > 3)
+                    return fail("bad JPEG component");
+                d.maxH = c.h > d.maxH ? c.h : d.maxH;
+                d.maxV = c.v > d.maxV ? c.v : d.maxV;
+            }
+
+            d.mcusX = (d.width + 8 * d.maxH - 1) / (8 * d.maxH);
+            d.mcusY = (d.height + 8 * d.maxV - 1) / (8 * d.maxV);
+            for (int i = 0; i < d.componentCount; i++)
+            {
+                JpegComponent &c = d.components[i];
+                if (d.maxH % c.h || d.maxV % c.v)
+                    return fail("unsupported chroma subsampling");
+                c.blocksX = ((d.width * c.h + d.maxH - 1) / d.maxH + 7) / 8;
+                c.blocksY = ((d.height * c.v + d.maxV - 1) / d.maxV + 7) / 8;
+                c.stride = d.mcusX * c.h * 8;
+                c.plane.assign((size_t)c.stride * d.mcusY * c.v * 8, 0);
+            }
+            haveFrame = true;
+        }
+        else if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+            return fail("progressive, lossless or arithmetic JPEG");
+        else if (marker == 0xDD) // DRI
+        {
+            if (length != 4)
+                return fail("bad restart interval");
+            d.restartInterval = readBE16(segment);
+        }
+        else if (marker == 0xDA) // SOS
+        {
+            if (!haveFrame)
+                return fail("scan before frame header");
+            int scanCount = segment[0];
+            if (scanCount < 1 || scanCount > d.componentCount || length != 6 + 2 * scanCount)
+                return fail("bad scan header");
+            JpegComponent *scan[4];
+            for (int i = 0; i < scanCount; i++)
+            {
+                int id = segment[1 + i * 2], tables = segment[2 + i * 2];
+                scan[i] = 0;
+                for (int j = 0; j < d.componentCount; j++)
+                    if (d.components[j].id == id)
+                        scan[i] = &d.components[j];
+                if (!scan[i] || (tables >> 4) > 3 || (tables & 15) > 3)
+                    return fail("bad scan header");
+                scan[i]->dcTable = tables >> 4;
+                scan[i]->acTable = tables & 15;
+            }
+
+            d.bits.reset(segmentEnd);
+            if (!d.decodeScan(scan, scanCount, end))
+                return false;
+            p = d.bits.p;
+            haveScan = true;
+        }
+        // APPn, COM and the rest carry nothing we need
+    }
+
+    if (!haveScan)
+        return fail("JPEG has no image data");
+    d.output(image);
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include <stddef.h>
+#include <vector>
+
+// 8 bits per channel, rows top to bottom, channels interleaved
+struct DecodedImage
+{
+    int width, height;
+    int channels; // 1 gray, 2 gray + alpha, 3 RGB, 4 RGBA
+    std::vector<unsigned char> pixels;
+};
+
+// PNG and baseline JPEG decoding without external libraries.
+// PNG: every color type and bit depth, interlaced or not; 16-bit samples
+// keep their high byte and palettes expand to RGB(A). Inflate decodes
+// Huffman codes through a 10-bit lookup table and copies matches eight
+// bytes at a time, and the Up/Average filters run as straight loops the
+// compiler vectorizes.
+// JPEG: baseline and extended Huffman (SOF0/SOF1), any chroma subsampling,
+// restart markers; no progressive or arithmetic coding. A 9-bit Huffman
+// table, the integer IDCT of libjpeg's islow method with an all-zero AC
+// shortcut, and fixed-point YCbCr conversion.
+class ImageDecoder
+{
+public:
+    // Decodes a .png or .jpg file, picked by its signature; prints a
+    // warning and returns false if it can't
+    static bool load(const char *path, DecodedImage &image);
+
+    static bool decodePNG(const unsigned char *data, size_t size, DecodedImage &image);
+    static bool decodeJPEG(const unsigned char *data, size_t size, DecodedImage &image);
+
+    // Why the last decode failed, for messages
+    static const char *getError();
+};
+
+#endif
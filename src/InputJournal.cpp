@@ -0,0 +1,176 @@
+#include "InputJournal.h"
+#include "Platform.h"
+#include <string.h>
+
+static const char JOURNAL_MAGIC[4] = {'E', 'D', 'J', '1'};
+
+InputJournal::InputJournal()
+{
+    file = NULL;
+    lastRecordedTick = 0;
+    replaying = false;
+    cursor = 0;
+    lastTick = 0;
+    seed = 0;
+}
+
+InputJournal::~InputJournal()
+{
+    // A journal that was never finished still gets a valid end marker
+    finishRecording(lastRecordedTick);
+}
+
+bool InputJournal::startRecording(const char *path, uint64_t newSeed)
+{
+    finishRecording(lastRecordedTick);
+
+    file = fopen(path, "wb");
+    if (!file)
+    {
+        printf("Warning: could not open input journal %s for writing\n", path);
+        return false;
+    }
+
+    seed = newSeed;
+    lastRecordedTick = 0;
+
+    fwrite(JOURNAL_MAGIC, 1, sizeof(JOURNAL_MAGIC), file);
+    for (int i = 0; i < 8; i++)
+        fputc((int)((seed >> (i * 8)) & 0xFF), file);
+
+    return true;
+}
+
+void InputJournal::writeVarint(uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        fputc((int)((value & 0x7F) | 0x80), file);
+        value >>= 7;
+    }
+    fputc((int)value, file);
+}
+
+void InputJournal::record(const InputEvent &event)
+{
+    if (!file)
+        return;
+
+    writeVarint(event.tick - lastRecordedTick);
+    fputc(event.type, file);
+    fputc(event.key, file);
+    lastRecordedTick = event.tick;
+}
+
+void InputJournal::finishRecording(uint32_t endTick)
+{
+    if (!file)
+        return;
+
+    if (endTick < lastRecordedTick)
+        endTick = lastRecordedTick;
+
+    writeVarint(endTick - lastRecordedTick);
+    fputc(INPUT_END, file);
+
+    fclose(file);
+    file = NULL;
+}
+
+bool InputJournal::openReplay(const char *path)
+{
+    Platform::MappedFile mapped;
+    if (!Platform::mapFile(path, mapped))
+    {
+        printf("Warning: could not open input journal %s\n", path);
+        return false;
+    }
+    const unsigned char *data = mapped.data;
+    size_t size = mapped.size;
+
+    if (size < 12 || memcmp(data, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0)
+    {
+        printf("Warning: %s is not an input journal\n", path);
+        Platform::unmapFile(mapped);
+        return false;
+    }
+
+    seed = 0;
+    for (int i = 0; i < 8; i++)
+        seed |= (uint64_t)data[4 + i] << (i * 8);
+
+    events.clear();
+    size_t pos = 12;
+    uint32_t tick = 0;
+    bool ended = false;
+
+    while (pos < size && !ended)
+    {
+        // Varint tick delta
+        uint32_t delta = 0;
+        int shift = 0;
+        while (pos < size)
+        {
+            unsigned char b = data[pos++];
+            delta |= (uint32_t)(b & 0x7F) << shift;
+            shift += 7;
+            if (!(b & 0x80))
+                break;
+        }
+        tick += delta;
+
+        if (pos >= size)
+            break;
+
+        InputEvent e;
+        e.tick = tick;
+        e.type = data[pos++];
+        e.key = 0;
+
+        if (e.type == INPUT_END)
+        {
+            ended = true;
+            break;
+        }
+
+        if (pos >= size)
+            break;
+        e.key = data[pos++];
+        events.push_back(e);
+    }
+
+    Platform::unmapFile(mapped);
+
+    if (!ended)
+        printf("Warning: input journal %s is truncated, replaying what is there\n", path);
+
+    lastTick = tick;
+    cursor = 0;
+    replaying = true;
+
+    printf("Replaying %s: %d events over %u ticks, seed %llu\n", path, (int)events.size(),
+           lastTick, (unsigned long long)seed);
+    fflush(stdout);
+    return true;
+}
+
+bool InputJournal::nextEvent(uint32_t tick, InputEvent &out)
+{
+    if (!replaying || cursor >= events.size() || events[cursor].tick > tick)
+        return false;
+
+    out = events[cursor++];
+    return true;
+}
+
+bool InputJournal::isReplayFinished(uint32_t tick) const
+{
+    return replaying && cursor >= events.size() && tick >= lastTick;
+}
+
+void InputJournal::stopReplay()
+{
+    replaying = false;
+    events.clear();
+    cursor = 0;
+}
@@ -0,0 +1,67 @@
+#ifndef INPUT_JOURNAL_H
+#define INPUT_JOURNAL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+enum InputEventType
+{
+    INPUT_KEY = 0,          // ASCII key press (lights, cheats, Enter)
+    INPUT_SPECIAL_DOWN = 1, // Arrow key pressed
+    INPUT_SPECIAL_UP = 2,   // Arrow key released
+    INPUT_MOUSE = 3,        // Mouse button pressed (camera toggle)
+    INPUT_END = 0xFF        // End of journal, tick = last simulated tick
+};
+
+struct InputEvent
+{
+    uint32_t tick; // Simulation tick the event is applied on
+    uint8_t type;  // InputEventType
+    uint8_t key;   // Key / button code
+};
+
+// Records tick-stamped input events and the traffic seed to a compact binary
+// file, and plays them back so a run can be reproduced exactly.
+//
+// File layout (little endian):
+//   "EDJ1"      magic
+//   u64         seed
+//   events...   varint tick delta, u8 type, u8 key
+//   end marker  varint tick delta, u8 INPUT_END
+class InputJournal
+{
+public:
+    InputJournal();
+    ~InputJournal();
+
+    // Recording
+    bool startRecording(const char *path, uint64_t seed);
+    void record(const InputEvent &event);
+    void finishRecording(uint32_t lastTick);
+
+    // Playback, the whole journal is read into memory up front
+    bool openReplay(const char *path);
+    bool nextEvent(uint32_t tick, InputEvent &out);
+    bool isReplayFinished(uint32_t tick) const;
+    uint32_t getLastTick() const { return lastTick; }
+    void stopReplay();
+
+    bool isRecording() const { return file != NULL; }
+    bool isReplaying() const { return replaying; }
+    uint64_t getSeed() const { return seed; }
+
+private:
+    FILE *file;
+    uint32_t lastRecordedTick;
+
+    bool replaying;
+    std::vector<InputEvent> events;
+    size_t cursor;
+    uint32_t lastTick;
+    uint64_t seed;
+
+    void writeVarint(uint32_t value);
+};
+
+#endif
@@ -0,0 +1,158 @@
+#include "JobSystem.h"
+#include <chrono>
+
+// Which pool the current thread works for, and its index there
+static thread_local const JobSystem *threadPool = NULL;
+static thread_local int threadIndex = -1;
+
+JobSystem::JobSystem(int workerCount)
+{
+    if (workerCount < 0)
+    {
+        int cores = (int)std::thread::hardware_concurrency();
+        workerCount = cores > 1 ? cores - 1 : 0;
+    }
+
+    queued = 0;
+    running = true;
+
+    for (int i = 0; i < workerCount; i++)
+        workers.push_back(new Worker());
+    for (int i = 0; i < workerCount; i++)
+        workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        running = false;
+    }
+    wake.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i]->thread.join();
+        delete workers[i];
+    }
+}
+
+int JobSystem::currentWorker() const
+{
+    return threadPool == this ? threadIndex : -1;
+}
+
+void JobSystem::run(JobFunction fn, void *data, int begin, int end, Counter *counter)
+{
+    Job job;
+    job.fn = fn;
+    job.data = data;
+    job.begin = begin;
+    job.end = end;
+    job.counter = counter;
+
+    if (counter)
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+    int self = currentWorker();
+    if (self >= 0)
+    {
+        std::lock_guard<std::mutex> guard(workers[self]->lock);
+        workers[self]->jobs.push_back(job);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> guard(sharedLock);
+        shared.push_back(job);
+    }
+
+    if (queued.fetch_add(1, std::memory_order_release) == 0)
+    {
+        std::lock_guard<std::mutex> guard(sleepLock); // Pairs with the predicate check
+    }
+    wake.notify_one();
+}
+
+bool JobSystem::popJob(int self, Job &job)
+{
+    if (queued.load(std::memory_order_acquire) == 0)
+        return false;
+
+    // Own deque first, newest job (still warm in cache)
+    if (self >= 0)
+    {
+        Worker &w = *workers[self];
+        std::lock_guard<std::mutex> guard(w.lock);
+        if (!w.jobs.empty())
+        {
+            job = w.jobs.back();
+            w.jobs.pop_back();
+            return true;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(sharedLock);
+        if (!shared.empty())
+        {
+            job = shared.front();
+            shared.pop_front();
+            return true;
+        }
+    }
+
+    // Steal the oldest job of another worker, usually the biggest remaining piece
+    int count = (int)workers.size();
+    int start = self >= 0 ? self + 1 : 0;
+    for (int n = 0; n < count; n++)
+    {
+        Worker &victim = *workers[(start + n) % count];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.jobs.empty())
+        {
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::tryRunOne(int self)
+{
+    Job job;
+    if (!popJob(self, job))
+        return false;
+
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    job.fn(job.data, job.begin, job.end);
+    if (job.counter)
+        job.counter->pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::wait(Counter &counter)
+{
+    int self = currentWorker();
+    while (!counter.isDone())
+    {
+        if (!tryRunOne(self))
+            std::this_thread::yield(); // Remaining jobs are running elsewhere
+    }
+}
+
+void JobSystem::workerLoop(int index)
+{
+    threadPool = this;
+    threadIndex = index;
+
+    while (running.load(std::memory_order_relaxed))
+    {
+        if (tryRunOne(index))
+            continue;
+
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait_for(guard, std::chrono::milliseconds(2), [this]
+                      { return queued.load(std::memory_order_acquire) > 0 || !running.load(); });
+    }
+}
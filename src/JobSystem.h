@@ -0,0 +1,108 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing scheduler for per-tick loops.
+//
+// A fixed pool of workers each own a deque: a worker pushes and pops its
+// own jobs at the back (newest first, cache friendly) and steals from the
+// front of the others when it runs dry. Threads outside the pool submit
+// through a shared queue. Every job decrements a Counter when it finishes;
+// wait() on a counter is the dependency point, and the waiting thread runs
+// jobs itself instead of sleeping, so a pool of zero workers still works.
+class JobSystem
+{
+public:
+    typedef void (*JobFunction)(void *data, int begin, int end);
+
+    class Counter
+    {
+    public:
+        Counter() : pending(0) {}
+        bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class JobSystem;
+        std::atomic<int> pending;
+    };
+
+    // workers < 0 picks one per core, leaving a core for the calling thread
+    explicit JobSystem(int workers = -1);
+    ~JobSystem();
+
+    int getWorkerCount() const { return (int)workers.size(); }
+
+    // Queues fn(data, begin, end); counter may be NULL for fire-and-forget
+    void run(JobFunction fn, void *data, int begin, int end, Counter *counter);
+
+    // Returns once every job counted by counter has finished
+    void wait(Counter &counter);
+
+    // Calls body(first, last) over [begin, end) in chunks of about grain items.
+    // Blocks until all chunks are done; the caller runs chunks too.
+    template <typename F>
+    void parallelFor(int begin, int end, int grain, const F &body)
+    {
+        if (grain < 1)
+            grain = 1;
+        if (end - begin <= grain || workers.empty())
+        {
+            if (end > begin)
+                body(begin, end);
+            return;
+        }
+
+        Counter counter;
+        for (int first = begin + grain; first < end; first += grain)
+        {
+            int last = first + grain < end ? first + grain : end;
+            run(&invokeRange<F>, (void *)&body, first, last, &counter);
+        }
+        body(begin, begin + grain);
+        wait(counter);
+    }
+
+private:
+    struct Job
+    {
+        JobFunction fn;
+        void *data;
+        int begin, end;
+        Counter *counter;
+    };
+
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<Job> jobs;
+        std::thread thread;
+    };
+
+    std::vector<Worker *> workers;
+    std::mutex sharedLock;
+    std::deque<Job> shared; // Jobs submitted from outside the pool
+
+    std::atomic<int> queued; // Jobs waiting in any deque
+    std::atomic<bool> running;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+
+    template <typename F>
+    static void invokeRange(void *data, int begin, int end)
+    {
+        (*(const F *)data)(begin, end);
+    }
+
+    int currentWorker() const;
+    bool popJob(int self, Job &job);
+    bool tryRunOne(int self);
+    void workerLoop(int index);
+};
+
+#endif
@@ -2,34 +2,56 @@
 #define LEVEL_H
 
 #include "Car.h"
+#include "Random.h"
 
-#include "Car.h"
-
-struct Obstacle
-{
-    float x, z;
-    float width, length;
-    float speed;
-    bool active;
-
-    // Smart behavior
-    float targetX;
-    bool isMovingAside;
-    float originalX;
-
-    // Random color (0 = red, 1 = yellow, 2 = orange)
-    int colorIndex;
-};
+struct GameSnapshot;
 
 class Level
 {
 public:
+    Level() : pickups(0) {}
     virtual ~Level() {}
     virtual void init() = 0;
     virtual void update() = 0;
     virtual void render(Car &car, bool isNight) = 0;
     virtual bool checkCollisions(Car &car) = 0;
     virtual bool isFinished(Car &car) = 0;
+
+    // Loads models and textures, GL thread only. init() never touches OpenGL
+    // so the simulation copy of a level can live on another thread.
+    virtual void loadAssets() {}
+
+    // Queues this frame's level lights (street lamps) with Lighting, before render()
+    virtual void addLights(Car & /*car*/, bool /*isNight*/) {}
+
+    // Picks what this frame draws, once before the shadow passes and
+    // render() so they all reuse it
+    virtual void prepareFrame(Car & /*car*/) {}
+
+    // Draws what casts shadows, depth only, in world space: the geometry
+    // that never moves (kept by Shadows across frames) or what does. The
+    // player's car is not the level's to draw.
+    virtual void drawShadowCasters(Car & /*car*/, bool /*staticGeometry*/) {}
+
+    // Copy what render() needs into a snapshot, and back into a render-side level
+    virtual void capture(GameSnapshot &snapshot) const = 0;
+    virtual void apply(const GameSnapshot &snapshot) = 0;
+
+    // Seeds this level's private random stream; call before init()
+    void setSeed(uint64_t seed) { rng.seed(seed); }
+    uint64_t getSeed() const { return rng.getSeed(); }
+
+    // Power-ups collected since the last call, for sound effects
+    int takePickups()
+    {
+        int n = pickups;
+        pickups = 0;
+        return n;
+    }
+
+protected:
+    Random rng;
+    int pickups;
 };
 
 #endif
@@ -1,18 +1,38 @@
 #include "Level1.h"
+#include "GameSnapshot.h"
+#include "Lighting.h"
+#include "Profiler.h"
+#include "Transparency.h"
 #include <GL/glut.h>
-#include <cstdlib>
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 
+static const float TICK_SECONDS = 0.016f; // checkCollisions() runs once per 16 ms sim tick
+static const float NO_TRAFFIC_SECONDS = 5.0f;
+static const float SPEED_BOOST_SECONDS = 3.0f;
+static const float GRASS_CELL = 10.0f; // Grass is drawn and occlusion tested in squares this big
+
+// Traffic and power-up models are bigger than their colliders; boxes this
+// far around an entity's position hold any of them
+static const float ENTITY_REACH = 3.0f;
+static const float ENTITY_HEIGHT = 4.0f;
+
+static const float LAMP_BEAM_COLOR[4] = {1.0f, 1.0f, 0.8f, 0.15f}; // More transparent (was 0.3)
+
 Level1::Level1()
 {
-    roadLength = 200.0f;
-    roadWidth = 20.0f;
+    jobs = nullptr;
+    pickupsByType[0] = 0;
+    pickupsByType[1] = 0;
     wasLightsOn = false;
-    noTrafficTimer = 0.0f;
+    simTick = 0;
+    noTrafficEnd = 0;
     noTrafficActive = false;
-    speedBoostTimer = 0.0f;
+    noTrafficTimer = TimerWheel::NO_TIMER;
+    speedBoostEnd = 0;
     speedBoostActive = false;
+    speedBoostTimer = TimerWheel::NO_TIMER;
     animationTime = 0.0f;
     obstacleModelLoaded = false;
     noTrafficModelLoaded = false;
@@ -21,9 +41,41 @@ Level1::Level1()
 
 void Level1::init()
 {
-    cars.clear();
-    powerups.clear();
+    entities.clear();
+    trafficSystem.configure(road.width, road.laneWidth);
+    pickupsByType[0] = 0;
+    pickupsByType[1] = 0;
+
+    timers.clear();
+    simTick = 0;
+    noTrafficActive = false;
+    noTrafficTimer = TimerWheel::NO_TIMER;
+    speedBoostActive = false;
+    speedBoostTimer = TimerWheel::NO_TIMER;
+
+    // Spawn some initial cars
+    for (int i = 0; i < road.trafficSize; i++)
+    {
+        spawnCar(rng);
+    }
+
+    // Spawn powerups (drawn in one batch per attribute)
+    const int numPowerups = road.powerupCount;
+    const int spread = spawnSpread();
+    std::vector<int> xs(numPowerups), zs(numPowerups), types(numPowerups);
+    rng.fillInts(xs.data(), numPowerups, spread);
+    rng.fillInts(zs.data(), numPowerups, (int)road.length);
+    rng.fillInts(types.data(), numPowerups, 2);
+
+    for (int i = 0; i < numPowerups; i++)
+    {
+        // Strictly on road (-8 to 8 on the default road)
+        spawnPowerup(xs[i] - spread / 2.0f, zs[i] + 20.0f, types[i]);
+    }
+}
 
+void Level1::loadAssets()
+{
     // Load obstacle car 3D model (only once)
     if (!obstacleModelLoaded)
     {
@@ -110,50 +162,87 @@ void Level1::init()
             fflush(stdout);
         }
     }
+}
 
-    noTrafficTimer = 0.0f;
-    noTrafficActive = false;
-    speedBoostTimer = 0.0f;
-    speedBoostActive = false;
+void Level1::capture(GameSnapshot &snapshot) const
+{
+    Level1State &state = snapshot.level1;
+    snapshot.level = 1;
+    state.entities = entities; // Reuses the snapshot's capacity, no allocation once warmed up
+    state.simTick = simTick;
+    state.noTrafficEnd = noTrafficEnd;
+    state.noTrafficActive = noTrafficActive;
+    state.speedBoostEnd = speedBoostEnd;
+    state.speedBoostActive = speedBoostActive;
+}
 
-    // Spawn some initial cars
-    for (int i = 0; i < 10; i++)
-    {
-        spawnCar();
-    }
+void Level1::apply(const GameSnapshot &snapshot)
+{
+    const Level1State &state = snapshot.level1;
+    entities = state.entities;
+    simTick = state.simTick;
+    noTrafficEnd = state.noTrafficEnd;
+    noTrafficActive = state.noTrafficActive;
+    speedBoostEnd = state.speedBoostEnd;
+    speedBoostActive = state.speedBoostActive;
+}
 
-    // Spawn powerups
-    for (int i = 0; i < 5; i++)
-    {
-        Collectible c;
-        c.x = ((rand() % 16) - 8.0f); // Strictly on road (-8 to 8)
-        c.z = (rand() % (int)roadLength) + 20;
-        c.type = rand() % 2;
-        c.active = true;
-        c.rotation = 0;
-        powerups.push_back(c);
-    }
+// Power-up type to the model it is drawn with
+static int powerupKind(int type)
+{
+    return type == 0 ? RENDER_NO_TRAFFIC : RENDER_BOOST;
+}
+
+void Level1::spawnCar(Random &random)
+{
+    // Traffic slots start inactive, checkCollisions() places them ahead of the player
+    Entity e = entities.create();
+    entities.setActive(e, false);
+
+    Transform t;
+    t.x = random.nextInt((int)road.width) - (road.width / 2);
+    t.z = 0; // Placeholder, set in update
+    t.rotation = 0;
+    entities.transforms.add(e, t);
+
+    Velocity v;
+    v.speed = road.traffic.minSpeed + (random.nextInt(road.traffic.speedSteps) / 100.0f); // Slower speed (0.05 - 0.1)
+    entities.velocities.add(e, v);
+
+    Collider c;
+    c.width = 1.2f;  // Reduced hitbox width for tighter collision
+    c.length = 2.5f; // Reduced hitbox length for tighter collision
+    entities.colliders.add(e, c);
+
+    Renderable r;
+    r.kind = RENDER_TRAFFIC_CAR;
+    r.colorIndex = random.nextInt(3); // Random: 0=red, 1=yellow, 2=orange
+    entities.renderables.add(e, r);
+
+    AIDriver ai;
+    ai.lane = 0;
+    ai.desiredSpeed = v.speed;
+    ai.cooldown = 0;
+    ai.targetX = 0;
+    ai.isMovingAside = false;
+    entities.drivers.add(e, ai);
 }
 
-void Level1::spawnCar()
+void Level1::spawnPowerup(float x, float z, int type)
 {
-    Obstacle car;
-    car.x = (rand() % (int)roadWidth) - (roadWidth / 2);
-    // Spawn ahead of the player (we need player Z, but here we just spawn relative to "current" road end?)
-    // Better: Spawn relative to a "spawnZ" we track, or just far ahead.
-    // For now, let's just spawn randomly in a range.
-    car.z = 0;                                   // Placeholder, set in update
-    car.width = 1.2f;                            // Reduced hitbox width for tighter collision
-    car.length = 2.5f;                           // Reduced hitbox length for tighter collision
-    car.speed = 0.05f + ((rand() % 5) / 100.0f); // Slower speed (0.05 - 0.1)
-    car.active = false;                          // Inactive until placed
-
-    car.targetX = 0;
-    car.isMovingAside = false;
-    car.originalX = 0;
-    car.colorIndex = rand() % 3; // Random: 0=red, 1=yellow, 2=orange
-
-    cars.push_back(car);
+    Entity e = entities.create();
+
+    Transform t = {x, z, 0.0f};
+    entities.transforms.add(e, t);
+
+    Collider c = {1.0f, 1.0f}; // Picked up within 1.5 of the player's centre
+    entities.colliders.add(e, c);
+
+    Renderable r = {powerupKind(type), 0};
+    entities.renderables.add(e, r);
+
+    Pickup p = {type};
+    entities.pickups.add(e, p);
 }
 
 void Level1::update()
@@ -170,26 +259,23 @@ void Level1::update()
 
 void Level1::render(Car &car, bool isNight)
 {
+    PROFILE_GPU_ZONE("Level1::render");
+
     float playerZ = car.getZ();
 
+    // Everything but the road can hide behind the rows of buildings
+    buildOccluders(playerZ);
+
     // Infinite Road Logic
     // Draw road from [playerZ - 50] to [playerZ + 200]
     drawRoad(playerZ);
     drawGround(playerZ);
     drawBuildings(playerZ);
-    drawLampPosts(playerZ, isNight);
-
-    // Update/Spawn Obstacles based on playerZ (Hack: doing logic in render or separate update)
-    // Ideally logic should be in update.
-    // Let's fix the update signature first.
-    drawLampPosts(playerZ, isNight);
+    drawLampPosts(playerZ, isNight, &occlusion);
+    drawEntities(&occlusion); // Culled by prepareFrame()
 
-    // Update/Spawn Obstacles based on playerZ (Hack: doing logic in render or separate update)
-    // Ideally logic should be in update.
-    // Let's fix the update signature first.
-
-    drawObstacles();
-    drawCollectibles();
+    PROFILE_STAT("Occlusion tested", occlusion.getStats().tested);
+    PROFILE_STAT("Occlusion culled", occlusion.getStats().culled);
 
     // Update animation time (approx 60 FPS)
     animationTime += 0.05f;
@@ -197,7 +283,7 @@ void Level1::render(Car &car, bool isNight)
     // Draw No Traffic Timer
     if (noTrafficActive)
     {
-        glDisable(GL_LIGHTING);
+        Lighting::disable();
         glMatrixMode(GL_PROJECTION);
         glPushMatrix();
         glLoadIdentity();
@@ -209,8 +295,7 @@ void Level1::render(Car &car, bool isNight)
         glColor3f(1.0f, 1.0f, 0.0f); // Yellow
         // Format time to 1 decimal place
         char timeBuffer[32];
-        sprintf(timeBuffer, "No Traffic: %.1fs", noTrafficTimer);
-        // std::string timeStr = "No Traffic: " + std::to_string(noTrafficTimer).substr(0, 3) + "s";
+        sprintf(timeBuffer, "No Traffic: %.1fs", secondsLeft(noTrafficEnd));
 
         glRasterPos2f(300, 550); // Top center-ish
         for (char *c = timeBuffer; *c != '\0'; c++)
@@ -222,13 +307,13 @@ void Level1::render(Car &car, bool isNight)
         glMatrixMode(GL_PROJECTION);
         glPopMatrix();
         glMatrixMode(GL_MODELVIEW);
-        glEnable(GL_LIGHTING);
+        Lighting::enable();
     }
 
     // Draw Speed Boost Timer
     if (speedBoostActive)
     {
-        glDisable(GL_LIGHTING);
+        Lighting::disable();
         glMatrixMode(GL_PROJECTION);
         glPushMatrix();
         glLoadIdentity();
@@ -239,7 +324,7 @@ void Level1::render(Car &car, bool isNight)
 
         glColor3f(0.0f, 1.0f, 1.0f); // Cyan
         char timeBuffer[32];
-        sprintf(timeBuffer, "Speed Boost: %.1fs", speedBoostTimer);
+        sprintf(timeBuffer, "Speed Boost: %.1fs", secondsLeft(speedBoostEnd));
 
         glRasterPos2f(300, 520); // Slightly below No Traffic
         for (char *c = timeBuffer; *c != '\0'; c++)
@@ -251,12 +336,14 @@ void Level1::render(Car &car, bool isNight)
         glMatrixMode(GL_PROJECTION);
         glPopMatrix();
         glMatrixMode(GL_MODELVIEW);
-        glEnable(GL_LIGHTING);
+        Lighting::enable();
     }
 }
 
 void Level1::drawRoad(float playerZ)
 {
+    PROFILE_GPU_ZONE("Level1::drawRoad");
+
     float startZ = floor(playerZ / 10.0f) * 10.0f - 50.0f;
     float endZ = startZ + 300.0f;
 
@@ -264,402 +351,417 @@ void Level1::drawRoad(float playerZ)
     glColor3f(0.2f, 0.2f, 0.2f);
     glBegin(GL_QUADS);
     glNormal3f(0, 1, 0);
-    glVertex3f(-roadWidth / 2, 0.01f, startZ);
-    glVertex3f(roadWidth / 2, 0.01f, startZ);
-    glVertex3f(roadWidth / 2, 0.01f, endZ);
-    glVertex3f(-roadWidth / 2, 0.01f, endZ);
+    glVertex3f(-road.width / 2, 0.01f, startZ);
+    glVertex3f(road.width / 2, 0.01f, startZ);
+    glVertex3f(road.width / 2, 0.01f, endZ);
+    glVertex3f(-road.width / 2, 0.01f, endZ);
     glEnd();
 
-    // Lane markings
+    // Lane markings between the traffic lanes
     glColor3f(1.0f, 1.0f, 1.0f);
     glBegin(GL_QUADS);
-    for (float z = startZ; z < endZ; z += 10.0f)
+    for (int lane = 1; lane < trafficSystem.getLaneCount(); lane++)
     {
-        glVertex3f(-0.2f, 0.02f, z);
-        glVertex3f(0.2f, 0.02f, z);
-        glVertex3f(0.2f, 0.02f, z + 5.0f);
-        glVertex3f(-0.2f, 0.02f, z + 5.0f);
+        float x = (trafficSystem.laneCenter(lane - 1) + trafficSystem.laneCenter(lane)) / 2;
+        for (float z = startZ; z < endZ; z += 10.0f)
+        {
+            glVertex3f(x - 0.2f, 0.02f, z);
+            glVertex3f(x + 0.2f, 0.02f, z);
+            glVertex3f(x + 0.2f, 0.02f, z + 5.0f);
+            glVertex3f(x - 0.2f, 0.02f, z + 5.0f);
+        }
     }
     glEnd();
 }
 
 void Level1::drawBuildings(float playerZ)
 {
-    float startZ = floor(playerZ / 30.0f) * 30.0f - 60.0f;
+    PROFILE_GPU_ZONE("Level1::drawBuildings");
+
+    float spacing = road.buildingSpacing;
+    float startZ = floor(playerZ / spacing) * spacing - 2 * spacing;
     float endZ = startZ + 300.0f;
+    float sideX = road.width / 2 + road.buildingGap;
 
     glColor3f(0.6f, 0.5f, 0.4f);
-    for (float z = startZ; z < endZ; z += 30.0f)
+    for (float z = startZ; z < endZ; z += spacing)
     {
         // Left side
         glPushMatrix();
-        glTranslatef(-roadWidth / 2 - 10, 5.0f, z);
-        glScalef(10.0f, 10.0f, 20.0f);
+        glTranslatef(-sideX, road.buildingHeight / 2, z);
+        glScalef(road.buildingWidth, road.buildingHeight, road.buildingLength);
         glutSolidCube(1.0f);
         glPopMatrix();
 
         // Right side
         glPushMatrix();
-        glTranslatef(roadWidth / 2 + 10, 5.0f, z);
-        glScalef(10.0f, 10.0f, 20.0f);
+        glTranslatef(sideX, road.buildingHeight / 2, z);
+        glScalef(road.buildingWidth, road.buildingHeight, road.buildingLength);
         glutSolidCube(1.0f);
         glPopMatrix();
     }
 }
 
-void Level1::drawObstacles()
+// The boxes drawBuildings() draws, as this frame's camera sees them
+void Level1::buildOccluders(float playerZ)
 {
-    for (const auto &car : cars)
+    PROFILE_ZONE("Level1::buildOccluders");
+
+    float spacing = road.buildingSpacing;
+    float startZ = floor(playerZ / spacing) * spacing - 2 * spacing;
+    float endZ = startZ + 300.0f;
+    float sideX = road.width / 2 + road.buildingGap;
+
+    occlusion.begin();
+    for (float z = startZ; z < endZ; z += spacing)
     {
-        if (!car.active)
+        for (int side = -1; side <= 1; side += 2)
+        {
+            float boxMin[3] = {side * sideX - road.buildingWidth / 2, 0.0f, z - road.buildingLength / 2};
+            float boxMax[3] = {side * sideX + road.buildingWidth / 2, road.buildingHeight, z + road.buildingLength / 2};
+            occlusion.addOccluder(boxMin, boxMax);
+        }
+    }
+    occlusion.finish();
+}
+
+// Entities cullEntities() kept, less those behind occluders when given
+void Level1::drawEntities(OcclusionBuffer *occluders)
+{
+    PROFILE_GPU_ZONE("Level1::drawEntities");
+
+    const ComponentArray<Renderable> &renderables = entities.renderables;
+    for (size_t i = 0; i < renderables.size(); i++)
+    {
+        if (!visible[i])
             continue;
 
-        glPushMatrix();
-        glTranslatef(car.x, 1.0f, car.z);
+        Entity e = renderables.entity(i);
+        const Renderable &r = renderables[i];
+        const Transform &t = entities.transforms.get(e);
+        if (occluders)
+        {
+            float boxMin[3] = {t.x - ENTITY_REACH, 0.0f, t.z - ENTITY_REACH};
+            float boxMax[3] = {t.x + ENTITY_REACH, ENTITY_HEIGHT, t.z + ENTITY_REACH};
+            if (occluders->isHidden(boxMin, boxMax))
+                continue;
+        }
+        if (r.kind == RENDER_TRAFFIC_CAR)
+            drawTrafficCar(t, r.colorIndex, entities.colliders.get(e));
+        else
+            drawPowerup(t, r);
+    }
+}
 
-        if (obstacleModelLoaded)
+void Level1::drawTrafficCar(const Transform &t, int colorIndex, const Collider &c)
+{
+    glPushMatrix();
+    glTranslatef(t.x, 1.0f, t.z);
+
+    if (obstacleModelLoaded)
+    {
+        // Enable lighting for the 3D model
+        Lighting::enable();
+
+        // Enable textures in case the model has them
+        glEnable(GL_TEXTURE_2D);
+
+        // Set up metallic/shiny material properties
+        GLfloat matSpecular[] = {1.0f, 1.0f, 1.0f, 1.0f};
+        GLfloat matShininess[] = {100.0f};
+
+        // Set color based on car's random colorIndex (0=red, 1=yellow, 2=orange)
+        GLfloat matAmbient[4];
+        float r, g, b;
+        switch (colorIndex)
         {
-            // Enable lighting for the 3D model
-            glEnable(GL_LIGHTING);
+        case 0: // Red
+            r = 0.9f;
+            g = 0.1f;
+            b = 0.1f;
+            matAmbient[0] = 0.3f;
+            matAmbient[1] = 0.05f;
+            matAmbient[2] = 0.05f;
+            matAmbient[3] = 1.0f;
+            break;
+        case 1: // Yellow
+            r = 1.0f;
+            g = 0.9f;
+            b = 0.1f;
+            matAmbient[0] = 0.3f;
+            matAmbient[1] = 0.3f;
+            matAmbient[2] = 0.05f;
+            matAmbient[3] = 1.0f;
+            break;
+        case 2: // Orange
+        default:
+            r = 1.0f;
+            g = 0.5f;
+            b = 0.1f;
+            matAmbient[0] = 0.3f;
+            matAmbient[1] = 0.15f;
+            matAmbient[2] = 0.05f;
+            matAmbient[3] = 1.0f;
+            break;
+        }
 
-            // Enable textures in case the model has them
-            glEnable(GL_TEXTURE_2D);
+        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular);
+        glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, matShininess);
+        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient);
 
-            // Set up metallic/shiny material properties
-            GLfloat matSpecular[] = {1.0f, 1.0f, 1.0f, 1.0f};
-            GLfloat matShininess[] = {100.0f};
+        // Set the car's color
+        glColor3f(r, g, b);
 
-            // Set color based on car's random colorIndex (0=red, 1=yellow, 2=orange)
-            GLfloat matAmbient[4];
-            float r, g, b;
-            switch (car.colorIndex)
-            {
-            case 0: // Red
-                r = 0.9f;
-                g = 0.1f;
-                b = 0.1f;
-                matAmbient[0] = 0.3f;
-                matAmbient[1] = 0.05f;
-                matAmbient[2] = 0.05f;
-                matAmbient[3] = 1.0f;
-                break;
-            case 1: // Yellow
-                r = 1.0f;
-                g = 0.9f;
-                b = 0.1f;
-                matAmbient[0] = 0.3f;
-                matAmbient[1] = 0.3f;
-                matAmbient[2] = 0.05f;
-                matAmbient[3] = 1.0f;
-                break;
-            case 2: // Orange
-            default:
-                r = 1.0f;
-                g = 0.5f;
-                b = 0.1f;
-                matAmbient[0] = 0.3f;
-                matAmbient[1] = 0.15f;
-                matAmbient[2] = 0.05f;
-                matAmbient[3] = 1.0f;
-                break;
-            }
+        // Rotate to face correct direction (180 - 90 = 90 degrees)
+        glRotatef(90.0f, 0, 1, 0);
+
+        obstacleCarModel.Draw();
+
+        // Reset material properties
+        GLfloat defaultSpecular[] = {0.0f, 0.0f, 0.0f, 1.0f};
+        GLfloat defaultShininess[] = {0.0f};
+        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, defaultSpecular);
+        glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, defaultShininess);
+    }
+    else
+    {
+        // Fallback to simple cube if model not loaded
+        glColor3f(0.0f, 0.0f, 0.8f); // Blue cars
+        glScalef(c.width, 1.5f, c.length);
+        glutSolidCube(1.0f);
+    }
+
+    glPopMatrix();
+}
+
+void Level1::drawPowerup(const Transform &t, const Renderable &r)
+{
+    glPushMatrix();
+
+    if (r.kind == RENDER_NO_TRAFFIC)
+    { // No Traffic power-up
+        // Floating animation
+        float offset = 0.2f * sin(animationTime);
+        glTranslatef(t.x, 1.5f + offset, t.z);
+        glRotatef(t.rotation, 0, 1, 0);
+
+        if (noTrafficModelLoaded)
+        {
+            Lighting::enable();
+            glEnable(GL_TEXTURE_2D);
+            glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+            // Yellow material for No Traffic
+            GLfloat matSpecular[] = {1.0f, 1.0f, 0.5f, 1.0f};
+            GLfloat matShininess[] = {80.0f};
+            GLfloat matAmbient[] = {0.6f, 0.5f, 0.0f, 1.0f};
+            GLfloat matDiffuse[] = {1.0f, 0.9f, 0.0f, 1.0f};
+            GLfloat matEmission[] = {0.3f, 0.25f, 0.0f, 1.0f};
 
             glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular);
             glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, matShininess);
             glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient);
+            glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse);
+            glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, matEmission);
 
-            // Set the car's color
-            glColor3f(r, g, b);
-
-            // Rotate to face correct direction (180 - 90 = 90 degrees)
-            glRotatef(90.0f, 0, 1, 0);
+            glColor3f(1.0f, 0.9f, 0.0f);
+            noTrafficModel.Draw();
 
-            obstacleCarModel.Draw();
-
-            // Reset material properties
-            GLfloat defaultSpecular[] = {0.0f, 0.0f, 0.0f, 1.0f};
-            GLfloat defaultShininess[] = {0.0f};
-            glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, defaultSpecular);
-            glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, defaultShininess);
+            // Reset material
+            GLfloat defaultEmission[] = {0.0f, 0.0f, 0.0f, 1.0f};
+            glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, defaultEmission);
         }
         else
         {
-            // Fallback to simple cube if model not loaded
-            glColor3f(0.0f, 0.0f, 0.8f); // Blue cars
-            glScalef(car.width, 1.5f, car.length);
+            // Fallback
+            glColor3f(1.0f, 1.0f, 0.0f);
+            float scale = 1.0f + 0.2f * sin(animationTime);
+            glScalef(scale, scale, scale);
             glutSolidCube(1.0f);
         }
-
-        glPopMatrix();
     }
-}
+    else
+    { // Boost power-up
+        // Floating animation
+        float offset = 0.2f * sin(animationTime);
+        glTranslatef(t.x, 2.0f + offset, t.z);
+        glRotatef(t.rotation, 0, 1, 0);
+
+        if (boostModelLoaded)
+        {
+            Lighting::enable();
+            glEnable(GL_TEXTURE_2D);
+            glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
 
-void Level1::drawCollectibles()
-{
-    for (const auto &p : powerups)
-    {
-        if (!p.active)
-            continue;
+            // Cyan material for Boost
+            GLfloat matSpecular[] = {1.0f, 1.0f, 1.0f, 1.0f};
+            GLfloat matShininess[] = {80.0f};
+            GLfloat matAmbient[] = {0.0f, 0.6f, 0.6f, 1.0f};
+            GLfloat matDiffuse[] = {0.0f, 1.0f, 1.0f, 1.0f};
+            GLfloat matEmission[] = {0.0f, 0.3f, 0.3f, 1.0f};
 
-        glPushMatrix();
+            glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular);
+            glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, matShininess);
+            glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient);
+            glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse);
+            glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, matEmission);
 
-        if (p.type == 0)
-        { // No Traffic power-up
-            // Floating animation
-            float offset = 0.2f * sin(animationTime);
-            glTranslatef(p.x, 1.5f + offset, p.z);
-            glRotatef(p.rotation, 0, 1, 0);
+            glColor3f(0.0f, 1.0f, 1.0f);
 
-            if (noTrafficModelLoaded)
-            {
-                glEnable(GL_LIGHTING);
-                glEnable(GL_TEXTURE_2D);
-                glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-
-                // Yellow material for No Traffic
-                GLfloat matSpecular[] = {1.0f, 1.0f, 0.5f, 1.0f};
-                GLfloat matShininess[] = {80.0f};
-                GLfloat matAmbient[] = {0.6f, 0.5f, 0.0f, 1.0f};
-                GLfloat matDiffuse[] = {1.0f, 0.9f, 0.0f, 1.0f};
-                GLfloat matEmission[] = {0.3f, 0.25f, 0.0f, 1.0f};
-
-                glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular);
-                glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, matShininess);
-                glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient);
-                glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse);
-                glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, matEmission);
-
-                glColor3f(1.0f, 0.9f, 0.0f);
-                noTrafficModel.Draw();
-
-                // Reset material
-                GLfloat defaultEmission[] = {0.0f, 0.0f, 0.0f, 1.0f};
-                glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, defaultEmission);
-            }
-            else
-            {
-                // Fallback
-                glColor3f(1.0f, 1.0f, 0.0f);
-                float scale = 1.0f + 0.2f * sin(animationTime);
-                glScalef(scale, scale, scale);
-                glutSolidCube(1.0f);
-            }
+            // Rotate 180 degrees to face correct direction
+            glRotatef(180.0f, 0, 1, 0);
+
+            // Draw first arrow
+            glPushMatrix();
+            glTranslatef(0.0f, 0.0f, -1.0f);
+            boostModel.Draw();
+            glPopMatrix();
+
+            // Draw second arrow (double-arrow effect)
+            glPushMatrix();
+            glTranslatef(0.0f, 0.0f, 1.0f);
+            boostModel.Draw();
+            glPopMatrix();
+
+            // Reset material
+            GLfloat defaultEmission[] = {0.0f, 0.0f, 0.0f, 1.0f};
+            glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, defaultEmission);
         }
         else
-        { // Boost power-up
-            // Floating animation
-            float offset = 0.2f * sin(animationTime);
-            glTranslatef(p.x, 2.0f + offset, p.z);
-            glRotatef(p.rotation, 0, 1, 0);
-
-            if (boostModelLoaded)
-            {
-                glEnable(GL_LIGHTING);
-                glEnable(GL_TEXTURE_2D);
-                glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-
-                // Cyan material for Boost
-                GLfloat matSpecular[] = {1.0f, 1.0f, 1.0f, 1.0f};
-                GLfloat matShininess[] = {80.0f};
-                GLfloat matAmbient[] = {0.0f, 0.6f, 0.6f, 1.0f};
-                GLfloat matDiffuse[] = {0.0f, 1.0f, 1.0f, 1.0f};
-                GLfloat matEmission[] = {0.0f, 0.3f, 0.3f, 1.0f};
-
-                glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, matSpecular);
-                glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, matShininess);
-                glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, matAmbient);
-                glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, matDiffuse);
-                glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, matEmission);
-
-                glColor3f(0.0f, 1.0f, 1.0f);
-
-                // Rotate 180 degrees to face correct direction
-                glRotatef(180.0f, 0, 1, 0);
-
-                // Draw first arrow
-                glPushMatrix();
-                glTranslatef(0.0f, 0.0f, -1.0f);
-                boostModel.Draw();
-                glPopMatrix();
-
-                // Draw second arrow (double-arrow effect)
-                glPushMatrix();
-                glTranslatef(0.0f, 0.0f, 1.0f);
-                boostModel.Draw();
-                glPopMatrix();
-
-                // Reset material
-                GLfloat defaultEmission[] = {0.0f, 0.0f, 0.0f, 1.0f};
-                glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, defaultEmission);
-            }
-            else
-            {
-                // Fallback
-                glColor3f(0.0f, 1.0f, 1.0f);
-                float floatOffset = 0.5f * sin(animationTime);
-                glTranslatef(0.0f, floatOffset, 0.0f);
-                glutSolidCone(0.5f, 1.0f, 10, 2);
-            }
+        {
+            // Fallback
+            glColor3f(0.0f, 1.0f, 1.0f);
+            float floatOffset = 0.5f * sin(animationTime);
+            glTranslatef(0.0f, floatOffset, 0.0f);
+            glutSolidCone(0.5f, 1.0f, 10, 2);
         }
-
-        glPopMatrix();
     }
+
+    glPopMatrix();
 }
 
-bool Level1::checkCollisions(Car &car)
+static uint32_t secondsToTicks(float seconds)
 {
-    float carX = car.getX();
-    float carZ = car.getZ();
-    float carSize = 1.0f; // Approx radius
+    return (uint32_t)ceilf(seconds / TICK_SECONDS);
+}
 
-    // Handle No Traffic Timer
-    if (noTrafficActive)
+float Level1::secondsLeft(uint32_t endTick) const
+{
+    return endTick > simTick ? (endTick - simTick) * TICK_SECONDS : 0.0f;
+}
+
+// Clears the road once; nothing spawns or moves until the timer fires.
+// Picking up another one restarts the timer.
+void Level1::startNoTraffic()
+{
+    for (size_t i = 0; i < entities.drivers.size(); i++)
     {
-        noTrafficTimer -= 0.016f; // Approx 60 FPS
-        if (noTrafficTimer <= 0.0f)
-        {
-            noTrafficActive = false;
-        }
-        else
-        {
-            // Despawn all cars while active
-            for (auto &obs : cars)
-            {
-                obs.active = false;
-            }
-        }
+        entities.setActive(entities.drivers.entity(i), false);
     }
 
-    // Handle Speed Boost Timer
-    if (speedBoostActive)
+    noTrafficActive = true;
+    noTrafficEnd = simTick + secondsToTicks(NO_TRAFFIC_SECONDS);
+    auto expire = [this]()
     {
-        speedBoostTimer -= 0.016f;
-        if (speedBoostTimer <= 0.0f)
-        {
-            speedBoostActive = false;
-            car.setBoost(false);
-        }
-    }
+        noTrafficActive = false;
+        noTrafficTimer = TimerWheel::NO_TIMER;
+    };
+    timers.cancel(noTrafficTimer);
+    noTrafficTimer = timers.schedule(noTrafficEnd, expire);
+}
 
-    // Manage Obstacles (Spawn/Despawn)
-    // Only spawn if traffic is allowed
-    if (!noTrafficActive)
+void Level1::startSpeedBoost(Car &car)
+{
+    car.setBoost(true);
+
+    speedBoostActive = true;
+    speedBoostEnd = simTick + secondsToTicks(SPEED_BOOST_SECONDS);
+    auto expire = [this, &car]()
     {
-        // Spawn new cars ahead
-        for (auto &obs : cars)
-        {
-            if (!obs.active)
-            {
-                if (rand() % 100 < 2)
-                { // Chance to spawn
-                    // Spawn strictly on road (width 20, so -10 to 10). Keep away from edges.
-                    // Range: -8 to 8
-                    float newX = (rand() % 16) - 8.0f;
-                    float newZ = carZ + 100 + (rand() % 50);
-
-                    // Check overlap with existing active cars
-                    bool overlap = false;
-                    for (const auto &other : cars)
-                    {
-                        if (other.active)
-                        {
-                            if (std::abs(newX - other.x) < 4.0f && std::abs(newZ - other.z) < 10.0f)
-                            {
-                                overlap = true;
-                                break;
-                            }
-                        }
-                    }
+        speedBoostActive = false;
+        speedBoostTimer = TimerWheel::NO_TIMER;
+        car.setBoost(false);
+    };
+    timers.cancel(speedBoostTimer);
+    speedBoostTimer = timers.schedule(speedBoostEnd, expire);
+}
 
-                    if (!overlap)
-                    {
-                        obs.active = true;
-                        obs.x = newX;
-                        obs.z = newZ;
-                        obs.speed = 0.05f + ((rand() % 5) / 100.0f);
-
-                        obs.originalX = obs.x;
-                        obs.targetX = obs.x;
-                        obs.isMovingAside = false;
-                    }
-                }
-            }
-            else
-            {
-                // Move car
-                obs.z += obs.speed;
+bool Level1::checkCollisions(Car &car)
+{
+    PROFILE_ZONE("Level1::checkCollisions");
 
-                // Smart Behavior: Move aside if illuminated (Flash Trigger)
-                bool lightsOn = car.isLightsOn();
-                bool justFlashed = lightsOn && !wasLightsOn;
+    float carX = car.getX();
+    float carZ = car.getZ();
+    float carSize = 1.0f; // Approx radius
+    const int spread = spawnSpread();
 
-                if (justFlashed)
-                {
-                    // Check if in front and within REDUCED range
-                    float distZ = obs.z - carZ;
-                    if (distZ > 0 && distZ < 15.0f)
-                    { // Reduced range
-                        // Check if in same lane (roughly)
-                        if (std::abs(obs.x - carX) < 4.0f)
-                        {
-                            obs.isMovingAside = true;
-                            // Decide direction: Move away from center or just to shoulder
-                            if (obs.x > 0)
-                                obs.targetX = obs.x + 6.0f;
-                            else
-                                obs.targetX = obs.x - 6.0f;
-                        }
-                    }
-                }
+    // Fire the power-up timers that run out this tick
+    timers.advance(++simTick);
 
-                // Interpolate position (SLOWER)
-                if (obs.isMovingAside)
-                {
-                    obs.x += (obs.targetX - obs.x) * 0.01f; // Reduced from 0.05 to 0.01
-                }
+    // Move the traffic and test it against the player, see TrafficSystem
+    TrafficTick tick;
+    tick.playerX = carX;
+    tick.playerZ = carZ;
+    tick.playerSpeed = car.getSpeed() * cos(car.getRotation() * 3.14159f / 180.0f);
+    tick.playerSize = carSize;
+    tick.justFlashed = car.isLightsOn() && !wasLightsOn; // Smart behavior: flash to move cars aside
+    tick.moveTraffic = !noTrafficActive;
+
+    bool hit = trafficSystem.update(entities, tick, jobs);
 
-                // Despawn if too far behind OR if on grass
-                // Road width is 20 (-10 to 10). If |x| > 10, it's on grass.
-                if (obs.z < carZ - 20 || std::abs(obs.x) > 10.0f)
+    // Spawning draws from rng, so it stays serial and in car order; results
+    // match with or without jobs. Only spawn if traffic is allowed
+    if (!noTrafficActive)
+    {
+        int carCount = (int)entities.drivers.size();
+        int laneCount = trafficSystem.getLaneCount();
+        for (int i = 0; i < carCount; i++)
+        {
+            Entity e = entities.drivers.entity(i);
+            if (!entities.isActive(e) && rng.chance(road.traffic.spawnChance, 100))
+            { // Chance to spawn
+                int lane = rng.nextInt(laneCount);
+                float newZ = carZ + road.traffic.spawnAhead + rng.nextInt(road.traffic.spawnWindow);
+
+                // Keep clear of cars already in that lane
+                if (trafficSystem.isClear(lane, newZ, 10.0f))
                 {
-                    obs.active = false;
+                    float speed = road.traffic.minSpeed + (rng.nextInt(road.traffic.speedSteps) / 100.0f);
+                    trafficSystem.place(entities, i, lane, newZ, speed);
                 }
             }
         }
     }
+    trafficSystem.rebuild(entities, tick);
 
     // Update light state for next frame
     wasLightsOn = car.isLightsOn();
 
-    // Check obstacles
-    for (auto &obs : cars)
-    {
-        if (obs.active)
-        {
-            if (std::abs(carX - obs.x) < (carSize + obs.width / 2) &&
-                std::abs(carZ - obs.z) < (carSize + obs.length / 2))
-            {
-                return true; // Collision!
-            }
-        }
-    }
+    if (hit)
+        return true; // Collision!
 
     // Check collectibles
-    for (auto &p : powerups)
+    for (size_t i = 0; i < entities.pickups.size(); i++)
     {
+        Entity e = entities.pickups.entity(i);
+        Pickup &p = entities.pickups[i];
+        Transform &t = entities.transforms.get(e);
+
         // Respawn logic for powerups - Reduced frequency and overlap check
-        if (!p.active && rand() % 500 < 1)
-        {                                      // Reduced frequency (was 200)
-            float newX = (rand() % 16) - 8.0f; // On road
-            float newZ = carZ + 150 + (rand() % 50);
+        if (!entities.isActive(e) && rng.chance(1, road.traffic.powerupChance))
+        {                                        // Reduced frequency (was 200)
+            float newX = rng.nextInt(spread) - spread / 2.0f; // On road
+            float newZ = carZ + road.traffic.powerupAhead + rng.nextInt(road.traffic.powerupWindow);
 
             // Check overlap with other powerups
             bool overlap = false;
-            for (const auto &other : powerups)
+            for (size_t j = 0; j < entities.pickups.size(); j++)
             {
-                if (other.active)
+                Entity other = entities.pickups.entity(j);
+                if (entities.isActive(other))
                 {
-                    if (std::abs(newX - other.x) < 2.0f && std::abs(newZ - other.z) < 2.0f)
+                    const Transform &ot = entities.transforms.get(other);
+                    if (std::abs(newX - ot.x) < 2.0f && std::abs(newZ - ot.z) < 2.0f)
                     {
                         overlap = true;
                         break;
@@ -669,50 +771,47 @@ bool Level1::checkCollisions(Car &car)
 
             if (!overlap)
             {
-                p.active = true;
-                p.x = newX;
-                p.z = newZ;
-                p.type = rand() % 2; // Randomly assign type on respawn (0 = No Traffic, 1 = Speed Boost)
+                entities.setActive(e, true);
+                t.x = newX;
+                t.z = newZ;
+                p.type = rng.nextInt(2); // Randomly assign type on respawn (0 = No Traffic, 1 = Speed Boost)
+                entities.renderables.get(e).kind = powerupKind(p.type);
             }
         }
 
-        if (p.active)
+        if (entities.isActive(e))
         {
-            if (p.z < carZ - 20)
-                p.active = false; // Despawn
+            if (t.z < carZ - 20)
+                entities.setActive(e, false); // Despawn
 
-            if (std::abs(carX - p.x) < 1.5f && std::abs(carZ - p.z) < 1.5f)
+            const Collider &c = entities.colliders.get(e);
+            if (std::abs(carX - t.x) < carSize + c.width / 2 && std::abs(carZ - t.z) < carSize + c.length / 2)
             {
-                p.active = false;
+                entities.setActive(e, false);
+                pickups++;
+                pickupsByType[p.type]++;
                 if (p.type == 0)
                 { // Traffic Light (No Traffic)
-                    noTrafficActive = true;
-                    noTrafficTimer = 5.0f; // 5 seconds
+                    startNoTraffic();
                 }
                 else if (p.type == 1)
                 { // Boost
-                    speedBoostActive = true;
-                    speedBoostTimer = 3.0f;
-                    car.setBoost(true);
+                    startSpeedBoost(car);
                 }
             }
         }
     }
 
     // Check Lamp Posts
-    // Lamp posts are at +/- (roadWidth/2 + 2.0f) = +/- 12.0f
-    // Spaced every 30.0f, offset by 15.0f
-    // Formula: z = k * 30 + 15
+    // Lamp posts are at +/- (road.width/2 + lampGap) = +/- 12.0f on the default road
+    // Spaced every lampSpacing, offset by lampPhase: z = k * lampSpacing + lampPhase
     // We can check if car is near the sides first
-    if (std::abs(carX) > roadWidth / 2 + 1.0f)
+    if (std::abs(carX) > road.width / 2 + road.lampGap - 1.0f)
     { // Near sides
-        // Check Z alignment with posts
         // Normalize Z to find nearest post
-        // z - 15 = k * 30
-        // (z - 15) / 30 = k
-        float localZ = carZ - 15.0f;
-        float nearestK = round(localZ / 30.0f);
-        float nearestPostZ = nearestK * 30.0f + 15.0f;
+        float localZ = carZ - road.lampPhase;
+        float nearestK = round(localZ / road.lampSpacing);
+        float nearestPostZ = nearestK * road.lampSpacing + road.lampPhase;
 
         if (std::abs(carZ - nearestPostZ) < 1.0f)
         {                // Close to post Z
@@ -721,26 +820,21 @@ bool Level1::checkCollisions(Car &car)
     }
 
     // Check Buildings
-    // Buildings are at +/- (roadWidth/2 + 10) = +/- 20.0f
-    // Width (X) is 10.0f, so they span [15, 25] and [-25, -15].
-    // Length (Z) is 20.0f. Spaced every 30.0f.
-    // Centered at k * 30. Spans [k*30 - 10, k*30 + 10].
+    // Buildings are centred at +/- (road.width/2 + buildingGap) = +/- 20.0f on the default road
+    // and at multiples of buildingSpacing along z.
 
     // Check X first (simple bounding box)
-    // Car width is approx 2.0f.
-    // If carX > 15 - 1 = 14 (Right side) or carX < -14 (Left side)
-    if (std::abs(carX) > 14.0f)
+    // Car width is approx 2.0f, so collide once the car's side reaches the wall (14.0f by default)
+    float buildingInner = road.width / 2 + road.buildingGap - road.buildingWidth / 2;
+    if (std::abs(carX) > buildingInner - 1.0f)
     {
-        // Check Z
         // Normalize Z to nearest building center
-        // Building centers are at multiples of 30.
-        float localZ = carZ;
-        float nearestK = round(localZ / 30.0f);
-        float nearestBuildingZ = nearestK * 30.0f;
+        float nearestK = round(carZ / road.buildingSpacing);
+        float nearestBuildingZ = nearestK * road.buildingSpacing;
 
-        // Check if within length of building (20 total, so +/- 10)
+        // Check if within length of building
         // Add car length (approx 4.0f, so +/- 2.0f)
-        if (std::abs(carZ - nearestBuildingZ) < 10.0f + 2.0f)
+        if (std::abs(carZ - nearestBuildingZ) < road.buildingLength / 2 + 2.0f)
         {
             return true; // Collision with building
         }
@@ -749,13 +843,36 @@ bool Level1::checkCollisions(Car &car)
     return false;
 }
 
+void Level1::cullEntities(float playerZ)
+{
+    PROFILE_ZONE("Level1::cullEntities");
+
+    const ComponentArray<Renderable> &renderables = entities.renderables;
+    visible.resize(renderables.size());
+    auto cullRange = [&](int first, int last)
+    {
+        for (int i = first; i < last; i++)
+        {
+            Entity e = renderables.entity(i);
+            float z = entities.transforms.get(e).z;
+            visible[i] = entities.isActive(e) && z > playerZ - VIEW_BEHIND && z < playerZ + VIEW_AHEAD;
+        }
+    };
+    if (jobs)
+        jobs->parallelFor(0, (int)renderables.size(), TRAFFIC_GRAIN, cullRange);
+    else
+        cullRange(0, (int)renderables.size());
+}
+
 bool Level1::isFinished(Car &car)
 {
-    return car.getZ() > 1000.0f;
+    return car.getZ() > road.finishZ;
 }
 
 void Level1::drawGround(float playerZ)
 {
+    PROFILE_GPU_ZONE("Level1::drawGround");
+
     float startZ = floor(playerZ / 10.0f) * 10.0f - 50.0f;
     float endZ = startZ + 300.0f;
     float groundWidth = 100.0f; // Width of the grass strips
@@ -763,127 +880,156 @@ void Level1::drawGround(float playerZ)
     glColor3f(0.0f, 0.8f, 0.0f); // Green Grass
     glNormal3f(0, 1, 0);
 
-    // Left Side
-    glBegin(GL_QUADS);
-    glVertex3f(-roadWidth / 2 - groundWidth, 0.01f, startZ);
-    glVertex3f(-roadWidth / 2, 0.01f, startZ);
-    glVertex3f(-roadWidth / 2, 0.01f, endZ);
-    glVertex3f(-roadWidth / 2 - groundWidth, 0.01f, endZ);
-    glEnd();
-
-    // Right Side
+    // Both sides in squares, leaving out those behind the buildings
     glBegin(GL_QUADS);
-    glVertex3f(roadWidth / 2, 0.01f, startZ);
-    glVertex3f(roadWidth / 2 + groundWidth, 0.01f, startZ);
-    glVertex3f(roadWidth / 2 + groundWidth, 0.01f, endZ);
-    glVertex3f(roadWidth / 2, 0.01f, endZ);
+    for (float z = startZ; z < endZ; z += GRASS_CELL)
+    {
+        for (float offset = 0.0f; offset < groundWidth; offset += GRASS_CELL)
+        {
+            for (int side = -1; side <= 1; side += 2)
+            {
+                float inner = side * (road.width / 2 + offset);
+                float outer = side * (road.width / 2 + offset + GRASS_CELL);
+                float cellMin[3] = {std::min(inner, outer), 0.01f, z};
+                float cellMax[3] = {std::max(inner, outer), 0.01f, z + GRASS_CELL};
+                if (occlusion.isHidden(cellMin, cellMax))
+                    continue;
+
+                glVertex3f(cellMin[0], 0.01f, z);
+                glVertex3f(cellMax[0], 0.01f, z);
+                glVertex3f(cellMax[0], 0.01f, z + GRASS_CELL);
+                glVertex3f(cellMin[0], 0.01f, z + GRASS_CELL);
+            }
+        }
+    }
     glEnd();
 }
 
-void Level1::drawLampPosts(float playerZ, bool isNight)
+// A real light under every lamp head drawn by drawLampPosts(), at night
+void Level1::addLights(Car &car, bool isNight)
 {
-    float startZ = floor(playerZ / 30.0f) * 30.0f - 60.0f;
-    float endZ = startZ + 300.0f;
+    if (!isNight)
+        return;
 
-    for (float z = startZ; z < endZ; z += 30.0f)
+    float spacing = road.lampSpacing;
+    float startZ = floor(car.getZ() / spacing) * spacing - 2 * spacing;
+    float endZ = startZ + 300.0f;
+    float headX = road.width / 2 + road.lampGap - 3.0f; // End of the arm
+
+    Light light;
+    light.y = 5.8f;
+    light.dirX = 0.0f;
+    light.dirY = -1.0f;
+    light.dirZ = 0.0f;
+    light.r = 1.0f;
+    light.g = 0.9f;
+    light.b = 0.7f;
+    light.spotCutoff = 60.0f;
+    light.spotExponent = 2.0f;
+    light.constant = 1.0f;
+    light.linear = 0.05f;
+    light.quadratic = 0.01f;
+    light.range = 25.0f;
+    light.shadowMap = -1;
+
+    for (float z = startZ; z < endZ; z += spacing)
     {
-        // Left Side
-        glPushMatrix();
-        glTranslatef(-roadWidth / 2 - 2.0f, 0.0f, z + 15.0f); // Offset from buildings
-
-        // Pole
-        glColor3f(0.3f, 0.3f, 0.3f); // Gray
-        glPushMatrix();
-        glRotatef(-90, 1, 0, 0);
-        GLUquadricObj *qobj = gluNewQuadric();
-        gluCylinder(qobj, 0.3, 0.3, 6.0, 10, 10);
-        gluDeleteQuadric(qobj);
-        glPopMatrix();
+        light.z = z + road.lampPhase;
+        light.x = -headX;
+        Lighting::addLight(light);
+        light.x = headX;
+        Lighting::addLight(light);
+    }
+}
 
-        // Arm
-        glPushMatrix();
-        glTranslatef(0.0f, 6.0f, 0.0f);
-        glRotatef(90, 0, 1, 0); // Point towards road
-        qobj = gluNewQuadric();
-        gluCylinder(qobj, 0.2, 0.2, 3.0, 10, 10);
-        gluDeleteQuadric(qobj);
-        glPopMatrix();
+void Level1::prepareFrame(Car &car)
+{
+    cullEntities(car.getZ());
+}
 
-        // Lamp
-        glPushMatrix();
-        glTranslatef(3.0f, 5.8f, 0.0f); // End of arm
-        glColor3f(1.0f, 1.0f, 1.0f);
-        glutSolidSphere(0.4, 10, 10);
+void Level1::drawShadowCasters(Car &car, bool staticGeometry)
+{
+    if (staticGeometry)
+    {
+        drawBuildings(car.getZ());
+        drawLampPosts(car.getZ(), false, nullptr);
+    }
+    else
+    {
+        drawEntities(nullptr);
+    }
+}
 
-        // Light Beam (Night only)
-        if (isNight)
-        {
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glDepthMask(GL_FALSE);              // Don't write to depth buffer for transparent objects
-            glColor4f(1.0f, 1.0f, 0.8f, 0.15f); // More transparent (was 0.3)
+void Level1::drawLampPosts(float playerZ, bool isNight, OcclusionBuffer *occluders)
+{
+    PROFILE_GPU_ZONE("Level1::drawLampPosts");
 
-            glPushMatrix();
-            glRotatef(90, 1, 0, 0); // Point down
-            // Flip cone: Tip at 0, Base at Length
-            glTranslatef(0.0f, 0.0f, 6.0f);
-            glScalef(1.0f, 1.0f, -1.0f);
-            glutSolidCone(2.0, 6.0, 10, 10); // Wide cone down to ground
-            glPopMatrix();
+    float spacing = road.lampSpacing;
+    float startZ = floor(playerZ / spacing) * spacing - 2 * spacing;
+    float endZ = startZ + 300.0f;
+    float sideX = road.width / 2 + road.lampGap;
 
-            glDepthMask(GL_TRUE);
-            glDisable(GL_BLEND);
+    for (float z = startZ; z < endZ; z += spacing)
+    {
+        float lampZ = z + road.lampPhase; // Offset from buildings
+        for (int side = -1; side <= 1; side += 2) // Left side, then right
+        {
+            float x = side * sideX;
+            float toRoad = (float)-side;
+            if (occluders)
+            {
+                // From the back of the pole to the far edge of the light beam
+                float backX = x - toRoad * 0.4f;
+                float beamX = x + toRoad * 5.0f;
+                float boxMin[3] = {std::min(backX, beamX), 0.0f, lampZ - 2.0f};
+                float boxMax[3] = {std::max(backX, beamX), 6.4f, lampZ + 2.0f};
+                if (occluders->isHidden(boxMin, boxMax))
+                    continue;
+            }
+            drawLampPost(x, lampZ, toRoad, isNight);
         }
-        glPopMatrix();
-        glPopMatrix();
-
-        // Right Side
-        glPushMatrix();
-        glTranslatef(roadWidth / 2 + 2.0f, 0.0f, z + 15.0f);
-
-        // Pole
-        glColor3f(0.3f, 0.3f, 0.3f);
-        glPushMatrix();
-        glRotatef(-90, 1, 0, 0);
-        qobj = gluNewQuadric();
-        gluCylinder(qobj, 0.3, 0.3, 6.0, 10, 10);
-        gluDeleteQuadric(qobj);
-        glPopMatrix();
+    }
+}
 
-        // Arm
-        glPushMatrix();
-        glTranslatef(0.0f, 6.0f, 0.0f);
-        glRotatef(-90, 0, 1, 0); // Point towards road (negative)
-        qobj = gluNewQuadric();
-        gluCylinder(qobj, 0.2, 0.2, 3.0, 10, 10);
-        gluDeleteQuadric(qobj);
-        glPopMatrix();
+// A pole at (x, z) with its arm reaching towards the road, which is along
+// x's sign toRoad
+void Level1::drawLampPost(float x, float z, float toRoad, bool isNight)
+{
+    glPushMatrix();
+    glTranslatef(x, 0.0f, z);
+
+    // Pole
+    glColor3f(0.3f, 0.3f, 0.3f); // Gray
+    glPushMatrix();
+    glRotatef(-90, 1, 0, 0);
+    GLUquadricObj *qobj = gluNewQuadric();
+    gluCylinder(qobj, 0.3, 0.3, 6.0, 10, 10);
+    gluDeleteQuadric(qobj);
+    glPopMatrix();
+
+    // Arm
+    glPushMatrix();
+    glTranslatef(0.0f, 6.0f, 0.0f);
+    glRotatef(90 * toRoad, 0, 1, 0); // Point towards road
+    qobj = gluNewQuadric();
+    gluCylinder(qobj, 0.2, 0.2, 3.0, 10, 10);
+    gluDeleteQuadric(qobj);
+    glPopMatrix();
+
+    // Lamp
+    glPushMatrix();
+    glTranslatef(3.0f * toRoad, 5.8f, 0.0f); // End of arm
+    glColor3f(1.0f, 1.0f, 1.0f);
+    glutSolidSphere(0.4, 10, 10);
 
-        // Lamp
+    // Light Beam (Night only), drawn after the opaque scene
+    if (isNight)
+    {
         glPushMatrix();
-        glTranslatef(-3.0f, 5.8f, 0.0f);
-        glColor3f(1.0f, 1.0f, 1.0f);
-        glutSolidSphere(0.4, 10, 10);
-
-        // Light Beam (Night only)
-        if (isNight)
-        {
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glDepthMask(GL_FALSE);
-            glColor4f(1.0f, 1.0f, 0.8f, 0.15f);
-
-            glPushMatrix();
-            glRotatef(90, 1, 0, 0);
-            glTranslatef(0.0f, 0.0f, 6.0f);
-            glScalef(1.0f, 1.0f, -1.0f);
-            glutSolidCone(2.0, 6.0, 10, 10);
-            glPopMatrix();
-
-            glDepthMask(GL_TRUE);
-            glDisable(GL_BLEND);
-        }
-        glPopMatrix();
+        glRotatef(90, 1, 0, 0);                          // Point down
+        Transparency::addBeam(2.0f, 6.0f, LAMP_BEAM_COLOR); // Wide cone down to ground
         glPopMatrix();
     }
+    glPopMatrix();
+    glPopMatrix();
 }
@@ -1,16 +1,25 @@
 #ifndef LEVEL1_H
 #define LEVEL1_H
 
+#include "JobSystem.h"
 #include "Level.h"
+#include "LevelData.h"
 #include "Model_3DS.h"
+#include "OcclusionBuffer.h"
+#include "Registry.h"
+#include "TimerWheel.h"
+#include "Traffic.h"
 #include <vector>
 
-struct Collectible
+// Level1 state shown by render(), see GameSnapshot
+struct Level1State
 {
-    float x, z;
-    int type; // 0 = Traffic Light (Clear), 1 = Boost
-    bool active;
-    float rotation;
+    Registry entities;
+    uint32_t simTick;
+    uint32_t noTrafficEnd; // Sim tick the power-up runs out
+    bool noTrafficActive;
+    uint32_t speedBoostEnd;
+    bool speedBoostActive;
 };
 
 class Level1 : public Level
@@ -22,19 +31,59 @@ public:
     void render(Car &car, bool isNight) override;
     bool checkCollisions(Car &car) override;
     bool isFinished(Car &car) override;
+    void loadAssets() override;
+    void addLights(Car &car, bool isNight) override;
+    void prepareFrame(Car &car) override;
+    void drawShadowCasters(Car &car, bool staticGeometry) override;
+    void capture(GameSnapshot &snapshot) const override;
+    void apply(const GameSnapshot &snapshot) override;
+
+    // Road layout, spawn tables and finish line; call before init()
+    void setLevelData(const LevelData &data)
+    {
+        road = data.road;
+        trafficSystem.configure(road.width, road.laneWidth);
+    }
+    const RoadDesc &getRoad() const { return road; }
+
+    // Number of traffic cars spawned by init() (default 10)
+    void setTrafficSize(int count) { road.trafficSize = count; }
+    void setTrafficParams(const TrafficParams &params) { road.traffic = params; }
+
+    // Read-only views for tools and scripted drivers
+    const Registry &getEntities() const { return entities; }
+    int getPickupCount(int type) const { return pickupsByType[type]; } // 0 = No Traffic, 1 = Boost
+
+    // Runs the per-car traffic and culling loops on a job system; nullptr is serial
+    void setJobSystem(JobSystem *jobSystem) { jobs = jobSystem; }
 
 private:
-    std::vector<Obstacle> cars;
-    std::vector<Collectible> powerups;
-    float roadLength;
-    float roadWidth;
+    Registry entities; // Traffic (AIDriver) and power-ups (Pickup)
+    TrafficSystem trafficSystem;
+    RoadDesc road;
+    int pickupsByType[2];
     bool wasLightsOn;
+    JobSystem *jobs;
+    std::vector<unsigned char> visible; // Per Renderable slot, filled by cullEntities() each frame
+    OcclusionBuffer occlusion;          // This frame's buildings, filled by buildOccluders()
+
+    // Objects per job, big enough that scheduling costs less than the work
+    static const int TRAFFIC_GRAIN = 512;
 
-    float noTrafficTimer;
+    // Objects are drawn this far behind and ahead of the player, like the road
+    static constexpr float VIEW_BEHIND = 50.0f;
+    static constexpr float VIEW_AHEAD = 200.0f;
+
+    // Power-ups apply once when picked up and end on a timer event
+    TimerWheel timers;
+    uint32_t simTick; // Ticks since init(), the timers' clock
+    uint32_t noTrafficEnd;
     bool noTrafficActive;
+    TimerWheel::TimerId noTrafficTimer;
 
-    float speedBoostTimer;
+    uint32_t speedBoostEnd;
     bool speedBoostActive;
+    TimerWheel::TimerId speedBoostTimer;
     float animationTime; // For scaling animation
 
     // Obstacle car 3D model
@@ -47,13 +96,24 @@ private:
     Model_3DS boostModel;
     bool boostModelLoaded;
 
-    void spawnCar();
+    // Width of the x range new cars and power-ups spawn in, 2 m clear of each edge
+    int spawnSpread() const { return (int)road.width - 4; }
+
+    void spawnCar(Random &random);
+    void spawnPowerup(float x, float z, int type);
+    void startNoTraffic();
+    void startSpeedBoost(Car &car);
+    float secondsLeft(uint32_t endTick) const;
+    void cullEntities(float playerZ);
+    void buildOccluders(float playerZ);
     void drawRoad(float playerZ);
     void drawGround(float playerZ);
     void drawBuildings(float playerZ);
-    void drawLampPosts(float playerZ, bool isNight);
-    void drawObstacles();
-    void drawCollectibles();
+    void drawLampPosts(float playerZ, bool isNight, OcclusionBuffer *occluders);
+    void drawLampPost(float x, float z, float toRoad, bool isNight);
+    void drawEntities(OcclusionBuffer *occluders);
+    void drawTrafficCar(const Transform &t, int colorIndex, const Collider &c);
+    void drawPowerup(const Transform &t, const Renderable &r);
 };
 
 #endif
@@ -1,45 +1,74 @@
 #include "Level2.h"
+#include "GameSnapshot.h"
+#include "Lighting.h"
+#include "Profiler.h"
 #include <GL/glut.h>
 #include <cmath>
 #include <iostream>
 
+std::atomic<uint32_t> Level2::nextSceneVersion(1);
+
 Level2::Level2() {
+    sceneVersion = 0;
     parked = false;
     parkingTimer = 0.0f;
     isParking = false;
+    setLevelData(LevelData::defaultParking());
+}
+
+void Level2::setLevelData(const LevelData& data) {
+    lot = data.parking;
+    layout = data.colliders;
+    staticScene.invalidate(); // The lot size is drawn from here, not the snapshot
 }
 
 void Level2::init() {
-    obstacles.clear();
+    entities.clear();
+    sceneVersion = nextSceneVersion++;
     
     // Target Spot
-    targetSpot.x = 10.0f;
-    targetSpot.z = 20.0f;
-    targetSpot.width = 2.5f; // Was 3.0
-    targetSpot.length = 4.0f; // Was 5.0
-
-    // Add Cones around
-    Obstacle cone;
-    cone.width = 0.5f;
-    cone.length = 0.5f;
-    cone.active = true;
-    
-    // Place cones
-    float positions[][2] = {{5, 15}, {15, 15}, {5, 25}, {15, 25}};
-    for (auto& pos : positions) {
-        cone.x = pos[0];
-        cone.z = pos[1];
-        obstacles.push_back(cone);
+    targetSpot.x = lot.spotX;
+    targetSpot.z = lot.spotZ;
+    targetSpot.width = lot.spotWidth;
+    targetSpot.length = lot.spotLength;
+
+    // Cones, Sayes and walls all block the car, walls are not drawn
+    for (const auto& collider : layout) {
+        Entity e = entities.create();
+        Transform t = {collider.x, collider.z, 0.0f};
+        Collider c = {collider.width, collider.length};
+        entities.transforms.add(e, t);
+        entities.colliders.add(e, c);
+
+        if (collider.kind == COLLIDER_CONE) {
+            Renderable r = {RENDER_CONE, 0};
+            entities.renderables.add(e, r);
+        } else if (collider.kind == COLLIDER_PERSON) {
+            Renderable r = {RENDER_PERSON, 0};
+            entities.renderables.add(e, r);
+        }
     }
+}
 
-    // Add Sayes
-    Obstacle sayes;
-    sayes.x = 8.0f;
-    sayes.z = 22.0f;
-    sayes.width = 0.8f;
-    sayes.length = 0.8f;
-    sayes.active = true; // Mark as Sayes type if needed, or just generic obstacle
-    obstacles.push_back(sayes);
+void Level2::capture(GameSnapshot& snapshot) const {
+    Level2State& state = snapshot.level2;
+    snapshot.level = 2;
+    state.entities = entities;
+    state.targetSpot = targetSpot;
+    state.parked = parked;
+    state.parkingTimer = parkingTimer;
+    state.isParking = isParking;
+    state.sceneVersion = sceneVersion;
+}
+
+void Level2::apply(const GameSnapshot& snapshot) {
+    const Level2State& state = snapshot.level2;
+    entities = state.entities;
+    targetSpot = state.targetSpot;
+    parked = state.parked;
+    parkingTimer = state.parkingTimer;
+    isParking = state.isParking;
+    sceneVersion = state.sceneVersion;
 }
 
 void Level2::update() {
@@ -48,14 +77,14 @@ void Level2::update() {
 }
 
 void Level2::render(Car& car, bool /*isNight*/) {
-    drawParkingLot();
-    drawCones();
-    drawSayes();
+    PROFILE_GPU_ZONE("Level2::render");
+
+    drawStaticScene();
     drawMirror(car);
     
     if (isParking && !parked) {
         // Draw Countdown
-        glDisable(GL_LIGHTING);
+        Lighting::disable();
         glMatrixMode(GL_PROJECTION);
         glPushMatrix();
         glLoadIdentity();
@@ -65,7 +94,7 @@ void Level2::render(Car& car, bool /*isNight*/) {
         glLoadIdentity();
         
         glColor3f(1.0f, 1.0f, 0.0f);
-        std::string timeStr = "Parking: " + std::to_string(3.0f - parkingTimer).substr(0, 3) + "s";
+        std::string timeStr = "Parking: " + std::to_string(lot.parkSeconds - parkingTimer).substr(0, 3) + "s";
         glRasterPos2f(350, 500);
         for (char c : timeStr) {
             glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
@@ -75,19 +104,36 @@ void Level2::render(Car& car, bool /*isNight*/) {
         glMatrixMode(GL_PROJECTION);
         glPopMatrix();
         glMatrixMode(GL_MODELVIEW);
-        glEnable(GL_LIGHTING);
+        Lighting::enable();
     }
 }
 
+// Records the lot and its props the first time a layout is seen
+void Level2::drawStaticScene() {
+    if (!staticScene.isCurrent(sceneVersion)) {
+        staticScene.begin(sceneVersion);
+        drawParkingLot();
+        drawEntities();
+        staticScene.end();
+    }
+    staticScene.draw();
+}
+
+// Cones and people never move, only the player's car does
+void Level2::drawShadowCasters(Car& /*car*/, bool staticGeometry) {
+    if (staticGeometry) drawEntities();
+}
+
 void Level2::drawParkingLot() {
     // Asphalt
     glColor3f(0.2f, 0.2f, 0.2f);
     glBegin(GL_QUADS);
     glNormal3f(0, 1, 0);
-    glVertex3f(-50, 0.01f, -50);
-    glVertex3f(50, 0.01f, -50);
-    glVertex3f(50, 0.01f, 50);
-    glVertex3f(-50, 0.01f, 50);
+    float size = lot.lotHalfSize;
+    glVertex3f(-size, 0.01f, -size);
+    glVertex3f(size, 0.01f, -size);
+    glVertex3f(size, 0.01f, size);
+    glVertex3f(-size, 0.01f, size);
     glEnd();
 
     // Target Spot markings
@@ -101,26 +147,28 @@ void Level2::drawParkingLot() {
     glEnd();
 }
 
-void Level2::drawCones() {
-    glColor3f(1.0f, 0.5f, 0.0f); // Orange
-    for (const auto& obs : obstacles) {
-        // Simple check if it's a cone (based on size/index)
-        // For now draw all as cones except Sayes
-        if (obs.x == 8.0f) continue; // Skip Sayes
-
-        glPushMatrix();
-        glTranslatef(obs.x, 0.0f, obs.z);
-        glRotatef(-90, 1, 0, 0);
-        glutSolidCone(0.3f, 1.0f, 10, 2);
-        glPopMatrix();
+void Level2::drawEntities() {
+    const ComponentArray<Renderable>& renderables = entities.renderables;
+    for (size_t i = 0; i < renderables.size(); i++) {
+        const Transform& t = entities.transforms.get(renderables.entity(i));
+        if (renderables[i].kind == RENDER_CONE) drawCone(t);
+        else if (renderables[i].kind == RENDER_PERSON) drawSayes(t);
     }
 }
 
-void Level2::drawSayes() {
-    // Draw Sayes at 8, 22
+void Level2::drawCone(const Transform& t) {
+    glColor3f(1.0f, 0.5f, 0.0f); // Orange
     glPushMatrix();
-    glTranslatef(8.0f, 0.0f, 22.0f);
-    
+    glTranslatef(t.x, 0.0f, t.z);
+    glRotatef(-90, 1, 0, 0);
+    glutSolidCone(0.3f, 1.0f, 10, 2);
+    glPopMatrix();
+}
+
+void Level2::drawSayes(const Transform& t) {
+    glPushMatrix();
+    glTranslatef(t.x, 0.0f, t.z);
+
     // Body
     glColor3f(0.0f, 0.0f, 1.0f);
     glPushMatrix();
@@ -140,13 +188,15 @@ void Level2::drawSayes() {
 }
 
 void Level2::drawMirror(Car& car) {
+    PROFILE_GPU_ZONE("Level2::drawMirror");
+
     // Simple rear view mirror simulation
     // In GLUT, we can't easily do render-to-texture without extensions or FBOs manually.
     // We can use glViewport to draw a small view at the top.
     
     // Save current attributes
     glPushAttrib(GL_VIEWPORT_BIT | GL_ENABLE_BIT);
-    glDisable(GL_LIGHTING);
+    Lighting::disable();
     
     // Set viewport to top center
     int w = glutGet(GLUT_WINDOW_WIDTH);
@@ -181,10 +231,8 @@ void Level2::drawMirror(Car& car) {
     
     gluLookAt(eyeX, eyeY, eyeZ, lookX, 1.0f, lookZ, 0.0f, 1.0f, 0.0f);
     
-    // Draw scene again (simplified)
-    drawParkingLot();
-    drawCones();
-    drawSayes();
+    // Draw scene again, the same recording
+    drawStaticScene();
     
     // Draw frame
     // glColor3f(0.5f, 0.5f, 0.5f);
@@ -196,22 +244,21 @@ void Level2::drawMirror(Car& car) {
     glMatrixMode(GL_MODELVIEW);
     
     glPopAttrib();
+    Lighting::enable(); // glPopAttrib() turns lighting back on but not the shader
 }
 
 bool Level2::checkCollisions(Car& car) {
+    PROFILE_ZONE("Level2::checkCollisions");
+
     float carX = car.getX();
     float carZ = car.getZ();
     float carSize = 1.0f;
 
-    for (const auto& obs : obstacles) {
-        if (std::abs(carX - obs.x) < (carSize + obs.width/2) &&
-            std::abs(carZ - obs.z) < (carSize + obs.length/2)) {
-            return true;
-        }
+    if (entities.findOverlap(carX, carZ, carSize, carSize) != NULL_ENTITY) {
+        return true;
     }
     
     // Check parking
-    // Target Spot: x=10, z=20, w=2.5, l=4.0
     // Car Visuals: w=0.8, l=1.8 (from Car.cpp glScalef)
     // We use slightly larger bounding box for safety
     
@@ -223,10 +270,10 @@ bool Level2::checkCollisions(Car& car) {
     bool insideZ = (carZ - carHalfL >= targetSpot.z - targetSpot.length/2) && 
                    (carZ + carHalfL <= targetSpot.z + targetSpot.length/2);
                    
-    if (insideX && insideZ && std::abs(car.getSpeed()) < 0.01f) {
+    if (insideX && insideZ && std::abs(car.getSpeed()) < lot.parkSpeed) {
         isParking = true;
         parkingTimer += 0.016f; // Approx 60 FPS
-        if (parkingTimer >= 3.0f) {
+        if (parkingTimer >= lot.parkSeconds) {
             parked = true;
         }
     } else {
@@ -2,6 +2,10 @@
 #define LEVEL2_H
 
 #include "Level.h"
+#include "LevelData.h"
+#include "Registry.h"
+#include "StaticScene.h"
+#include <atomic>
 #include <vector>
 
 struct ParkingSpot {
@@ -9,6 +13,16 @@ struct ParkingSpot {
     float width, length;
 };
 
+// Level2 state shown by render(), see GameSnapshot
+struct Level2State {
+    Registry entities;
+    ParkingSpot targetSpot;
+    bool parked;
+    float parkingTimer;
+    bool isParking;
+    uint32_t sceneVersion; // New whenever init() lays the level out
+};
+
 class Level2 : public Level {
 public:
     Level2();
@@ -17,17 +31,33 @@ public:
     void render(Car& car, bool isNight) override;
     bool checkCollisions(Car& car) override;
     bool isFinished(Car& car) override;
+    void capture(GameSnapshot& snapshot) const override;
+    void apply(const GameSnapshot& snapshot) override;
+    void drawShadowCasters(Car& car, bool staticGeometry) override;
+
+    // Lot size, target spot, cones and people; call before init()
+    void setLevelData(const LevelData& data);
 
 private:
-    std::vector<Obstacle> obstacles; // Cones, cars, Sayes
+    ParkingDesc lot;
+    std::vector<LevelCollider> layout; // From the level file, instantiated by init()
+    Registry entities; // Cones, Sayes and invisible walls
     ParkingSpot targetSpot;
     bool parked;
     float parkingTimer;
     bool isParking;
-    
+
+    // The lot, cones and Sayes never move: recorded once per layout and
+    // replayed for the main view and the mirror
+    uint32_t sceneVersion;
+    StaticScene staticScene;
+    static std::atomic<uint32_t> nextSceneVersion;
+
+    void drawStaticScene();
     void drawParkingLot();
-    void drawCones();
-    void drawSayes();
+    void drawEntities();
+    void drawCone(const Transform& t);
+    void drawSayes(const Transform& t);
     void drawMirror(Car& car);
 };
 
@@ -0,0 +1,93 @@
+#include "LevelData.h"
+#include "Platform.h"
+#include <stdio.h>
+#include <string.h>
+
+// The binary format is these structs verbatim, keep them free of padding
+static_assert(sizeof(LevelFileHeader) == 16, "LevelFileHeader layout changed");
+static_assert(sizeof(TrafficParams) == 32, "TrafficParams layout changed");
+static_assert(sizeof(RoadDesc) == 14 * 4 + sizeof(TrafficParams), "RoadDesc layout changed");
+static_assert(sizeof(ParkingDesc) == 7 * 4, "ParkingDesc layout changed");
+static_assert(sizeof(LevelCollider) == 20, "LevelCollider layout changed");
+
+// Level1 steps along the road by the spacings, divides it into lanes, sizes
+// its slots by the counts and bounds random draws by the rest, so a hand
+// edited or corrupt file must not make any of them out of range
+static bool isValidRoad(const RoadDesc &road)
+{
+    const TrafficParams &traffic = road.traffic;
+    return road.width > 0.0f && road.length > 0.0f && road.laneWidth > 0.0f && road.buildingSpacing > 0.0f &&
+           road.buildingWidth > 0.0f && road.buildingLength > 0.0f && road.lampSpacing > 0.0f &&
+           road.trafficSize >= 0 && road.powerupCount >= 0 && traffic.speedSteps > 0 && traffic.spawnWindow > 0 &&
+           traffic.powerupChance > 0 && traffic.powerupWindow > 0;
+}
+
+bool LevelData::load(const char *path)
+{
+    Platform::MappedFile file;
+    if (!Platform::mapFile(path, file))
+        return false;
+
+    const size_t fixedSize = sizeof(LevelFileHeader) + sizeof(RoadDesc) + sizeof(ParkingDesc);
+    LevelFileHeader header;
+    bool ok = file.size >= fixedSize;
+    if (ok)
+    {
+        memcpy(&header, file.data, sizeof(header));
+        ok = memcmp(header.magic, LEVEL_FILE_MAGIC, 4) == 0 && header.version == LEVEL_FILE_VERSION &&
+             file.size == fixedSize + (size_t)header.colliderCount * sizeof(LevelCollider);
+    }
+
+    RoadDesc fileRoad;
+    if (ok)
+    {
+        memcpy(&fileRoad, file.data + sizeof(header), sizeof(fileRoad));
+        ok = isValidRoad(fileRoad);
+    }
+
+    if (ok)
+    {
+        const unsigned char *p = file.data + sizeof(header);
+        kind = header.kind;
+        road = fileRoad;
+        p += sizeof(road);
+        memcpy(&parking, p, sizeof(parking));
+        p += sizeof(parking);
+        colliders.resize(header.colliderCount);
+        if (header.colliderCount > 0)
+            memcpy(&colliders[0], p, header.colliderCount * sizeof(LevelCollider));
+    }
+    else
+    {
+        printf("Warning: %s is not a valid version %u level file\n", path, LEVEL_FILE_VERSION);
+        fflush(stdout);
+    }
+
+    Platform::unmapFile(file);
+    return ok;
+}
+
+LevelData LevelData::defaultRoad()
+{
+    LevelData data;
+    data.kind = LEVEL_ROAD;
+    return data;
+}
+
+LevelData LevelData::defaultParking()
+{
+    LevelData data;
+    data.kind = LEVEL_PARKING;
+
+    // Four cones around the spot and Sayes standing in it
+    const float cones[][2] = {{5, 15}, {15, 15}, {5, 25}, {15, 25}};
+    for (const auto &pos : cones)
+    {
+        LevelCollider cone = {COLLIDER_CONE, pos[0], pos[1], 0.5f, 0.5f};
+        data.colliders.push_back(cone);
+    }
+
+    LevelCollider sayes = {COLLIDER_PERSON, 8.0f, 22.0f, 0.8f, 0.8f};
+    data.colliders.push_back(sayes);
+    return data;
+}
@@ -0,0 +1,124 @@
+#ifndef LEVEL_DATA_H
+#define LEVEL_DATA_H
+
+#include <stdint.h>
+#include <vector>
+
+// Level descriptions. Levels are authored as text (levels/*.lvl) and
+// compiled by tools/LevelCompiler.cpp into a binary .lvb that is the
+// in-memory layout of the structs below, so loading is one read and a
+// memcpy. Every field is 4 bytes and files are little endian like every
+// target we build for. The defaults are the values the game shipped with
+// before levels were data, and are used when no file is found.
+
+static const char LEVEL_FILE_MAGIC[4] = {'E', 'D', 'L', 'V'};
+static const uint32_t LEVEL_FILE_VERSION = 2;
+
+enum LevelKind
+{
+    LEVEL_ROAD = 1,   // Level1
+    LEVEL_PARKING = 2 // Level2
+};
+
+// Traffic tuning knobs. The defaults are the hand-tuned values the game
+// ships with; tools/TrafficEval.cpp sweeps them.
+struct TrafficParams
+{
+    TrafficParams()
+        : spawnChance(2), minSpeed(0.05f), speedSteps(5), spawnAhead(100), spawnWindow(50), powerupChance(500),
+          powerupAhead(150), powerupWindow(50) {}
+
+    int spawnChance;   // Percent chance per tick that a free traffic slot spawns a car
+    float minSpeed;    // Car speeds are minSpeed + [0, speedSteps) / 100
+    int speedSteps;
+    int spawnAhead;    // Cars spawn spawnAhead..spawnAhead + spawnWindow ahead of the player
+    int spawnWindow;
+    int powerupChance; // A free power-up slot respawns with a 1 in powerupChance chance per tick
+    int powerupAhead;  // Power-ups respawn powerupAhead..powerupAhead + powerupWindow ahead
+    int powerupWindow;
+};
+
+// Level1: a straight road along +z with repeating buildings and lamp posts
+struct RoadDesc
+{
+    RoadDesc()
+        : width(20.0f), length(200.0f), laneWidth(4.0f), buildingSpacing(30.0f), buildingGap(10.0f),
+          buildingWidth(10.0f), buildingLength(20.0f), buildingHeight(10.0f), lampSpacing(30.0f), lampPhase(15.0f),
+          lampGap(2.0f), finishZ(1000.0f), trafficSize(10), powerupCount(5) {}
+
+    float width;     // Centred on x = 0
+    float length;    // Initial power-ups are scattered over this stretch
+    float laneWidth; // Traffic lanes, as many as fit across width
+
+    // Buildings every buildingSpacing, centred buildingGap outside each road edge
+    float buildingSpacing;
+    float buildingGap;
+    float buildingWidth, buildingLength, buildingHeight;
+
+    // Lamp posts at z = k * lampSpacing + lampPhase, lampGap outside each road edge
+    float lampSpacing;
+    float lampPhase;
+    float lampGap;
+
+    float finishZ; // Win once the player passes this
+
+    int trafficSize; // Traffic slots
+    TrafficParams traffic;
+    int powerupCount;
+};
+
+// Level2: a square lot with one target spot; colliders hold cones and people
+struct ParkingDesc
+{
+    ParkingDesc()
+        : lotHalfSize(50.0f), spotX(10.0f), spotZ(20.0f), spotWidth(2.5f), spotLength(4.0f),
+          parkSeconds(3.0f), parkSpeed(0.01f) {}
+
+    float lotHalfSize;
+    float spotX, spotZ, spotWidth, spotLength;
+    float parkSeconds; // Win after staying this long in the spot
+    float parkSpeed;   // below this speed
+};
+
+enum ColliderKind
+{
+    COLLIDER_CONE = 0,
+    COLLIDER_PERSON = 1, // Sayes
+    COLLIDER_BOX = 2     // Invisible wall
+};
+
+struct LevelCollider
+{
+    uint32_t kind; // ColliderKind
+    float x, z;
+    float width, length;
+};
+
+// File layout: LevelFileHeader, RoadDesc, ParkingDesc, then colliderCount LevelColliders
+struct LevelFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t kind; // LevelKind
+    uint32_t colliderCount;
+};
+
+struct LevelData
+{
+    LevelData() : kind(0) {}
+
+    uint32_t kind;
+    RoadDesc road;
+    ParkingDesc parking;
+    std::vector<LevelCollider> colliders;
+
+    // Reads a compiled .lvb. Returns false, leaving this untouched, if the
+    // file is missing, truncated, from another version or out of range.
+    bool load(const char *path);
+
+    // The built-in levels
+    static LevelData defaultRoad();
+    static LevelData defaultParking();
+};
+
+#endif
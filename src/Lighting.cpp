@@ -0,0 +1,417 @@
+#include "Lighting.h"
+#include "GLExtensions.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+static const int CLUSTER_COUNT = 16;
+static const float CLUSTER_DEPTH = 16.0f; // Eye-space depth of one slice, the last slice runs to the far plane
+static const int MAX_INDICES = 256;       // Light references over all slices
+static const GLuint LIGHT_BLOCK_BINDING = 0;
+
+// std140 image of the shader's LightBlock
+struct LightBlock
+{
+    float sunDirection[4]; // Eye space, towards the sun
+    float sunAmbient[4];
+    float sunDiffuse[4];
+    float clusterScale[4]; // x = slices per unit of depth
+    float lightPosition[Lighting::MAX_LIGHTS][4];    // Eye space, w = range
+    float lightColor[Lighting::MAX_LIGHTS][4];
+    float lightSpot[Lighting::MAX_LIGHTS][4];        // Eye space direction, w = cos(cutoff)
+    float lightAttenuation[Lighting::MAX_LIGHTS][4]; // constant, linear, quadratic, spot exponent
+    int32_t clusters[CLUSTER_COUNT][4];              // x = first index, y = count
+    int32_t indices[MAX_INDICES];                    // Packed four to an ivec4
+    float sunShadow[Lighting::SUN_CASCADES][16];     // Eye space to shadow map, column major
+    float spotShadow[Lighting::SPOT_SHADOWS][16];
+    float shadowEnabled[4];                          // x = sun, y = spots
+};
+
+static const char *VERTEX_SHADER =
+    "#version 120\n"
+    "varying vec3 eyePosition;\n"
+    "varying vec3 eyeNormal;\n"
+    "void main()\n"
+    "{\n"
+    "    eyePosition = (gl_ModelViewMatrix * gl_Vertex).xyz;\n"
+    "    eyeNormal = gl_NormalMatrix * gl_Normal;\n"
+    "    gl_FrontColor = gl_Color;\n"
+    "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+    "    gl_Position = ftransform();\n"
+    "}\n";
+
+// The light block and how much of light i reaches an eye-space point, shared
+// with every program lit by this module (see Lighting::buildProgram())
+static const char *SHADER_HEADER =
+    "#version 120\n"
+    "#extension GL_ARB_uniform_buffer_object : require\n"
+    "#define MAX_LIGHTS 64\n"
+    "#define CLUSTER_COUNT 16\n"
+    "#define MAX_INDICES 256\n"
+    "#define SUN_CASCADES 3\n"
+    "#define SPOT_SHADOWS 2\n"
+    "#define SHADOW_MARGIN 0.002\n"
+    "layout(std140) uniform LightBlock\n"
+    "{\n"
+    "    vec4 sunDirection;\n"
+    "    vec4 sunAmbient;\n"
+    "    vec4 sunDiffuse;\n"
+    "    vec4 clusterScale;\n"
+    "    vec4 lightPosition[MAX_LIGHTS];\n"
+    "    vec4 lightColor[MAX_LIGHTS];\n"
+    "    vec4 lightSpot[MAX_LIGHTS];\n"
+    "    vec4 lightAttenuation[MAX_LIGHTS];\n"
+    "    ivec4 clusters[CLUSTER_COUNT];\n"
+    "    ivec4 lightIndices[MAX_INDICES / 4];\n"
+    "    mat4 sunShadowMatrix[SUN_CASCADES];\n"
+    "    mat4 spotShadowMatrix[SPOT_SHADOWS];\n"
+    "    vec4 shadowEnabled;\n"
+    "};\n"
+    "uniform sampler2DShadow sunShadowMap;\n"
+    "uniform sampler2DShadow spotShadowMap;\n"
+    "// 1 if lit, 0 if shadowed. The maps of one kind sit side by side in one\n"
+    "// texture, tile is where p.x falls in it; outside its tile means no cover.\n"
+    "float shadowTile(sampler2DShadow map, vec3 p, int tile, int tiles)\n"
+    "{\n"
+    "    float x = p.x * float(tiles) - float(tile);\n"
+    "    if (x < SHADOW_MARGIN || x > 1.0 - SHADOW_MARGIN || p.y < SHADOW_MARGIN || p.y > 1.0 - SHADOW_MARGIN ||\n"
+    "        p.z > 1.0)\n"
+    "        return -1.0;\n"
+    "    return shadow2D(map, p).r;\n"
+    "}\n"
+    "// The finest cascade that covers the point\n"
+    "float sunShadow(vec3 position)\n"
+    "{\n"
+    "    if (shadowEnabled.x == 0.0)\n"
+    "        return 1.0;\n"
+    "    for (int c = 0; c < SUN_CASCADES; c++)\n"
+    "    {\n"
+    "        float lit = shadowTile(sunShadowMap, (sunShadowMatrix[c] * vec4(position, 1.0)).xyz, c, SUN_CASCADES);\n"
+    "        if (lit >= 0.0)\n"
+    "            return lit;\n"
+    "    }\n"
+    "    return 1.0;\n"
+    "}\n"
+    "float spotShadow(int s, vec3 position)\n"
+    "{\n"
+    "    vec4 p = spotShadowMatrix[s] * vec4(position, 1.0);\n"
+    "    if (p.w <= 0.0)\n"
+    "        return 1.0;\n"
+    "    return max(shadowTile(spotShadowMap, p.xyz / p.w, s, SPOT_SHADOWS), 0.0);\n"
+    "}\n"
+    "ivec4 lightCluster(vec3 position)\n"
+    "{\n"
+    "    return clusters[int(clamp(-position.z * clusterScale.x, 0.0, float(CLUSTER_COUNT - 1)))];\n"
+    "}\n"
+    "int lightIndex(int k)\n"
+    "{\n"
+    "    return lightIndices[k / 4][k - (k / 4) * 4];\n"
+    "}\n"
+    "// Attenuation times spot falloff and shadow, 0 out of range or outside the cone; l points to the light\n"
+    "float lightAmount(int i, vec3 position, out vec3 l)\n"
+    "{\n"
+    "    vec3 toLight = lightPosition[i].xyz - position;\n"
+    "    float d = length(toLight);\n"
+    "    l = toLight / max(d, 1e-4);\n"
+    "    if (d >= lightPosition[i].w)\n"
+    "        return 0.0;\n"
+    "    vec4 k4 = lightAttenuation[i];\n"
+    "    float amount = 1.0 / (k4.x + k4.y * d + k4.z * d * d);\n"
+    "    if (lightSpot[i].w > -1.0)\n"
+    "    {\n"
+    "        float spot = dot(-l, lightSpot[i].xyz);\n"
+    "        if (spot < lightSpot[i].w)\n"
+    "            return 0.0;\n"
+    "        amount *= pow(spot, k4.w);\n"
+    "    }\n"
+    "    if (shadowEnabled.y != 0.0 && lightColor[i].w >= 0.0)\n"
+    "        amount *= spotShadow(int(lightColor[i].w), position);\n"
+    "    return amount;\n"
+    "}\n";
+
+static const char *FRAGMENT_SHADER =
+    "uniform sampler2D diffuseMap;\n"
+    "uniform bool textured;\n"
+    "varying vec3 eyePosition;\n"
+    "varying vec3 eyeNormal;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 base = gl_Color;\n"
+    "    if (textured)\n"
+    "        base *= texture2D(diffuseMap, gl_TexCoord[0].st);\n"
+    "    vec3 n = normalize(eyeNormal);\n"
+    "    vec3 v = normalize(-eyePosition);\n"
+    "    float shininess = max(gl_FrontMaterial.shininess, 1.0);\n"
+    "\n"
+    "    float sunLit = sunShadow(eyePosition);\n"
+    "    float sunLambert = max(dot(n, sunDirection.xyz), 0.0);\n"
+    "    vec3 diffuse = gl_LightModel.ambient.rgb + sunAmbient.rgb + sunDiffuse.rgb * sunLambert * sunLit;\n"
+    "    vec3 specular = vec3(0.0);\n"
+    "    if (sunLambert > 0.0)\n"
+    "        specular += sunLit * pow(max(dot(n, normalize(sunDirection.xyz + v)), 0.0), shininess);\n"
+    "\n"
+    "    ivec4 cluster = lightCluster(eyePosition);\n"
+    "    for (int k = cluster.x; k < cluster.x + cluster.y; k++)\n"
+    "    {\n"
+    "        int i = lightIndex(k);\n"
+    "        vec3 l;\n"
+    "        float amount = lightAmount(i, eyePosition, l);\n"
+    "        if (amount <= 0.0)\n"
+    "            continue;\n"
+    "        float lambert = max(dot(n, l), 0.0);\n"
+    "        diffuse += lightColor[i].rgb * lambert * amount;\n"
+    "        if (lambert > 0.0)\n"
+    "            specular += lightColor[i].rgb * amount * pow(max(dot(n, normalize(l + v)), 0.0), shininess);\n"
+    "    }\n"
+    "\n"
+    "    gl_FragColor = vec4(base.rgb * diffuse + gl_FrontMaterial.specular.rgb * specular, base.a);\n"
+    "}\n";
+
+bool Lighting::active = false;
+unsigned int Lighting::program = 0;
+unsigned int Lighting::buffer = 0;
+int Lighting::texturedLocation = -1;
+bool Lighting::textured = false;
+
+static bool bound = false; // Program in use, uniforms can be set
+static float view[16];      // Column major, from GL_MODELVIEW_MATRIX at beginFrame()
+static LightBlock block;
+static std::vector<Light> queued;
+
+static GLuint compile(GLenum type, const char *source)
+{
+    GLuint shader = GLExtensions::createShader(type);
+    GLExtensions::shaderSource(shader, 1, &source, NULL);
+    GLExtensions::compileShader(shader);
+
+    GLint ok = 0;
+    GLExtensions::getShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok)
+    {
+        char log[1024];
+        GLExtensions::getShaderInfoLog(shader, sizeof(log), NULL, log);
+        printf("Lighting: shader failed to compile:\n%s\n", log);
+        GLExtensions::deleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+unsigned int Lighting::buildProgram(const char *vertexSource, const char *fragmentSource)
+{
+    GLuint vertex = compile(GL_VERTEX_SHADER, vertexSource);
+    std::string fragmentText = std::string(SHADER_HEADER) + fragmentSource;
+    GLuint fragment = compile(GL_FRAGMENT_SHADER, fragmentText.c_str());
+    if (!vertex || !fragment)
+        return 0;
+
+    GLuint linked = GLExtensions::createProgram();
+    GLExtensions::attachShader(linked, vertex);
+    GLExtensions::attachShader(linked, fragment);
+    GLExtensions::linkProgram(linked);
+    GLExtensions::deleteShader(vertex);
+    GLExtensions::deleteShader(fragment);
+
+    GLint ok = 0;
+    GLExtensions::getProgramiv(linked, GL_LINK_STATUS, &ok);
+    GLuint blockIndex = ok ? GLExtensions::getUniformBlockIndex(linked, "LightBlock") : GL_INVALID_INDEX;
+    if (blockIndex == GL_INVALID_INDEX)
+    {
+        char log[1024] = "";
+        GLExtensions::getProgramInfoLog(linked, sizeof(log), NULL, log);
+        printf("Lighting: shader failed to link:\n%s\n", log);
+        return 0;
+    }
+    GLExtensions::uniformBlockBinding(linked, blockIndex, LIGHT_BLOCK_BINDING);
+
+    GLExtensions::useProgram(linked);
+    GLExtensions::uniform1i(GLExtensions::getUniformLocation(linked, "sunShadowMap"), SUN_SHADOW_UNIT);
+    GLExtensions::uniform1i(GLExtensions::getUniformLocation(linked, "spotShadowMap"), SPOT_SHADOW_UNIT);
+    GLExtensions::useProgram(0);
+    return linked;
+}
+
+bool Lighting::init()
+{
+    GLExtensions::load();
+    if (!GLExtensions::hasShaders || !GLExtensions::hasUniformBuffers)
+    {
+        printf("Lighting: no shader support, using fixed-function lights\n");
+        return false;
+    }
+
+    program = buildProgram(VERTEX_SHADER, FRAGMENT_SHADER);
+    if (!program)
+        return false;
+
+    GLExtensions::genBuffers(1, &buffer);
+    GLExtensions::bindBuffer(GL_UNIFORM_BUFFER, buffer);
+    GLExtensions::bufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), NULL, GL_DYNAMIC_DRAW);
+    GLExtensions::bindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, buffer);
+
+    GLExtensions::useProgram(program);
+    GLExtensions::uniform1i(GLExtensions::getUniformLocation(program, "diffuseMap"), 0);
+    texturedLocation = GLExtensions::getUniformLocation(program, "textured");
+    GLExtensions::uniform1i(texturedLocation, 0);
+    GLExtensions::useProgram(0);
+
+    queued.reserve(MAX_LIGHTS);
+    active = true;
+    printf("Lighting: per-pixel shader, up to %d lights\n", MAX_LIGHTS);
+    return true;
+}
+
+const float *Lighting::getViewMatrix()
+{
+    return view;
+}
+
+// Eye space = view * world
+static void toEye(float x, float y, float z, float w, float out[4])
+{
+    for (int row = 0; row < 3; row++)
+        out[row] = view[row] * x + view[4 + row] * y + view[8 + row] * z + view[12 + row] * w;
+}
+
+void Lighting::beginFrame(const float sunPosition[3], float ambient, float diffuse)
+{
+    glGetFloatv(GL_MODELVIEW_MATRIX, view);
+    queued.clear();
+
+    float length = sqrtf(sunPosition[0] * sunPosition[0] + sunPosition[1] * sunPosition[1] +
+                         sunPosition[2] * sunPosition[2]);
+    if (length <= 0.0f)
+        length = 1.0f;
+    toEye(sunPosition[0] / length, sunPosition[1] / length, sunPosition[2] / length, 0.0f, block.sunDirection);
+    block.sunDirection[3] = 0.0f;
+
+    for (int c = 0; c < 3; c++)
+    {
+        block.sunAmbient[c] = ambient;
+        block.sunDiffuse[c] = diffuse;
+    }
+    block.sunAmbient[3] = block.sunDiffuse[3] = 1.0f;
+    block.clusterScale[0] = 1.0f / CLUSTER_DEPTH;
+    setShadows(NULL, NULL);
+}
+
+// Eye space to map = world to map * inverse view. The view is a rotation
+// and a translation, so its inverse is the transposed rotation and the
+// translation turned back.
+static void eyeToMap(const float worldToMap[16], float out[16])
+{
+    float inverse[16] = {view[0], view[4], view[8], 0.0f, view[1], view[5], view[9], 0.0f,
+                         view[2], view[6], view[10], 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+    for (int row = 0; row < 3; row++)
+        inverse[12 + row] = -(inverse[row] * view[12] + inverse[4 + row] * view[13] + inverse[8 + row] * view[14]);
+
+    for (int column = 0; column < 4; column++)
+        for (int row = 0; row < 4; row++)
+            out[column * 4 + row] = worldToMap[row] * inverse[column * 4] + worldToMap[4 + row] * inverse[column * 4 + 1] +
+                                    worldToMap[8 + row] * inverse[column * 4 + 2] +
+                                    worldToMap[12 + row] * inverse[column * 4 + 3];
+}
+
+void Lighting::setShadows(const float (*sunMatrices)[16], const float (*spotMatrices)[16])
+{
+    block.shadowEnabled[0] = sunMatrices ? 1.0f : 0.0f;
+    block.shadowEnabled[1] = spotMatrices ? 1.0f : 0.0f;
+    for (int c = 0; c < SUN_CASCADES && sunMatrices; c++)
+        eyeToMap(sunMatrices[c], block.sunShadow[c]);
+    for (int s = 0; s < SPOT_SHADOWS && spotMatrices; s++)
+        eyeToMap(spotMatrices[s], block.spotShadow[s]);
+}
+
+void Lighting::addLight(const Light &light)
+{
+    if ((int)queued.size() < MAX_LIGHTS)
+        queued.push_back(light);
+}
+
+void Lighting::upload()
+{
+    PROFILE_ZONE("Lighting::upload");
+
+    int count = (int)queued.size();
+    int first[MAX_LIGHTS];
+    int last[MAX_LIGHTS];
+
+    // Eye-space lights and the range of slices each one reaches
+    for (int i = 0; i < count; i++)
+    {
+        const Light &light = queued[i];
+        toEye(light.x, light.y, light.z, 1.0f, block.lightPosition[i]);
+        block.lightPosition[i][3] = light.range;
+        toEye(light.dirX, light.dirY, light.dirZ, 0.0f, block.lightSpot[i]);
+        block.lightSpot[i][3] = light.spotCutoff >= 180.0f ? -1.0f : cosf(light.spotCutoff * 3.14159f / 180.0f);
+
+        float length = sqrtf(block.lightSpot[i][0] * block.lightSpot[i][0] + block.lightSpot[i][1] * block.lightSpot[i][1] +
+                             block.lightSpot[i][2] * block.lightSpot[i][2]);
+        for (int c = 0; c < 3 && length > 0.0f; c++)
+            block.lightSpot[i][c] /= length;
+
+        block.lightColor[i][0] = light.r;
+        block.lightColor[i][1] = light.g;
+        block.lightColor[i][2] = light.b;
+        block.lightColor[i][3] = (float)light.shadowMap;
+        block.lightAttenuation[i][0] = light.constant;
+        block.lightAttenuation[i][1] = light.linear;
+        block.lightAttenuation[i][2] = light.quadratic;
+        block.lightAttenuation[i][3] = light.spotExponent;
+
+        float depth = -block.lightPosition[i][2];
+        first[i] = std::max(0, std::min(CLUSTER_COUNT - 1, (int)floorf((depth - light.range) / CLUSTER_DEPTH)));
+        last[i] = std::min(CLUSTER_COUNT - 1, (int)floorf((depth + light.range) / CLUSTER_DEPTH));
+    }
+
+    // Fill the slices front to back, each one a run of light indices
+    int used = 0;
+    for (int s = 0; s < CLUSTER_COUNT; s++)
+    {
+        block.clusters[s][0] = used;
+        for (int i = 0; i < count && used < MAX_INDICES; i++)
+        {
+            if (first[i] <= s && s <= last[i])
+                block.indices[used++] = i;
+        }
+        block.clusters[s][1] = used - block.clusters[s][0];
+    }
+
+    GLExtensions::bindBuffer(GL_UNIFORM_BUFFER, buffer);
+    GLExtensions::bufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightBlock), &block);
+}
+
+void Lighting::enable()
+{
+    glEnable(GL_LIGHTING);
+    if (active && !bound)
+    {
+        GLExtensions::useProgram(program);
+        GLExtensions::uniform1i(texturedLocation, textured ? 1 : 0);
+        bound = true;
+    }
+}
+
+void Lighting::disable()
+{
+    glDisable(GL_LIGHTING);
+    if (active && bound)
+    {
+        GLExtensions::useProgram(0);
+        bound = false;
+    }
+}
+
+void Lighting::setTextured(bool isTextured)
+{
+    if (isTextured == textured)
+        return;
+
+    textured = isTextured;
+    if (bound)
+        GLExtensions::uniform1i(texturedLocation, textured ? 1 : 0);
+}
@@ -0,0 +1,85 @@
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+// One light for the shader path, with the same meaning as the glLight
+// parameters it replaces
+struct Light
+{
+    float x, y, z;                     // World space
+    float dirX, dirY, dirZ;            // Spot direction, ignored for point lights
+    float r, g, b;
+    float spotCutoff;                  // Degrees, 180 is a point light
+    float spotExponent;
+    float constant, linear, quadratic; // Attenuation 1 / (c + l * d + q * d^2)
+    float range;                       // Nothing is lit beyond this
+    int shadowMap;                     // Spot shadow map, 0 .. SPOT_SHADOWS - 1, or -1 for none
+};
+
+// Per-pixel lighting in a GLSL program, used when the driver has GL 2.0
+// shaders and uniform buffers; otherwise callers keep the fixed-function
+// lights. Each frame the sun and a list of headlights and street lamps go
+// into one uniform block with a single buffer update. Lights are binned
+// into slices of eye-space depth (a 1D cluster grid, the road runs away
+// from the camera), so a pixel only evaluates the lights that reach its
+// slice and dozens of lamps cost little more than two.
+class Lighting
+{
+public:
+    static const int MAX_LIGHTS = 64;
+
+    // Shadow maps the shader samples (see Shadows), bound to their own
+    // texture units so materials can use the ones below
+    static const int SUN_CASCADES = 3;
+    static const int SPOT_SHADOWS = 2;
+    static const int SUN_SHADOW_UNIT = 5;
+    static const int SPOT_SHADOW_UNIT = 6;
+
+    // Builds the program once a context exists. Returns false, and leaves the
+    // fixed-function path in charge, if the driver cannot run it.
+    static bool init();
+    static bool isActive() { return active; }
+
+    // Call right after the camera is set: takes the view matrix, sets the
+    // sun (a direction towards sunPosition) and empties the light list
+    static void beginFrame(const float sunPosition[3], float ambient, float diffuse);
+
+    // Queues a light for this frame, ignored once MAX_LIGHTS are queued
+    static void addLight(const Light &light);
+
+    // World to shadow map texture coordinates for this frame, one matrix per
+    // sun cascade and per spot map; NULL (the default after beginFrame())
+    // leaves that kind of light unshadowed
+    static void setShadows(const float (*sunMatrices)[16], const float (*spotMatrices)[16]);
+
+    // Bins the queued lights and uploads the block. Call after every
+    // addLight() and before drawing anything lit.
+    static void upload();
+
+    // Stand-ins for glEnable/glDisable(GL_LIGHTING): the shader is bound
+    // while lighting is on, so unlit draws (HUD text, light beams) still
+    // go through the fixed-function pipeline
+    static void enable();
+    static void disable();
+
+    // Textured draws, the shader can't see glEnable(GL_TEXTURE_2D)
+    static void setTextured(bool textured);
+
+    // Links another program lit by the same lights. The fragment source gets
+    // the #version line, the LightBlock uniform block and the GLSL helpers
+    // lightCluster(), lightIndex(), lightAmount() (shadowed) and sunShadow()
+    // put in front of it.
+    // Returns 0, after printing the log, if it fails.
+    static unsigned int buildProgram(const char *vertexSource, const char *fragmentSource);
+
+    // Column major, as taken by beginFrame()
+    static const float *getViewMatrix();
+
+private:
+    static bool active;
+    static unsigned int program;
+    static unsigned int buffer;
+    static int texturedLocation;
+    static bool textured;
+};
+
+#endif
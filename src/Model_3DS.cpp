@@ -79,8 +79,12 @@
 // #include "stdafx.h"
 #include <string>
 #include "Model_3DS.h"
+#include "Lighting.h"
+#include "Profiler.h"
+#include "TextureStreamer.h"
 
 #include <math.h> // Header file for the math library
+#include <string.h>
 #include <GL/glut.h>
 
 // The chunk's id numbers
@@ -169,14 +173,33 @@ Model_3DS::Model_3DS()
 
     // Set the scale to one
     scale = 1.0f;
+    radius = 0.0f;
 }
 
 Model_3DS::~Model_3DS()
 {
+    // Free the geometry, the textures themselves are left to OpenGL
+    for (int i = 0; i < numObjects && Objects != NULL; i++)
+    {
+        delete[] Objects[i].Vertexes;
+        delete[] Objects[i].Normals;
+        delete[] Objects[i].TexCoords;
+        delete[] Objects[i].Faces;
+
+        for (int j = 0; j < Objects[i].numMatFaces && Objects[i].MatFaces != NULL; j++)
+            delete[] Objects[i].MatFaces[j].subFaces;
+        delete[] Objects[i].MatFaces;
+    }
+
+    delete[] Objects;
+    delete[] Materials;
+    delete[] path;
 }
 
 void Model_3DS::Load(char *name)
 {
+    PROFILE_ZONE("Model_3DS::Load");
+
     // holds the main chunk header
     ChunkHeader main;
 
@@ -248,14 +271,22 @@ void Model_3DS::Load(char *name)
     // For future reference
     modelname = name;
 
-    // Find the total number of faces and vertices
+    // Find the total number of faces and vertices, and how far they reach
     totalFaces = 0;
     totalVerts = 0;
+    radius = 0.0f;
 
     for (int i = 0; i < numObjects; i++)
     {
         totalFaces += Objects[i].numFaces / 3;
         totalVerts += Objects[i].numVerts;
+        for (int v = 0; Objects[i].Vertexes != NULL && v < Objects[i].numVerts; v++)
+        {
+            const float *p = &Objects[i].Vertexes[3 * v];
+            float d = sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+            if (d > radius)
+                radius = d;
+        }
     }
 
     // If the object doesn't have any texcoords generate some
@@ -286,7 +317,7 @@ void Model_3DS::Load(char *name)
             unsigned char r = Materials[j].color.r;
             unsigned char g = Materials[j].color.g;
             unsigned char b = Materials[j].color.b;
-            Materials[j].tex.BuildColorTexture(r, g, b);
+            Materials[j].tex.BuildPaletteColor(r, g, b);
             Materials[j].textured = true;
         }
     }
@@ -294,6 +325,8 @@ void Model_3DS::Load(char *name)
 
 void Model_3DS::Draw()
 {
+    PROFILE_GPU_ZONE("Model_3DS::Draw");
+
     static bool debugOnce = true;
 
     // Safety check - don't draw if no objects loaded
@@ -331,11 +364,17 @@ void Model_3DS::Draw()
         // Scale the model (applied to vertices first)
         glScalef(scale, scale, scale);
 
+        // Streamed textures load the mips this size on screen needs
+        float screenSize = TextureStreamer::projectedSize(radius);
+
         int drawnCount = 0;
         int matFaceDrawn = 0;
         int fallbackDrawn = 0;
         int totalSubFaces = 0;
 
+        // Solid colors all live in one palette texture, so it's only bound once
+        GLuint boundTexture = 0;
+
         // Loop through the objects
         for (int i = 0; i < numObjects; i++)
         {
@@ -359,11 +398,13 @@ void Model_3DS::Draw()
             }
 
             // Enable texture coords if available
-            if (Objects[i].textured && Objects[i].TexCoords != NULL)
+            bool hasTexCoords = Objects[i].textured && Objects[i].TexCoords != NULL;
+            if (hasTexCoords)
             {
                 glEnableClientState(GL_TEXTURE_COORD_ARRAY);
                 glTexCoordPointer(2, GL_FLOAT, 0, Objects[i].TexCoords);
             }
+            Lighting::setTextured(hasTexCoords);
 
             // If we have material faces, use indexed drawing
             if (Objects[i].numMatFaces > 0 && Objects[i].MatFaces != NULL)
@@ -385,7 +426,29 @@ void Model_3DS::Draw()
                     if (Materials != NULL && matIdx >= 0 && matIdx < numMaterials)
                     {
                         // Use the material's texture
-                        Materials[matIdx].tex.Use();
+                        GLTexture &tex = Materials[matIdx].tex;
+                        if (tex.texture[0] != boundTexture)
+                        {
+                            tex.Use();
+                            TextureStreamer::request(tex.texture[0], screenSize);
+                            boundTexture = tex.texture[0];
+                        }
+
+                        // A palette color is one texel, every vertex samples it
+                        if (tex.paletted)
+                        {
+                            glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+                            glTexCoord2fv(tex.paletteCoord);
+                            Lighting::setTextured(true);
+                        }
+                        else if (hasTexCoords)
+                        {
+                            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+                        }
+                        else
+                        {
+                            Lighting::setTextured(false);
+                        }
                     }
 
                     glPushMatrix();
@@ -430,6 +493,7 @@ void Model_3DS::Draw()
             glDisableClientState(GL_VERTEX_ARRAY);
             glDisableClientState(GL_NORMAL_ARRAY);
             glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+            Lighting::setTextured(false);
         }
 
         if (debugOnce)
@@ -856,30 +920,40 @@ void Model_3DS::MapNameChunkProcessor(long length, long findex, int matindex)
         }
     }
 
-    std::string n = name;
+    // Load the name and indicate that the material has a texture
+    char fullname[256];
+    sprintf(fullname, "%s%s", path, name);
 
-    // Safely change extension to .bmp
-    if (n.length() >= 4)
+    // Use the texture in its own format (png, jpg, ...) when the file is
+    // there, otherwise look for a .bmp of the same name as we always did
+    FILE *texture = fopen(fullname, "rb");
+    if (texture)
+        fclose(texture);
+    else
     {
-        // Find the last dot for extension
-        size_t dotPos = n.rfind('.');
-        if (dotPos != std::string::npos)
+        std::string n = name;
+
+        // Safely change extension to .bmp
+        if (n.length() >= 4)
         {
-            n = n.substr(0, dotPos) + ".bmp";
+            // Find the last dot for extension
+            size_t dotPos = n.rfind('.');
+            if (dotPos != std::string::npos)
+            {
+                n = n.substr(0, dotPos) + ".bmp";
+            }
+            else
+            {
+                n += ".bmp"; // No extension, just append
+            }
         }
         else
         {
-            n += ".bmp"; // No extension, just append
+            n += ".bmp"; // Very short name, just append
         }
-    }
-    else
-    {
-        n += ".bmp"; // Very short name, just append
-    }
 
-    // Load the name and indicate that the material has a texture
-    char fullname[256];
-    sprintf(fullname, "%s%s", path, n.c_str());
+        sprintf(fullname, "%s%s", path, n.c_str());
+    }
 
     Materials[matindex].tex.Load(fullname);
 
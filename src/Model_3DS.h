@@ -121,7 +121,7 @@ public:
     struct ChunkHeader
     {
         unsigned short id; // The chunk's id
-        unsigned long len; // The lenght of the chunk
+        unsigned int len;  // The lenght of the chunk (32 bits in the file)
     };
 
     // I sort the mesh by material so that I won't have to switch textures a great deal
@@ -162,6 +162,7 @@ public:
     Vector pos;            // The position to move the model to
     Vector rot;            // The angles to rotate the model
     float scale;           // The size you want the model scaled to
+    float radius;          // Distance of the farthest vertex from the origin, before scaling
     bool lit;              // True: the model is lit
     bool visible;          // True: the model gets rendered
     void Load(char *name); // Loads a model
@@ -171,6 +172,10 @@ public:
     virtual ~Model_3DS();  // Destructor
 
 private:
+    // Owns raw arrays, so copying is not allowed
+    Model_3DS(const Model_3DS &);
+    Model_3DS &operator=(const Model_3DS &);
+
     void IntColorChunkProcessor(long length, long findex, int matindex);
     void FloatColorChunkProcessor(long length, long findex, int matindex);
     // Processes the Main Chunk that all the other chunks exist is
@@ -0,0 +1,372 @@
+#include "ObjMesh.h"
+#include "GLExtensions.h"
+#include "Platform.h"
+#include "Profiler.h"
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+
+ObjMesh::ObjMesh()
+{
+    vertexBuffer = indexBuffer = 0;
+    radius = 0.0f;
+    for (int c = 0; c < 3; c++)
+        boundsMin[c] = boundsMax[c] = 0.0f;
+}
+
+static const int KEY_LIMIT = 1 << 21; // Texcoords or normals a vertex key can tell apart
+
+static const char *skipSpaces(const char *p)
+{
+    while (*p == ' ' || *p == '\t')
+        p++;
+    return p;
+}
+
+// 1-based, negative counts back from the last element read so far; -1 if absent or out of range
+static int readIndex(const char *&p, size_t count)
+{
+    char *end;
+    long index = strtol(p, &end, 10);
+    if (end == p)
+        return -1;
+    p = end;
+    if (index < 0)
+        index += (long)count + 1;
+    return index >= 1 && (size_t)index <= count ? (int)index - 1 : -1;
+}
+
+bool ObjMesh::load(const char *path)
+{
+    PROFILE_ZONE("ObjMesh::load");
+
+    Platform::MappedFile file;
+    if (!Platform::mapFile(path, file))
+    {
+        printf("Warning: could not open %s\n", path);
+        fflush(stdout);
+        return false;
+    }
+
+    std::vector<float> positions, texCoords, normals;
+    std::vector<std::string> materials(1); // Faces before any usemtl use ""
+    std::vector<std::vector<uint32_t> > triangles(1);
+    size_t material = 0;
+    std::unordered_map<uint64_t, uint32_t> lookup;
+    std::vector<bool> hasNormal;
+    std::vector<uint32_t> polygon;
+    std::string line;
+
+    vertices.clear();
+    const char *p = (const char *)file.data, *end = p + file.size;
+    while (p < end)
+    {
+        const char *eol = (const char *)memchr(p, '\n', end - p);
+        if (!eol)
+            eol = end;
+        line.assign(p, eol);
+        p = eol + 1;
+
+        const char *s = skipSpaces(line.c_str());
+        if (s[0] == 'v' && (s[1] == ' ' || s[1] == '\t'))
+        {
+            char *next = (char *)s + 1;
+            for (int c = 0; c < 3; c++)
+                positions.push_back(strtof(next, &next));
+        }
+        else if (s[0] == 'v' && s[1] == 't')
+        {
+            char *next = (char *)s + 2;
+            for (int c = 0; c < 2; c++)
+                texCoords.push_back(strtof(next, &next));
+        }
+        else if (s[0] == 'v' && s[1] == 'n')
+        {
+            char *next = (char *)s + 2;
+            for (int c = 0; c < 3; c++)
+                normals.push_back(strtof(next, &next));
+        }
+        else if (s[0] == 'f' && (s[1] == ' ' || s[1] == '\t'))
+        {
+            // Corners are v, v/vt, v//vn or v/vt/vn
+            polygon.clear();
+            s = skipSpaces(s + 1);
+            while (*s)
+            {
+                int v = readIndex(s, positions.size() / 3), vt = -1, vn = -1;
+                if (*s == '/')
+                {
+                    s++;
+                    if (*s != '/')
+                        vt = readIndex(s, texCoords.size() / 2);
+                    if (*s == '/')
+                    {
+                        s++;
+                        vn = readIndex(s, normals.size() / 3);
+                    }
+                }
+                while (*s && *s != ' ' && *s != '\t')
+                    s++;
+                s = skipSpaces(s);
+                if (v < 0)
+                    continue;
+
+                // Shared corners become one vertex. The key holds 22 bits of
+                // v and 21 of vt + 1 and vn + 1; corners past that are never
+                // shared rather than merged with the wrong one.
+                uint64_t key = (uint64_t)v << 42 | (uint64_t)(vt + 1) << 21 | (uint64_t)(vn + 1);
+                bool keyed = v < KEY_LIMIT * 2 && vt + 1 < KEY_LIMIT && vn + 1 < KEY_LIMIT;
+                std::unordered_map<uint64_t, uint32_t>::iterator found = keyed ? lookup.find(key) : lookup.end();
+                if (found != lookup.end())
+                {
+                    polygon.push_back(found->second);
+                    continue;
+                }
+
+                MeshVertex vertex;
+                memset(&vertex, 0, sizeof(vertex));
+                memcpy(vertex.position, &positions[v * 3], sizeof(vertex.position));
+                if (vt >= 0)
+                    memcpy(vertex.texCoord, &texCoords[vt * 2], sizeof(vertex.texCoord));
+                if (vn >= 0)
+                    memcpy(vertex.normal, &normals[vn * 3], sizeof(vertex.normal));
+                if (keyed)
+                    lookup[key] = (uint32_t)vertices.size();
+                polygon.push_back((uint32_t)vertices.size());
+                vertices.push_back(vertex);
+                hasNormal.push_back(vn >= 0);
+            }
+
+            // Fan, fine for the convex polygons modellers export
+            for (size_t k = 2; k < polygon.size(); k++)
+            {
+                triangles[material].push_back(polygon[0]);
+                triangles[material].push_back(polygon[k - 1]);
+                triangles[material].push_back(polygon[k]);
+            }
+        }
+        else if (strncmp(s, "usemtl", 6) == 0 && (s[6] == ' ' || s[6] == '\t'))
+        {
+            std::string name = skipSpaces(s + 6);
+            while (!name.empty() && isspace((unsigned char)name[name.size() - 1]))
+                name.erase(name.size() - 1);
+            for (material = 0; material < materials.size() && materials[material] != name; material++)
+            {
+            }
+            if (material == materials.size())
+            {
+                materials.push_back(name);
+                triangles.resize(materials.size());
+            }
+        }
+    }
+    Platform::unmapFile(file);
+
+    // One run of indices per material
+    indices.clear();
+    groups.clear();
+    for (size_t m = 0; m < materials.size(); m++)
+    {
+        if (triangles[m].empty())
+            continue;
+        MeshGroup group;
+        group.material = materials[m];
+        group.firstIndex = (uint32_t)indices.size();
+        group.indexCount = (uint32_t)triangles[m].size();
+        indices.insert(indices.end(), triangles[m].begin(), triangles[m].end());
+        groups.push_back(group);
+    }
+    if (indices.empty())
+    {
+        printf("Warning: %s has no faces\n", path);
+        fflush(stdout);
+        return false;
+    }
+
+    // Area weighted face normals for corners the file gave none
+    bool missingNormals = false;
+    for (size_t i = 0; i < hasNormal.size(); i++)
+        missingNormals = missingNormals || !hasNormal[i];
+    for (size_t t = 0; missingNormals && t < indices.size(); t += 3)
+    {
+        const float *a = vertices[indices[t]].position, *b = vertices[indices[t + 1]].position,
+                    *c = vertices[indices[t + 2]].position;
+        float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]}, e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        for (int k = 0; k < 3; k++)
+        {
+            if (hasNormal[indices[t + k]])
+                continue;
+            for (int c2 = 0; c2 < 3; c2++)
+                vertices[indices[t + k]].normal[c2] += n[c2];
+        }
+    }
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        float *n = vertices[i].normal;
+        float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        for (int c = 0; c < 3; c++)
+            n[c] = length > 0.0f ? n[c] / length : (c == 1 ? 1.0f : 0.0f);
+    }
+
+    generateTangents();
+
+    radius = 0.0f;
+    for (int c = 0; c < 3; c++)
+    {
+        boundsMin[c] = vertices[0].position[c];
+        boundsMax[c] = vertices[0].position[c];
+    }
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        const float *v = vertices[i].position;
+        for (int c = 0; c < 3; c++)
+        {
+            if (v[c] < boundsMin[c])
+                boundsMin[c] = v[c];
+            if (v[c] > boundsMax[c])
+                boundsMax[c] = v[c];
+        }
+        float d = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if (d > radius)
+            radius = d;
+    }
+
+    printf("Mesh %s: %d vertices, %d triangles, %d materials\n", path, (int)vertices.size(), (int)indices.size() / 3,
+           (int)groups.size());
+    fflush(stdout);
+    return true;
+}
+
+// Per triangle tangent and bitangent from the texture coordinate gradients,
+// summed per vertex, then made orthogonal to the normal. The sign of w
+// records mirrored UVs.
+void ObjMesh::generateTangents()
+{
+    std::vector<float> tangents(vertices.size() * 3, 0.0f), bitangents(vertices.size() * 3, 0.0f);
+    for (size_t t = 0; t < indices.size(); t += 3)
+    {
+        const MeshVertex &a = vertices[indices[t]], &b = vertices[indices[t + 1]], &c = vertices[indices[t + 2]];
+        float e1[3], e2[3];
+        for (int k = 0; k < 3; k++)
+        {
+            e1[k] = b.position[k] - a.position[k];
+            e2[k] = c.position[k] - a.position[k];
+        }
+        float du1 = b.texCoord[0] - a.texCoord[0], dv1 = b.texCoord[1] - a.texCoord[1];
+        float du2 = c.texCoord[0] - a.texCoord[0], dv2 = c.texCoord[1] - a.texCoord[1];
+        float det = du1 * dv2 - du2 * dv1;
+        if (fabsf(det) < 1e-12f)
+            continue;
+        float r = 1.0f / det;
+
+        for (int k = 0; k < 3; k++)
+        {
+            float tk = (e1[k] * dv2 - e2[k] * dv1) * r;
+            float bk = (e2[k] * du1 - e1[k] * du2) * r;
+            for (int corner = 0; corner < 3; corner++)
+            {
+                tangents[indices[t + corner] * 3 + k] += tk;
+                bitangents[indices[t + corner] * 3 + k] += bk;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        const float *n = vertices[i].normal;
+        float *t = &tangents[i * 3], *b = &bitangents[i * 3];
+        float along = n[0] * t[0] + n[1] * t[1] + n[2] * t[2];
+        for (int k = 0; k < 3; k++)
+            t[k] -= n[k] * along;
+
+        // No usable UVs: any direction across the normal will do
+        float length = sqrtf(t[0] * t[0] + t[1] * t[1] + t[2] * t[2]);
+        if (length < 1e-8f)
+        {
+            float axis[3] = {0.0f, 0.0f, 0.0f};
+            axis[fabsf(n[0]) < 0.9f ? 0 : 1] = 1.0f;
+            t[0] = axis[1] * n[2] - axis[2] * n[1];
+            t[1] = axis[2] * n[0] - axis[0] * n[2];
+            t[2] = axis[0] * n[1] - axis[1] * n[0];
+            length = sqrtf(t[0] * t[0] + t[1] * t[1] + t[2] * t[2]);
+        }
+
+        float *out = vertices[i].tangent;
+        for (int k = 0; k < 3; k++)
+            out[k] = t[k] / length;
+        float cross[3] = {n[1] * out[2] - n[2] * out[1], n[2] * out[0] - n[0] * out[2], n[0] * out[1] - n[1] * out[0]};
+        out[3] = cross[0] * b[0] + cross[1] * b[1] + cross[2] * b[2] < 0.0f ? -1.0f : 1.0f;
+    }
+}
+
+void ObjMesh::upload()
+{
+    GLExtensions::load();
+    if (!GLExtensions::hasBufferObjects || vertices.empty() || vertexBuffer)
+        return;
+
+    GLuint buffers[2];
+    GLExtensions::genBuffers(2, buffers);
+    vertexBuffer = buffers[0];
+    indexBuffer = buffers[1];
+    GLExtensions::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    GLExtensions::bufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(MeshVertex), &vertices[0], GL_STATIC_DRAW);
+    GLExtensions::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    GLExtensions::bufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), &indices[0], GL_STATIC_DRAW);
+    GLExtensions::bindBuffer(GL_ARRAY_BUFFER, 0);
+    GLExtensions::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void ObjMesh::bind(int tangentLocation) const
+{
+    // With buffers bound the pointers are offsets into them
+    const char *base = (const char *)&vertices[0];
+    if (vertexBuffer)
+    {
+        base = NULL;
+        GLExtensions::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        GLExtensions::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    }
+
+    GLsizei stride = sizeof(MeshVertex);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride, base + offsetof(MeshVertex, position));
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glNormalPointer(GL_FLOAT, stride, base + offsetof(MeshVertex, normal));
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glTexCoordPointer(2, GL_FLOAT, stride, base + offsetof(MeshVertex, texCoord));
+    if (tangentLocation >= 0)
+    {
+        GLExtensions::enableVertexAttribArray(tangentLocation);
+        GLExtensions::vertexAttribPointer(tangentLocation, 4, GL_FLOAT, GL_FALSE, stride,
+                                          base + offsetof(MeshVertex, tangent));
+    }
+}
+
+void ObjMesh::draw(size_t group) const
+{
+    const MeshGroup &g = groups[group];
+    const void *first = vertexBuffer ? (const void *)((size_t)g.firstIndex * sizeof(uint32_t)) : &indices[g.firstIndex];
+    glDrawElements(GL_TRIANGLES, g.indexCount, GL_UNSIGNED_INT, first);
+}
+
+void ObjMesh::unbind(int tangentLocation) const
+{
+    if (tangentLocation >= 0)
+        GLExtensions::disableVertexAttribArray(tangentLocation);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    // Other models draw from client memory
+    if (vertexBuffer)
+    {
+        GLExtensions::bindBuffer(GL_ARRAY_BUFFER, 0);
+        GLExtensions::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
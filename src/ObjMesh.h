@@ -0,0 +1,62 @@
+#ifndef OBJ_MESH_H
+#define OBJ_MESH_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Interleaved, one per distinct position/texcoord/normal triple of the file
+struct MeshVertex
+{
+    float position[3];
+    float normal[3];
+    float texCoord[2];
+    float tangent[4]; // w = 1 or -1, bitangent = cross(normal, tangent) * w
+};
+
+// The triangles of one material, a run of the index list
+struct MeshGroup
+{
+    std::string material;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+};
+
+// Wavefront .obj mesh for normal mapped materials. Polygons are split into
+// triangles and sorted by material at load, so each material is one draw;
+// tangents come from the texture coordinates, normals from the file (or the
+// faces when it has none). upload() moves everything into vertex buffers.
+class ObjMesh
+{
+public:
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<MeshGroup> groups;
+    float boundsMin[3], boundsMax[3];
+    float radius; // Farthest vertex from the origin
+
+    ObjMesh();
+
+    bool load(const char *path);
+
+    // Static vertex and index buffers when the driver has them, the arrays
+    // above are used in place otherwise. Like textures, they live as long as
+    // the context.
+    void upload();
+
+    // Vertex, normal and texcoord arrays, plus tangents for a shader
+    // attribute (-1 for none). draw() takes a group between the two.
+    void bind(int tangentLocation) const;
+    void draw(size_t group) const;
+    void unbind(int tangentLocation) const;
+
+private:
+    unsigned int vertexBuffer, indexBuffer;
+
+    ObjMesh(const ObjMesh &);
+    ObjMesh &operator=(const ObjMesh &);
+
+    void generateTangents();
+};
+
+#endif
@@ -0,0 +1,281 @@
+#include "OcclusionBuffer.h"
+#include <GL/glut.h>
+#include <algorithm>
+#include <cmath>
+
+// Corners are numbered x | y << 1 | z << 2, a set bit meaning the max side.
+// Each face is counter-clockwise seen from outside, like a GL front face.
+static const int BOX_FACES[6][4] = {
+    {0, 4, 6, 2}, // -x
+    {1, 3, 7, 5}, // +x
+    {0, 1, 5, 4}, // -y
+    {2, 6, 7, 3}, // +y
+    {0, 2, 3, 1}, // -z
+    {4, 5, 7, 6}, // +z
+};
+
+static const float MIN_AREA = 1e-3f; // Twice the area in pixels; thinner faces hide nothing
+static const int TEST_SPAN = 8;      // Texels per side isHidden() reads at most
+
+OcclusionBuffer::OcclusionBuffer()
+{
+    for (int i = 0; i < 16; i++)
+        worldToClip[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+    for (int l = 0; l < LEVELS; l++)
+        levels[l].assign((WIDTH >> l) * (HEIGHT >> l), 1.0f);
+    inside.resize((WIDTH + 1) * (HEIGHT + 1));
+    stats.tested = 0;
+    stats.culled = 0;
+}
+
+void OcclusionBuffer::begin()
+{
+    float projection[16];
+    float modelview[16];
+    glGetFloatv(GL_PROJECTION_MATRIX, projection);
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+    for (int col = 0; col < 4; col++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++)
+                sum += projection[k * 4 + row] * modelview[col * 4 + k];
+            worldToClip[col * 4 + row] = sum;
+        }
+    }
+
+    std::fill(levels[0].begin(), levels[0].end(), 1.0f); // The far plane
+    stats.tested = 0;
+    stats.culled = 0;
+}
+
+static void boxToClip(const float m[16], const float boxMin[3], const float boxMax[3], float clip[8][4])
+{
+    for (int c = 0; c < 8; c++)
+    {
+        float x = (c & 1) ? boxMax[0] : boxMin[0];
+        float y = (c & 2) ? boxMax[1] : boxMin[1];
+        float z = (c & 4) ? boxMax[2] : boxMin[2];
+        for (int row = 0; row < 4; row++)
+            clip[c][row] = m[row] * x + m[4 + row] * y + m[8 + row] * z + m[12 + row];
+    }
+}
+
+void OcclusionBuffer::addOccluder(const float boxMin[3], const float boxMax[3])
+{
+    float corners[8][4];
+    boxToClip(worldToClip, boxMin, boxMax, corners);
+
+    for (int f = 0; f < 6; f++)
+    {
+        // Cut away what is in front of the near plane (z < -w); a quad
+        // becomes at most a pentagon
+        float face[5][4];
+        int count = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            const float *a = corners[BOX_FACES[f][i]];
+            const float *b = corners[BOX_FACES[f][(i + 1) % 4]];
+            float da = a[2] + a[3];
+            float db = b[2] + b[3];
+            if (da >= 0.0f)
+            {
+                for (int k = 0; k < 4; k++)
+                    face[count][k] = a[k];
+                count++;
+            }
+            if ((da >= 0.0f) != (db >= 0.0f))
+            {
+                float t = da / (da - db);
+                for (int k = 0; k < 4; k++)
+                    face[count][k] = a[k] + (b[k] - a[k]) * t;
+                count++;
+            }
+        }
+        if (count >= 3)
+            rasterize(face, count);
+    }
+}
+
+void OcclusionBuffer::rasterize(const float (*clip)[4], int count)
+{
+    float x[5], y[5], z[5];
+    for (int i = 0; i < count; i++)
+    {
+        if (clip[i][3] <= 0.0f)
+            return;
+        float invW = 1.0f / clip[i][3];
+        x[i] = (clip[i][0] * invW * 0.5f + 0.5f) * WIDTH;
+        y[i] = (clip[i][1] * invW * 0.5f + 0.5f) * HEIGHT;
+        z[i] = clip[i][2] * invW;
+    }
+
+    // Back faces wind clockwise on screen, they are behind the front ones
+    float area = 0.0f;
+    for (int i = 0; i < count; i++)
+    {
+        int j = (i + 1) % count;
+        area += x[i] * y[j] - x[j] * y[i];
+    }
+    if (area < MIN_AREA)
+        return;
+
+    // Depth is linear across the face on screen: z = z[0] + dzdx (x - x[0]) +
+    // dzdy (y - y[0]), solved on the fan triangle with the largest area
+    int best = 1;
+    float bestArea = 0.0f;
+    for (int i = 1; i + 1 < count; i++)
+    {
+        float a = (x[i] - x[0]) * (y[i + 1] - y[0]) - (x[i + 1] - x[0]) * (y[i] - y[0]);
+        if (a > bestArea)
+        {
+            bestArea = a;
+            best = i;
+        }
+    }
+    if (bestArea < MIN_AREA)
+        return;
+    float ex1 = x[best] - x[0], ey1 = y[best] - y[0], ez1 = z[best] - z[0];
+    float ex2 = x[best + 1] - x[0], ey2 = y[best + 1] - y[0], ez2 = z[best + 1] - z[0];
+    float dzdx = (ez1 * ey2 - ez2 * ey1) / bestArea;
+    float dzdy = (ex1 * ez2 - ex2 * ez1) / bestArea;
+    float slack = 0.5f * (fabsf(dzdx) + fabsf(dzdy)); // Pixel centre to its farthest corner
+
+    float minX = x[0], maxX = x[0], minY = y[0], maxY = y[0];
+    for (int i = 1; i < count; i++)
+    {
+        minX = std::min(minX, x[i]);
+        maxX = std::max(maxX, x[i]);
+        minY = std::min(minY, y[i]);
+        maxY = std::max(maxY, y[i]);
+    }
+    int x0 = std::max(0, (int)floorf(minX));
+    int x1 = std::min(WIDTH - 1, (int)ceilf(maxX) - 1);
+    int y0 = std::max(0, (int)floorf(minY));
+    int y1 = std::min(HEIGHT - 1, (int)ceilf(maxY) - 1);
+    if (x0 > x1 || y0 > y1)
+        return;
+
+    // Pixel corners inside every edge; a pixel is covered when all four are
+    int stride = x1 - x0 + 2;
+    for (int j = y0; j <= y1 + 1; j++)
+    {
+        for (int i = x0; i <= x1 + 1; i++)
+        {
+            bool in = true;
+            for (int e = 0; e < count && in; e++)
+            {
+                int n = (e + 1) % count;
+                in = (x[n] - x[e]) * (j - y[e]) - (y[n] - y[e]) * (i - x[e]) >= 0.0f;
+            }
+            inside[(j - y0) * stride + (i - x0)] = in;
+        }
+    }
+
+    float *depth = &levels[0][0];
+    for (int j = y0; j <= y1; j++)
+    {
+        const unsigned char *row = &inside[(j - y0) * stride];
+        const unsigned char *next = row + stride;
+        for (int i = x0; i <= x1; i++)
+        {
+            int c = i - x0;
+            if (!(row[c] && row[c + 1] && next[c] && next[c + 1]))
+                continue;
+            float d = z[0] + dzdx * (i + 0.5f - x[0]) + dzdy * (j + 0.5f - y[0]) + slack;
+            float &pixel = depth[j * WIDTH + i];
+            if (d < pixel)
+                pixel = d;
+        }
+    }
+}
+
+void OcclusionBuffer::finish()
+{
+    for (int l = 1; l < LEVELS; l++)
+    {
+        int w = WIDTH >> l;
+        int h = HEIGHT >> l;
+        int below = WIDTH >> (l - 1);
+        const float *src = &levels[l - 1][0];
+        float *dst = &levels[l][0];
+        for (int j = 0; j < h; j++)
+        {
+            for (int i = 0; i < w; i++)
+            {
+                const float *s = src + 2 * j * below + 2 * i;
+                dst[j * w + i] = std::max(std::max(s[0], s[1]), std::max(s[below], s[below + 1]));
+            }
+        }
+    }
+}
+
+bool OcclusionBuffer::isHidden(const float boxMin[3], const float boxMax[3])
+{
+    stats.tested++;
+
+    float corners[8][4];
+    boxToClip(worldToClip, boxMin, boxMax, corners);
+
+    // Outside one side of the view frustum, e.g. behind the camera
+    for (int plane = 0; plane < 6; plane++)
+    {
+        int axis = plane / 2;
+        float sign = (plane & 1) ? -1.0f : 1.0f;
+        int outside = 0;
+        while (outside < 8 && sign * corners[outside][axis] < -corners[outside][3])
+            outside++;
+        if (outside == 8)
+        {
+            stats.culled++;
+            return true;
+        }
+    }
+
+    float minX = 1e30f, maxX = -1e30f, minY = 1e30f, maxY = -1e30f;
+    float nearest = 1e30f;
+    for (int c = 0; c < 8; c++)
+    {
+        const float *p = corners[c];
+        if (p[3] <= 0.0f || p[2] < -p[3])
+            return false; // Crosses the near plane
+        float invW = 1.0f / p[3];
+        float sx = (p[0] * invW * 0.5f + 0.5f) * WIDTH;
+        float sy = (p[1] * invW * 0.5f + 0.5f) * HEIGHT;
+        minX = std::min(minX, sx);
+        maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy);
+        maxY = std::max(maxY, sy);
+        nearest = std::min(nearest, p[2] * invW);
+    }
+
+    int x0 = (int)floorf(minX);
+    int x1 = (int)floorf(maxX);
+    int y0 = (int)floorf(minY);
+    int y1 = (int)floorf(maxY);
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, WIDTH - 1);
+    y1 = std::min(y1, HEIGHT - 1);
+
+    // The finest level where the rectangle spans at most TEST_SPAN texels a
+    // side; coarser texels reach further past the box and hide less
+    int l = 0;
+    while (l < LEVELS - 1 && ((x1 >> l) - (x0 >> l) >= TEST_SPAN || (y1 >> l) - (y0 >> l) >= TEST_SPAN))
+        l++;
+
+    int w = WIDTH >> l;
+    const float *depth = &levels[l][0];
+    for (int j = y0 >> l; j <= y1 >> l; j++)
+    {
+        for (int i = x0 >> l; i <= x1 >> l; i++)
+        {
+            if (depth[j * w + i] >= nearest)
+                return false;
+        }
+    }
+
+    stats.culled++;
+    return true;
+}
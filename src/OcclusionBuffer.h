@@ -0,0 +1,56 @@
+#ifndef OCCLUSION_BUFFER_H
+#define OCCLUSION_BUFFER_H
+
+#include <vector>
+
+// A small software depth buffer for skipping draws hidden behind big boxes
+// (Level1's buildings). Occluders are rasterized on the CPU at a fixed low
+// resolution, conservatively: a pixel is only written when a face covers it
+// completely, with the face's farthest depth inside it. finish() then builds
+// a pyramid where every texel holds the farthest depth of the four below it,
+// so isHidden() tests a box's screen rectangle against at most 8 x 8 texels.
+//
+// Per frame, in world space:
+//   begin(); addOccluder(...) for each occluder; finish();
+//   then isHidden(...) before each draw that can be skipped
+class OcclusionBuffer
+{
+public:
+    static const int WIDTH = 128;
+    static const int HEIGHT = 64;
+    static const int LEVELS = 6; // Down to 4 x 2
+
+    // Boxes tested since begin() and how many of them were hidden
+    struct Stats
+    {
+        int tested;
+        int culled;
+    };
+
+    OcclusionBuffer();
+
+    // Starts an empty frame seen through the current GL projection and modelview
+    void begin();
+
+    // Rasterizes the faces of an axis-aligned box that face the camera
+    void addOccluder(const float boxMin[3], const float boxMax[3]);
+
+    // Builds the pyramid; after the last occluder, before isHidden()
+    void finish();
+
+    // True if the box is off screen or entirely behind the occluders. A box
+    // crossing the near plane is always visible.
+    bool isHidden(const float boxMin[3], const float boxMax[3]);
+
+    const Stats &getStats() const { return stats; }
+
+private:
+    float worldToClip[16];
+    std::vector<float> levels[LEVELS]; // Normalized device z, level 0 is WIDTH x HEIGHT
+    std::vector<unsigned char> inside;  // Per pixel corner of the face being drawn
+    Stats stats;
+
+    void rasterize(const float (*clip)[4], int count);
+};
+
+#endif
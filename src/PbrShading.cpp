@@ -0,0 +1,352 @@
+#include "PbrShading.h"
+#include "GLExtensions.h"
+#include "Lighting.h"
+#include "Profiler.h"
+#include "TextureStreamer.h"
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Environment atlas: equirectangular bands stacked vertically, band 0 the
+// cosine irradiance, bands 1..ROUGHNESS_BANDS GGX at roughness 0, 0.25 .. 1
+static const int ENV_WIDTH = 32;
+static const int ENV_HEIGHT = 16;
+static const int ROUGHNESS_BANDS = 5;
+static const int ENV_BANDS = 1 + ROUGHNESS_BANDS;
+static const int SKY_WIDTH = 96; // Directions the prefilter integrates over
+static const int SKY_HEIGHT = 48;
+static const int ENVIRONMENT_UNIT = 4; // Units 0-3 are the material maps
+
+static const char *VERTEX_SHADER =
+    "#version 120\n"
+    "attribute vec4 tangent;\n"
+    "varying vec3 eyePosition;\n"
+    "varying vec3 eyeNormal;\n"
+    "varying vec4 eyeTangent;\n"
+    "void main()\n"
+    "{\n"
+    "    eyePosition = (gl_ModelViewMatrix * gl_Vertex).xyz;\n"
+    "    eyeNormal = gl_NormalMatrix * gl_Normal;\n"
+    "    eyeTangent = vec4(gl_NormalMatrix * tangent.xyz, tangent.w);\n"
+    "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+    "    gl_Position = ftransform();\n"
+    "}\n";
+
+// Lighting::buildProgram() puts the light block in front of this
+static const char *FRAGMENT_SHADER =
+    "#define PI 3.14159265\n"
+    "#define ENV_BANDS 6.0\n"
+    "#define ROUGHNESS_BANDS 5.0\n"
+    "#define ENV_HALF_TEXEL (0.5 / 16.0)\n"
+    "uniform sampler2D baseColorMap;\n"
+    "uniform sampler2D normalMap;\n"
+    "uniform sampler2D metallicMap;\n"
+    "uniform sampler2D roughnessMap;\n"
+    "uniform sampler2D environmentMap;\n"
+    "uniform mat3 eyeToWorld;\n"
+    "varying vec3 eyePosition;\n"
+    "varying vec3 eyeNormal;\n"
+    "varying vec4 eyeTangent;\n"
+    "\n"
+    "// Band b of the atlas in world direction d, kept off the neighbouring bands\n"
+    "vec3 environment(vec3 d, float b)\n"
+    "{\n"
+    "    float u = atan(d.z, d.x) / (2.0 * PI) + 0.5;\n"
+    "    float v = clamp(acos(clamp(d.y, -1.0, 1.0)) / PI, ENV_HALF_TEXEL, 1.0 - ENV_HALF_TEXEL);\n"
+    "    return texture2D(environmentMap, vec2(u, (b + v) / ENV_BANDS)).rgb;\n"
+    "}\n"
+    "\n"
+    "// Karis' fit of the split sum BRDF integral, scale and bias for F0\n"
+    "vec2 environmentBRDF(float roughness, float NdotV)\n"
+    "{\n"
+    "    vec4 r = roughness * vec4(-1.0, -0.0275, -0.572, 0.022) + vec4(1.0, 0.0425, 1.04, -0.04);\n"
+    "    float a004 = min(r.x * r.x, exp2(-9.28 * NdotV)) * r.x + r.y;\n"
+    "    return vec2(-1.04, 1.04) * a004 + r.zw;\n"
+    "}\n"
+    "\n"
+    "// GGX distribution, Smith-Schlick visibility, Schlick Fresnel, Lambert\n"
+    "// diffuse. Times PI so a light of color c on white matte gives c * N.L,\n"
+    "// as the fixed-function lights do.\n"
+    "vec3 brdf(vec3 n, vec3 v, vec3 l, vec3 diffuseColor, vec3 f0, float roughness)\n"
+    "{\n"
+    "    float NdotL = dot(n, l);\n"
+    "    if (NdotL <= 0.0)\n"
+    "        return vec3(0.0);\n"
+    "    vec3 h = normalize(l + v);\n"
+    "    float NdotV = max(dot(n, v), 1e-4);\n"
+    "    float NdotH = max(dot(n, h), 0.0);\n"
+    "    float alpha = roughness * roughness;\n"
+    "    float a2 = alpha * alpha;\n"
+    "    float d = NdotH * NdotH * (a2 - 1.0) + 1.0;\n"
+    "    float D = a2 / (PI * d * d);\n"
+    "    float k = (roughness + 1.0) * (roughness + 1.0) / 8.0;\n"
+    "    float G = NdotL / (NdotL * (1.0 - k) + k) * NdotV / (NdotV * (1.0 - k) + k);\n"
+    "    vec3 F = f0 + (1.0 - f0) * pow(1.0 - max(dot(v, h), 0.0), 5.0);\n"
+    "    vec3 specular = D * G * F / (4.0 * NdotL * NdotV);\n"
+    "    return ((1.0 - F) * diffuseColor + PI * specular) * NdotL;\n"
+    "}\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    vec2 uv = gl_TexCoord[0].st;\n"
+    "    vec4 base = texture2D(baseColorMap, uv);\n"
+    "    vec3 albedo = pow(base.rgb, vec3(2.2));\n"
+    "    float metallic = texture2D(metallicMap, uv).r;\n"
+    "    float roughness = clamp(texture2D(roughnessMap, uv).r, 0.04, 1.0);\n"
+    "\n"
+    "    // Two channel normal maps (BC5) only store x and y\n"
+    "    vec2 xy = texture2D(normalMap, uv).rg * 2.0 - 1.0;\n"
+    "    vec3 tangentNormal = vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));\n"
+    "    vec3 vertexNormal = normalize(eyeNormal);\n"
+    "    vec3 t = normalize(eyeTangent.xyz - vertexNormal * dot(vertexNormal, eyeTangent.xyz));\n"
+    "    vec3 b = cross(vertexNormal, t) * eyeTangent.w;\n"
+    "    vec3 n = normalize(t * tangentNormal.x + b * tangentNormal.y + vertexNormal * tangentNormal.z);\n"
+    "    vec3 v = normalize(-eyePosition);\n"
+    "    float NdotV = max(dot(n, v), 1e-4);\n"
+    "\n"
+    "    vec3 diffuseColor = albedo * (1.0 - metallic);\n"
+    "    vec3 f0 = mix(vec3(0.04), albedo, metallic);\n"
+    "\n"
+    "    vec3 color = brdf(n, v, sunDirection.xyz, diffuseColor, f0, roughness) * sunDiffuse.rgb * sunShadow(eyePosition);\n"
+    "    ivec4 cluster = lightCluster(eyePosition);\n"
+    "    for (int k = cluster.x; k < cluster.x + cluster.y; k++)\n"
+    "    {\n"
+    "        int i = lightIndex(k);\n"
+    "        vec3 l;\n"
+    "        float amount = lightAmount(i, eyePosition, l);\n"
+    "        if (amount > 0.0)\n"
+    "            color += brdf(n, v, l, diffuseColor, f0, roughness) * lightColor[i].rgb * amount;\n"
+    "    }\n"
+    "\n"
+    "    // The sky is as bright as the sun is high, never darker than ambient\n"
+    "    vec3 worldNormal = eyeToWorld * n;\n"
+    "    vec3 worldReflection = eyeToWorld * reflect(-v, n);\n"
+    "    float sunHeight = clamp((eyeToWorld * sunDirection.xyz).y, 0.0, 1.0);\n"
+    "    vec3 sky = gl_LightModel.ambient.rgb + sunAmbient.rgb + sunDiffuse.rgb * sunHeight;\n"
+    "    float band = roughness * (ROUGHNESS_BANDS - 1.0);\n"
+    "    vec3 prefiltered = mix(environment(worldReflection, 1.0 + floor(band)),\n"
+    "                           environment(worldReflection, 1.0 + min(floor(band) + 1.0, ROUGHNESS_BANDS - 1.0)),\n"
+    "                           fract(band));\n"
+    "    vec2 scaleBias = environmentBRDF(roughness, NdotV);\n"
+    "    color += (diffuseColor * environment(worldNormal, 0.0) + prefiltered * (f0 * scaleBias.x + scaleBias.y)) * sky;\n"
+    "\n"
+    "    gl_FragColor = vec4(pow(color, vec3(1.0 / 2.2)), base.a);\n"
+    "}\n";
+
+unsigned int PbrShading::program = 0;
+
+static int tangentLocation = -1;
+static int eyeToWorldLocation = -1;
+static GLuint environmentTexture = 0;
+
+// Linear radiance of a clear sky: blue overhead, pale at the horizon, a
+// dull ground below
+static void sky(const float d[3], float out[3])
+{
+    static const float ZENITH[3] = {0.25f, 0.45f, 0.85f};
+    static const float HORIZON[3] = {0.75f, 0.82f, 0.9f};
+    static const float GROUND[3] = {0.18f, 0.16f, 0.13f};
+    if (d[1] >= 0.0f)
+    {
+        float t = powf(1.0f - d[1], 3.0f);
+        for (int c = 0; c < 3; c++)
+            out[c] = ZENITH[c] + (HORIZON[c] - ZENITH[c]) * t;
+    }
+    else
+    {
+        float t = fminf(-d[1] * 5.0f, 1.0f);
+        for (int c = 0; c < 3; c++)
+            out[c] = HORIZON[c] * 0.5f + (GROUND[c] - HORIZON[c] * 0.5f) * t;
+    }
+}
+
+// Same mapping as environment() in the shader, u and v in 0..1
+static void direction(float u, float v, float d[3])
+{
+    float phi = (u - 0.5f) * 2.0f * (float)M_PI, theta = v * (float)M_PI;
+    d[0] = sinf(theta) * cosf(phi);
+    d[1] = cosf(theta);
+    d[2] = sinf(theta) * sinf(phi);
+}
+
+// Integrates the sky over a grid of directions, weighted by solid angle,
+// for every texel of every band. Roughness 0 is the sky itself.
+static void buildEnvironment(std::vector<unsigned char> &pixels)
+{
+    PROFILE_ZONE("PbrShading::buildEnvironment");
+
+    std::vector<float> dirs(SKY_WIDTH * SKY_HEIGHT * 3), radiance(SKY_WIDTH * SKY_HEIGHT * 3),
+        solidAngle(SKY_WIDTH * SKY_HEIGHT);
+    for (int y = 0; y < SKY_HEIGHT; y++)
+    {
+        for (int x = 0; x < SKY_WIDTH; x++)
+        {
+            int i = y * SKY_WIDTH + x;
+            float v = (y + 0.5f) / SKY_HEIGHT;
+            direction((x + 0.5f) / SKY_WIDTH, v, &dirs[i * 3]);
+            sky(&dirs[i * 3], &radiance[i * 3]);
+            solidAngle[i] = sinf(v * (float)M_PI);
+        }
+    }
+
+    pixels.resize(ENV_WIDTH * ENV_HEIGHT * ENV_BANDS * 3);
+    for (int band = 0; band < ENV_BANDS; band++)
+    {
+        float roughness = band > 0 ? (float)(band - 1) / (ROUGHNESS_BANDS - 1) : 0.0f;
+        float a2 = roughness * roughness * roughness * roughness;
+        for (int y = 0; y < ENV_HEIGHT; y++)
+        {
+            for (int x = 0; x < ENV_WIDTH; x++)
+            {
+                float n[3], sum[3] = {0.0f, 0.0f, 0.0f}, total = 0.0f;
+                direction((x + 0.5f) / ENV_WIDTH, (y + 0.5f) / ENV_HEIGHT, n);
+                for (int i = 0; band != 1 && i < SKY_WIDTH * SKY_HEIGHT; i++)
+                {
+                    const float *l = &dirs[i * 3];
+                    float NdotL = n[0] * l[0] + n[1] * l[1] + n[2] * l[2];
+                    if (NdotL <= 0.0f)
+                        continue;
+
+                    // Irradiance is cosine weighted; the GGX bands weight by
+                    // D(N.H) N.L with the view along the normal
+                    float weight = NdotL * solidAngle[i];
+                    if (band > 0)
+                    {
+                        float NdotH2 = (1.0f + NdotL) * 0.5f;
+                        float d = NdotH2 * (a2 - 1.0f) + 1.0f;
+                        weight *= a2 / (d * d);
+                    }
+                    for (int c = 0; c < 3; c++)
+                        sum[c] += radiance[i * 3 + c] * weight;
+                    total += weight;
+                }
+                if (total <= 0.0f)
+                {
+                    sky(n, sum);
+                    total = 1.0f;
+                }
+
+                unsigned char *out = &pixels[((band * ENV_HEIGHT + y) * ENV_WIDTH + x) * 3];
+                for (int c = 0; c < 3; c++)
+                    out[c] = (unsigned char)(fminf(sum[c] / total, 1.0f) * 255.0f + 0.5f);
+            }
+        }
+    }
+}
+
+bool PbrShading::init()
+{
+    if (!Lighting::isActive())
+        return false;
+
+    program = Lighting::buildProgram(VERTEX_SHADER, FRAGMENT_SHADER);
+    if (!program)
+        return false;
+
+    static const char *SAMPLERS[5] = {"baseColorMap", "normalMap", "metallicMap", "roughnessMap", "environmentMap"};
+    GLExtensions::useProgram(program);
+    for (int unit = 0; unit < 5; unit++)
+        GLExtensions::uniform1i(GLExtensions::getUniformLocation(program, SAMPLERS[unit]), unit);
+    tangentLocation = GLExtensions::getAttribLocation(program, "tangent");
+    eyeToWorldLocation = GLExtensions::getUniformLocation(program, "eyeToWorld");
+    GLExtensions::useProgram(0);
+
+    std::vector<unsigned char> pixels;
+    buildEnvironment(pixels);
+    glGenTextures(1, &environmentTexture);
+    glBindTexture(GL_TEXTURE_2D, environmentTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, ENV_WIDTH, ENV_HEIGHT * ENV_BANDS, 0, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    printf("PBR shading: GGX metal/roughness, %d prefiltered environment bands\n", ENV_BANDS);
+    return true;
+}
+
+void PbrMaterial::load(const char *prefix)
+{
+    static const char *SUFFIXES[4] = {"_BaseColor", "_Normal", "_Metallic", "_Roughness"};
+    static const unsigned char DEFAULTS[4][3] = {{255, 255, 255}, {128, 128, 255}, {0, 0, 0}, {128, 128, 128}};
+    GLTexture *maps[4] = {&baseColor, &normal, &metallic, &roughness};
+
+    // Not through GLTexture::Load(), which lower cases the path
+    for (int m = 0; m < 4; m++)
+    {
+        std::string name = std::string(prefix) + SUFFIXES[m];
+        std::string dds = name + ".dds", png = name + ".png";
+        if (!maps[m]->LoadDDS(&dds[0]))
+            maps[m]->LoadImage(&png[0]);
+        if (maps[m]->texture[0] == 0)
+            maps[m]->BuildColorTexture(DEFAULTS[m][0], DEFAULTS[m][1], DEFAULTS[m][2]);
+    }
+}
+
+void PbrShading::draw(const ObjMesh &mesh, const PbrMaterial *materials)
+{
+    PROFILE_GPU_ZONE("PbrShading::draw");
+
+    // Every map is sampled at the same rate as the base color
+    float screenSize = TextureStreamer::projectedSize(mesh.radius);
+    for (size_t g = 0; g < mesh.groups.size(); g++)
+    {
+        const PbrMaterial &material = materials[g];
+        TextureStreamer::request(material.baseColor.texture[0], screenSize);
+        TextureStreamer::request(material.normal.texture[0], screenSize);
+        TextureStreamer::request(material.metallic.texture[0], screenSize);
+        TextureStreamer::request(material.roughness.texture[0], screenSize);
+    }
+
+    glColor3f(1.0f, 1.0f, 1.0f);
+    glEnable(GL_TEXTURE_2D);
+    if (!program)
+    {
+        mesh.bind(-1);
+        for (size_t g = 0; g < mesh.groups.size(); g++)
+        {
+            glBindTexture(GL_TEXTURE_2D, materials[g].baseColor.texture[0]);
+            mesh.draw(g);
+        }
+        mesh.unbind(-1);
+        return;
+    }
+
+    // Rows of the view rotation are the columns of its inverse
+    const float *view = Lighting::getViewMatrix();
+    float eyeToWorld[9];
+    for (int row = 0; row < 3; row++)
+        for (int column = 0; column < 3; column++)
+            eyeToWorld[column * 3 + row] = view[row * 4 + column];
+
+    Lighting::disable();
+    GLExtensions::useProgram(program);
+    GLExtensions::uniformMatrix3fv(eyeToWorldLocation, 1, GL_FALSE, eyeToWorld);
+    GLExtensions::activeTexture(GL_TEXTURE0 + ENVIRONMENT_UNIT);
+    glBindTexture(GL_TEXTURE_2D, environmentTexture);
+
+    mesh.bind(tangentLocation);
+    for (size_t g = 0; g < mesh.groups.size(); g++)
+    {
+        const GLTexture *maps[4] = {&materials[g].baseColor, &materials[g].normal, &materials[g].metallic,
+                                    &materials[g].roughness};
+        for (int unit = 0; unit < 4; unit++)
+        {
+            GLExtensions::activeTexture(GL_TEXTURE0 + unit);
+            glBindTexture(GL_TEXTURE_2D, maps[unit]->texture[0]);
+        }
+        mesh.draw(g);
+    }
+    mesh.unbind(tangentLocation);
+
+    GLExtensions::activeTexture(GL_TEXTURE0);
+    GLExtensions::useProgram(0);
+    Lighting::enable();
+}
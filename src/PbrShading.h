@@ -0,0 +1,42 @@
+#ifndef PBR_SHADING_H
+#define PBR_SHADING_H
+
+#include "GLTexture.h"
+#include "ObjMesh.h"
+
+// The four maps of a metal/roughness material. load() looks for
+// <prefix>_BaseColor, _Normal, _Metallic and _Roughness, cooked .dds first
+// then .png; a missing map becomes a flat default (white, straight up,
+// dielectric, half rough).
+struct PbrMaterial
+{
+    GLTexture baseColor;
+    GLTexture normal;
+    GLTexture metallic;
+    GLTexture roughness;
+
+    void load(const char *prefix);
+};
+
+// Physically based shading for ObjMesh models: a GGX metal/roughness BRDF
+// lit by the sun and the same clustered lights as Lighting, plus image
+// based light from a sky environment. The environment is prefiltered once
+// at init() into an irradiance band and five GGX roughness bands, so a
+// pixel's ambient light is two texture reads. Without the shader path the
+// base color is drawn with the fixed-function lights instead.
+class PbrShading
+{
+public:
+    // After Lighting::init(); returns false if the program can't be built
+    static bool init();
+    static bool isActive() { return program != 0; }
+
+    // One indexed draw per material group, materials[i] for mesh.groups[i].
+    // Call with lighting enabled, it is enabled again afterwards.
+    static void draw(const ObjMesh &mesh, const PbrMaterial *materials);
+
+private:
+    static unsigned int program;
+};
+
+#endif
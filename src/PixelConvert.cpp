@@ -0,0 +1,183 @@
+#include "PixelConvert.h"
+#include <string.h>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PIXEL_CONVERT_X86 1
+#include <immintrin.h>
+#else
+#define PIXEL_CONVERT_X86 0
+#endif
+
+typedef void (*SwapProc)(const uint8_t *src, uint8_t *dst, size_t count, int bytesPerPixel);
+
+// Reads a whole pixel before writing it, so dst may overlap src from below
+static void swapScalar(const uint8_t *src, uint8_t *dst, size_t count, int bytesPerPixel)
+{
+    if (bytesPerPixel == 4)
+    {
+        for (size_t i = 0; i < count; i++, src += 4, dst += 4)
+        {
+            uint8_t b = src[0], g = src[1], r = src[2], a = src[3];
+            dst[0] = r;
+            dst[1] = g;
+            dst[2] = b;
+            dst[3] = a;
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < count; i++, src += 3, dst += 3)
+        {
+            uint8_t b = src[0], g = src[1], r = src[2];
+            dst[0] = r;
+            dst[1] = g;
+            dst[2] = b;
+        }
+    }
+}
+
+#if PIXEL_CONVERT_X86
+// Three byte pixels run sixteen at a time, 48 bytes in three registers. A
+// pixel can straddle two registers, so each output register is the OR of
+// shuffles of its neighbours (-128 zeroes a byte). Loads and stores never
+// overlap, which would stall store forwarding when converting in place.
+__attribute__((target("ssse3"))) static void swapSSSE3(const uint8_t *src, uint8_t *dst, size_t count, int bytesPerPixel)
+{
+    size_t i = 0;
+    if (bytesPerPixel == 4)
+    {
+        const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 4));
+            _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_shuffle_epi8(v, mask));
+        }
+    }
+    else
+    {
+        const __m128i m0a = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, -128);
+        const __m128i m0b = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 1);
+        const __m128i m1a = _mm_setr_epi8(-128, 15, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128);
+        const __m128i m1b = _mm_setr_epi8(0, -128, 4, 3, 2, 7, 6, 5, 10, 9, 8, 13, 12, 11, -128, 15);
+        const __m128i m1c = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 0, -128);
+        const __m128i m2b = _mm_setr_epi8(14, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128);
+        const __m128i m2c = _mm_setr_epi8(-128, 3, 2, 1, 6, 5, 4, 9, 8, 7, 12, 11, 10, 15, 14, 13);
+        for (; i + 16 <= count; i += 16)
+        {
+            const __m128i *in = (const __m128i *)(src + i * 3);
+            __m128i a = _mm_loadu_si128(in), b = _mm_loadu_si128(in + 1), c = _mm_loadu_si128(in + 2);
+            __m128i *out = (__m128i *)(dst + i * 3);
+            _mm_storeu_si128(out, _mm_or_si128(_mm_shuffle_epi8(a, m0a), _mm_shuffle_epi8(b, m0b)));
+            _mm_storeu_si128(out + 1, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m1a), _mm_shuffle_epi8(b, m1b)),
+                                                   _mm_shuffle_epi8(c, m1c)));
+            _mm_storeu_si128(out + 2, _mm_or_si128(_mm_shuffle_epi8(b, m2b), _mm_shuffle_epi8(c, m2c)));
+        }
+    }
+    swapScalar(src + i * bytesPerPixel, dst + i * bytesPerPixel, count - i, bytesPerPixel);
+}
+
+// Four byte pixels with both 128-bit lanes. Three byte pixels would need
+// shuffles across lanes, so they keep the SSSE3 loop.
+__attribute__((target("avx2"))) static void swapAVX2(const uint8_t *src, uint8_t *dst, size_t count, int bytesPerPixel)
+{
+    if (bytesPerPixel != 4)
+    {
+        swapSSSE3(src, dst, count, bytesPerPixel);
+        return;
+    }
+
+    size_t i = 0;
+    const __m256i mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                          2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i * 4));
+        _mm256_storeu_si256((__m256i *)(dst + i * 4), _mm256_shuffle_epi8(v, mask));
+    }
+    swapScalar(src + i * 4, dst + i * 4, count - i, 4);
+}
+#endif
+
+static const char *pathName = "scalar";
+
+static SwapProc selectSwap()
+{
+#if PIXEL_CONVERT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        pathName = "avx2";
+        return swapAVX2;
+    }
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        pathName = "ssse3";
+        return swapSSSE3;
+    }
+#endif
+    return swapScalar;
+}
+
+static SwapProc swapProc()
+{
+    static const SwapProc proc = selectSwap();
+    return proc;
+}
+
+void PixelConvert::swapRedBlue(const uint8_t *src, uint8_t *dst, size_t count, int bytesPerPixel)
+{
+    swapProc()(src, dst, count, bytesPerPixel);
+}
+
+void PixelConvert::swapRedBlueRows(const uint8_t *src, size_t srcStride, uint8_t *dst, int width, int height,
+                                   int bytesPerPixel, bool flipRows)
+{
+    SwapProc swap = swapProc();
+    size_t rowBytes = (size_t)width * bytesPerPixel;
+
+    if (!flipRows || dst != src)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            int dstRow = flipRows ? height - 1 - y : y;
+            swap(src + y * srcStride, dst + dstRow * rowBytes, width, bytesPerPixel);
+        }
+        return;
+    }
+
+    // Flipping in place swaps rows from both ends through one spare row.
+    // Padded rows are packed first, the only case that takes two passes.
+    std::vector<uint8_t> spare(rowBytes);
+    if (srcStride != rowBytes)
+    {
+        swapRedBlueRows(src, srcStride, dst, width, height, bytesPerPixel, false);
+        for (int y = 0; y < height / 2; y++)
+        {
+            uint8_t *top = dst + y * rowBytes, *bottom = dst + (height - 1 - y) * rowBytes;
+            memcpy(&spare[0], top, rowBytes);
+            memcpy(top, bottom, rowBytes);
+            memcpy(bottom, &spare[0], rowBytes);
+        }
+        return;
+    }
+
+    for (int y = 0; y < height / 2; y++)
+    {
+        uint8_t *top = dst + y * rowBytes, *bottom = dst + (height - 1 - y) * rowBytes;
+        swap(top, &spare[0], width, bytesPerPixel);
+        swap(bottom, top, width, bytesPerPixel);
+        memcpy(bottom, &spare[0], rowBytes);
+    }
+    if (height & 1)
+    {
+        uint8_t *middle = dst + (height / 2) * rowBytes;
+        swap(middle, middle, width, bytesPerPixel);
+    }
+}
+
+const char *PixelConvert::path()
+{
+    swapProc();
+    return pathName;
+}
@@ -0,0 +1,27 @@
+#ifndef PIXEL_CONVERT_H
+#define PIXEL_CONVERT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// BGR(A) to RGB(A) for the BMP and TGA loaders, which are stored blue first.
+// Uses SSSE3 or AVX2 byte shuffles when the CPU has them (checked once at
+// run time, the build needs no -m flags) and a scalar loop otherwise.
+class PixelConvert
+{
+public:
+    // count pixels of 3 or 4 bytes; dst may be src or anywhere before it
+    static void swapRedBlue(const uint8_t *src, uint8_t *dst, size_t count, int bytesPerPixel);
+
+    // width x height pixels whose rows are srcStride bytes apart (BMP pads
+    // rows to 4 bytes) into tightly packed rows, in one pass. dst may be src:
+    // packed rows only ever move down in memory. flipRows reverses the row
+    // order, for images stored top row first.
+    static void swapRedBlueRows(const uint8_t *src, size_t srcStride, uint8_t *dst, int width, int height,
+                                int bytesPerPixel, bool flipRows);
+
+    // Name of the code path in use, for benchmarks
+    static const char *path();
+};
+
+#endif
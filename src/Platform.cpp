@@ -0,0 +1,15 @@
+#include "Platform.h"
+#include <GL/glut.h>
+#include <stdio.h>
+
+void Platform::createWindow(int *argc, char **argv, const char *title, int width, int height)
+{
+    glutInit(argc, argv);
+    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
+    glutInitWindowSize(width, height);
+    glutCreateWindow(title);
+
+    printf("Platform: %s, OpenGL %s (%s)\n", name(),
+           (const char *)glGetString(GL_VERSION), (const char *)glGetString(GL_RENDERER));
+    fflush(stdout);
+}
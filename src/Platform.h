@@ -0,0 +1,41 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class AudioOutput;
+
+// Thin layer over the OS specific parts of the game.
+// Platform.cpp holds the GLUT window code shared by every target, and
+// platform/PlatformWin32.cpp or platform/PlatformPosix.cpp provide the rest.
+// Only one backend is compiled, each file is guarded by its own #ifdef.
+class Platform
+{
+public:
+    // Window and OpenGL context (freeglut on every platform)
+    static void createWindow(int *argc, char **argv, const char *title, int width, int height);
+
+    // Default sound device for the mixer, owned by the caller.
+    // The POSIX backend has no device yet and returns a NullAudioOutput.
+    static AudioOutput *createAudioOutput();
+
+    // Monotonic high resolution clock
+    static uint64_t nowNs();
+    static double nowSeconds() { return nowNs() / 1.0e9; }
+
+    // Read-only memory mapped file
+    struct MappedFile
+    {
+        const unsigned char *data;
+        size_t size;
+        void *handle; // Backend specific
+    };
+    static bool mapFile(const char *path, MappedFile &file);
+    static void unmapFile(MappedFile &file);
+
+    // Name of the backend, for logs
+    static const char *name();
+};
+
+#endif
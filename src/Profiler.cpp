@@ -0,0 +1,260 @@
+#include "Profiler.h"
+
+#if EGYPT_PROFILE
+
+#include "GLExtensions.h"
+#include "Platform.h"
+#include "TraceWriter.h"
+#include <algorithm>
+#include <string.h>
+
+// Exponential smoothing for the per-zone numbers shown in the overlay
+static const float SMOOTHING = 0.1f;
+
+// Current nesting depth on this thread
+static thread_local int zoneDepth = 0;
+
+Profiler &Profiler::get()
+{
+    static Profiler instance;
+    return instance;
+}
+
+Profiler::Profiler()
+{
+    zoneCount = 0;
+    for (int i = 0; i < MAX_ZONES; i++)
+    {
+        zones[i].name = "";
+        zones[i].gpu = false;
+        zones[i].depth = 0;
+        zones[i].cpuMs = 0.0f;
+        zones[i].gpuMs = 0.0f;
+        zones[i].callsPerFrame = 0;
+        counters[i].cpuNs = 0;
+        counters[i].calls = 0;
+    }
+
+    statCount = 0;
+    for (int i = 0; i < MAX_STATS; i++)
+    {
+        stats[i].name = "";
+        stats[i].perFrame = 0;
+        statTotals[i] = 0;
+    }
+
+    memset(frameHistory, 0, sizeof(frameHistory));
+    historyCount = 0;
+    historyHead = 0;
+    lastFrameStart = 0;
+    lastFrameMs = 0.0f;
+
+    overlayVisible = false;
+
+    gpuEnabled = false;
+    for (int i = 0; i < GPU_LATENCY; i++)
+        gpuFrames[i].used = 0;
+    gpuFrameIndex = 0;
+    inFrame = false;
+}
+
+uint64_t Profiler::nowNs()
+{
+    return Platform::nowNs();
+}
+
+int Profiler::registerZone(const char *name, bool gpu)
+{
+    // Called from function-local statics, so C++11 already serializes
+    // per call site; the atomic covers different sites racing
+    int id = zoneCount.fetch_add(1);
+    if (id >= MAX_ZONES)
+    {
+        zoneCount = MAX_ZONES;
+        return MAX_ZONES - 1; // Out of slots, share the last one
+    }
+
+    zones[id].name = name;
+    zones[id].gpu = gpu;
+    zones[id].depth = zoneDepth; // The first call, registering just before its beginZone()
+    return id;
+}
+
+int Profiler::registerStat(const char *name)
+{
+    int id = statCount.fetch_add(1);
+    if (id >= MAX_STATS)
+    {
+        statCount = MAX_STATS;
+        return MAX_STATS - 1; // Out of slots, share the last one
+    }
+
+    stats[id].name = name;
+    return id;
+}
+
+void Profiler::beginFrame()
+{
+    uint64_t now = nowNs();
+    if (lastFrameStart != 0)
+    {
+        lastFrameMs = (now - lastFrameStart) / 1.0e6f;
+        frameHistory[historyHead] = lastFrameMs;
+        historyHead = (historyHead + 1) % HISTORY;
+        if (historyCount < HISTORY)
+            historyCount++;
+    }
+    lastFrameStart = now;
+
+    // First frame: see if the driver has timestamp queries
+    static bool checkedGpu = false;
+    if (!checkedGpu)
+    {
+        checkedGpu = true;
+        GLExtensions::load();
+        gpuEnabled = GLExtensions::hasTimerQuery;
+    }
+
+    if (gpuEnabled)
+    {
+        // This slot was filled GPU_LATENCY frames ago, its results are ready by now
+        gpuFrameIndex = (gpuFrameIndex + 1) % GPU_LATENCY;
+        collectGpuFrame(gpuFrames[gpuFrameIndex]);
+    }
+
+    gpuStack.clear();
+    inFrame = true;
+}
+
+void Profiler::endFrame()
+{
+    inFrame = false;
+
+    int count = zoneCount;
+    if (count > MAX_ZONES)
+        count = MAX_ZONES;
+
+    for (int i = 0; i < count; i++)
+    {
+        float ms = counters[i].cpuNs.exchange(0) / 1.0e6f;
+        zones[i].callsPerFrame = counters[i].calls.exchange(0);
+        zones[i].cpuMs += (ms - zones[i].cpuMs) * SMOOTHING;
+    }
+
+    count = statCount;
+    if (count > MAX_STATS)
+        count = MAX_STATS;
+    for (int i = 0; i < count; i++)
+        stats[i].perFrame = statTotals[i].exchange(0);
+}
+
+GLuint Profiler::allocQuery()
+{
+    GpuFrame &frame = gpuFrames[gpuFrameIndex];
+    if (frame.used == (int)frame.queries.size())
+    {
+        // Grow the pool in chunks, queries are reused every GPU_LATENCY frames
+        size_t oldSize = frame.queries.size();
+        frame.queries.resize(oldSize + 32);
+        GLExtensions::genQueries(32, &frame.queries[oldSize]);
+    }
+    return frame.queries[frame.used++];
+}
+
+void Profiler::collectGpuFrame(GpuFrame &frame)
+{
+    float gpuNs[MAX_ZONES];
+    memset(gpuNs, 0, sizeof(gpuNs));
+
+    bool available = true;
+    if (!frame.samples.empty())
+    {
+        GLint ready = 0;
+        GLExtensions::getQueryObjectiv(frame.samples.back().end, GL_QUERY_RESULT_AVAILABLE, &ready);
+        available = ready != 0;
+    }
+
+    if (available)
+    {
+        for (size_t i = 0; i < frame.samples.size(); i++)
+        {
+            const GpuSample &s = frame.samples[i];
+            if (s.end == 0)
+                continue;
+
+            uint64_t t0 = 0, t1 = 0;
+            GLExtensions::getQueryObjectui64v(s.begin, GL_QUERY_RESULT, &t0);
+            GLExtensions::getQueryObjectui64v(s.end, GL_QUERY_RESULT, &t1);
+            if (t1 > t0)
+                gpuNs[s.zone] += (float)(t1 - t0);
+        }
+
+        int count = zoneCount;
+        if (count > MAX_ZONES)
+            count = MAX_ZONES;
+        for (int i = 0; i < count; i++)
+        {
+            if (zones[i].gpu)
+                zones[i].gpuMs += (gpuNs[i] / 1.0e6f - zones[i].gpuMs) * SMOOTHING;
+        }
+    }
+
+    frame.samples.clear();
+    frame.used = 0;
+}
+
+void Profiler::beginZone(int zone, bool gpu)
+{
+    zoneDepth++;
+
+    if (gpu && gpuEnabled && inFrame)
+    {
+        GpuSample s;
+        s.zone = zone;
+        s.begin = allocQuery();
+        s.end = 0;
+        GLExtensions::queryCounter(s.begin, GL_TIMESTAMP);
+
+        GpuFrame &frame = gpuFrames[gpuFrameIndex];
+        gpuStack.push_back((int)frame.samples.size());
+        frame.samples.push_back(s);
+    }
+}
+
+void Profiler::endZone(int zone, bool gpu, uint64_t startNs)
+{
+    zoneDepth--;
+
+    uint64_t durNs = nowNs() - startNs;
+    counters[zone].cpuNs += durNs;
+    counters[zone].calls++;
+
+    TraceWriter &trace = TraceWriter::get();
+    if (trace.isActive())
+        trace.push(zone, startNs, durNs);
+
+    if (gpu && gpuEnabled && inFrame && !gpuStack.empty())
+    {
+        GLuint q = allocQuery();
+        GLExtensions::queryCounter(q, GL_TIMESTAMP);
+
+        GpuFrame &frame = gpuFrames[gpuFrameIndex];
+        frame.samples[gpuStack.back()].end = q;
+        gpuStack.pop_back();
+    }
+}
+
+float Profiler::getFramePercentile(float p) const
+{
+    if (historyCount == 0)
+        return 0.0f;
+
+    std::vector<float> sorted(frameHistory, frameHistory + historyCount);
+    size_t n = (size_t)(p / 100.0f * (historyCount - 1) + 0.5f);
+    if (n >= sorted.size())
+        n = sorted.size() - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+    return sorted[n];
+}
+
+#endif // EGYPT_PROFILE
@@ -0,0 +1,187 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Frame profiler with nestable CPU zones, GPU timestamp queries around the
+// same zones and a rolling frame-time histogram.
+//
+// Usage:
+// void Level1::drawRoad(float playerZ)
+// {
+//     PROFILE_GPU_ZONE("Level1::drawRoad"); // CPU + GPU time of this scope
+//     ...
+// }
+//
+// PROFILE_ZONE() times the CPU only and is safe to use off the GL thread.
+// PROFILE_STAT("Occlusion culled", n) adds n to a count the overlay shows
+// per frame.
+// Build with EGYPT_PROFILE=0 (make PROFILE=0) and every macro compiles to
+// nothing.
+
+#ifndef EGYPT_PROFILE
+#define EGYPT_PROFILE 1
+#endif
+
+#if EGYPT_PROFILE
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+#include <GL/glut.h>
+
+class Profiler
+{
+public:
+    static const int MAX_ZONES = 64;
+    static const int HISTORY = 512; // Frames kept for the histogram
+    static const int GPU_LATENCY = 4; // Frames before GPU results are read
+    static const int MAX_STATS = 16;
+
+    struct ZoneInfo
+    {
+        const char *name;
+        bool gpu;
+        int depth;      // Nesting depth the zone was first seen at, set once at registration
+        float cpuMs;    // Smoothed per-frame CPU time
+        float gpuMs;    // Smoothed per-frame GPU time
+        int callsPerFrame;
+    };
+
+    struct StatInfo
+    {
+        const char *name;
+        int perFrame; // Total of the last frame
+    };
+
+    static Profiler &get();
+
+    // Returns a stable id for a zone name; called once per call site
+    int registerZone(const char *name, bool gpu);
+
+    // Called once per rendered frame by Game::render
+    void beginFrame();
+    void endFrame();
+
+    void beginZone(int zone, bool gpu);
+    void endZone(int zone, bool gpu, uint64_t startNs);
+
+    // Returns a stable id for a count; called once per call site
+    int registerStat(const char *name);
+    void addStat(int stat, int amount) { statTotals[stat] += amount; }
+
+    // Frame time percentile over the last HISTORY frames, p in [0, 100]
+    float getFramePercentile(float p) const;
+    float getLastFrameMs() const { return lastFrameMs; }
+
+    int getZoneCount() const { return zoneCount; }
+    const ZoneInfo &getZone(int zone) const { return zones[zone]; }
+
+    int getStatCount() const { return statCount; }
+    const StatInfo &getStat(int stat) const { return stats[stat]; }
+
+    bool isOverlayVisible() const { return overlayVisible; }
+    void toggleOverlay() { overlayVisible = !overlayVisible; }
+
+    static uint64_t nowNs();
+
+private:
+    Profiler();
+
+    struct ZoneCounters
+    {
+        std::atomic<uint64_t> cpuNs;
+        std::atomic<int> calls;
+    };
+
+    struct GpuSample
+    {
+        int zone;
+        GLuint begin;
+        GLuint end;
+    };
+
+    struct GpuFrame
+    {
+        std::vector<GLuint> queries;
+        int used;
+        std::vector<GpuSample> samples;
+    };
+
+    ZoneInfo zones[MAX_ZONES];
+    ZoneCounters counters[MAX_ZONES];
+    std::atomic<int> zoneCount;
+
+    StatInfo stats[MAX_STATS];
+    std::atomic<int> statTotals[MAX_STATS];
+    std::atomic<int> statCount;
+
+    float frameHistory[HISTORY];
+    int historyCount;
+    int historyHead;
+    uint64_t lastFrameStart;
+    float lastFrameMs;
+
+    bool overlayVisible;
+
+    // GPU queries, ring of frames so results are read back without stalling
+    bool gpuEnabled;
+    GpuFrame gpuFrames[GPU_LATENCY];
+    int gpuFrameIndex;
+    bool inFrame;
+    std::vector<int> gpuStack; // Open sample indices, GL thread only
+
+    GLuint allocQuery();
+    void collectGpuFrame(GpuFrame &frame);
+};
+
+// RAII helper behind the PROFILE_* macros
+class ProfileScope
+{
+public:
+    ProfileScope(int zone, bool gpu) : zone(zone), gpu(gpu)
+    {
+        start = Profiler::nowNs();
+        Profiler::get().beginZone(zone, gpu);
+    }
+    ~ProfileScope()
+    {
+        Profiler::get().endZone(zone, gpu, start);
+    }
+
+private:
+    int zone;
+    bool gpu;
+    uint64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#define PROFILE_SCOPE_IMPL(name, gpu)                                                                  \
+    static const int PROFILE_CONCAT(profileZone_, __LINE__) = Profiler::get().registerZone(name, gpu); \
+    ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(PROFILE_CONCAT(profileZone_, __LINE__), gpu)
+
+#define PROFILE_ZONE(name) PROFILE_SCOPE_IMPL(name, false)
+#define PROFILE_GPU_ZONE(name) PROFILE_SCOPE_IMPL(name, true)
+#define PROFILE_STAT(name, amount)                                                                    \
+    do                                                                                                \
+    {                                                                                                 \
+        static const int PROFILE_CONCAT(profileStat_, __LINE__) = Profiler::get().registerStat(name); \
+        Profiler::get().addStat(PROFILE_CONCAT(profileStat_, __LINE__), amount);                      \
+    } while (0)
+#define PROFILE_FRAME_BEGIN() Profiler::get().beginFrame()
+#define PROFILE_FRAME_END() Profiler::get().endFrame()
+
+#else
+
+#define PROFILE_ZONE(name) \
+    do                     \
+    {                      \
+    } while (0)
+#define PROFILE_GPU_ZONE(name) PROFILE_ZONE(name)
+#define PROFILE_STAT(name, amount) PROFILE_ZONE(name)
+#define PROFILE_FRAME_BEGIN() PROFILE_ZONE(0)
+#define PROFILE_FRAME_END() PROFILE_ZONE(0)
+
+#endif // EGYPT_PROFILE
+
+#endif // PROFILER_H
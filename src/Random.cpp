@@ -0,0 +1,116 @@
+#include "Random.h"
+
+// SplitMix64, used to expand a 64-bit seed into the xoshiro state
+static uint64_t splitMix64(uint64_t &x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint32_t rotl(uint32_t x, int k)
+{
+    return (x << k) | (x >> (32 - k));
+}
+
+Random::Random()
+{
+    seed(0);
+}
+
+Random::Random(uint64_t seedValue)
+{
+    seed(seedValue);
+}
+
+void Random::seed(uint64_t seedValue)
+{
+    initialSeed = seedValue;
+
+    uint64_t x = seedValue;
+    uint64_t a = splitMix64(x);
+    uint64_t b = splitMix64(x);
+    s[0] = (uint32_t)a;
+    s[1] = (uint32_t)(a >> 32);
+    s[2] = (uint32_t)b;
+    s[3] = (uint32_t)(b >> 32);
+
+    // The all-zero state is the only invalid one
+    if ((s[0] | s[1] | s[2] | s[3]) == 0)
+        s[0] = 1;
+}
+
+// One xoshiro128** step on state held in locals, so the batch fills keep it
+// in registers instead of loading and storing the member every draw
+static inline uint32_t step(uint32_t &s0, uint32_t &s1, uint32_t &s2, uint32_t &s3)
+{
+    uint32_t result = rotl(s1 * 5, 7) * 9;
+    uint32_t t = s1 << 9;
+
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+    s2 ^= t;
+    s3 = rotl(s3, 11);
+
+    return result;
+}
+
+uint32_t Random::next()
+{
+    return step(s[0], s[1], s[2], s[3]);
+}
+
+int Random::nextInt(int bound)
+{
+    if (bound <= 0)
+        return 0;
+
+    // Multiply-shift range reduction (no modulo, bias is negligible for our bounds)
+    return (int)(((uint64_t)next() * (uint32_t)bound) >> 32);
+}
+
+float Random::nextFloat()
+{
+    // Top 24 bits map exactly onto the float mantissa
+    return (next() >> 8) * (1.0f / 16777216.0f);
+}
+
+// Same draws as nextInt()/nextFloat() in a loop, with the state written back once
+void Random::fillInts(int *out, int count, int bound)
+{
+    if (bound <= 0)
+    {
+        for (int i = 0; i < count; i++)
+            out[i] = 0;
+        return;
+    }
+
+    uint32_t s0 = s[0], s1 = s[1], s2 = s[2], s3 = s[3];
+    for (int i = 0; i < count; i++)
+        out[i] = (int)(((uint64_t)step(s0, s1, s2, s3) * (uint32_t)bound) >> 32);
+    s[0] = s0;
+    s[1] = s1;
+    s[2] = s2;
+    s[3] = s3;
+}
+
+void Random::fillFloats(float *out, int count)
+{
+    uint32_t s0 = s[0], s1 = s[1], s2 = s[2], s3 = s[3];
+    for (int i = 0; i < count; i++)
+        out[i] = (step(s0, s1, s2, s3) >> 8) * (1.0f / 16777216.0f);
+    s[0] = s0;
+    s[1] = s1;
+    s[2] = s2;
+    s[3] = s3;
+}
+
+uint64_t Random::split()
+{
+    uint64_t hi = next();
+    uint64_t lo = next();
+    return (hi << 32) | lo;
+}
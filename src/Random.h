@@ -0,0 +1,48 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+// Small, fast, seedable PRNG (xoshiro128**).
+// Every Level owns its own instance so traffic is reproducible from a seed
+// and independent levels can be simulated side by side without sharing
+// libc's hidden rand() state. The output sequence only depends on the seed,
+// so identical seeds give identical traffic on every platform.
+class Random
+{
+public:
+    Random();
+    explicit Random(uint64_t seed);
+
+    void seed(uint64_t seed);
+    uint64_t getSeed() const { return initialSeed; }
+
+    // Raw 32 bits
+    uint32_t next();
+
+    // Uniform integer in [0, bound)
+    int nextInt(int bound);
+
+    // Uniform float in [0, 1)
+    float nextFloat();
+
+    // Uniform float in [lo, hi)
+    float range(float lo, float hi) { return lo + (hi - lo) * nextFloat(); }
+
+    // Chance check, e.g. chance(2, 100) is true 2% of the time
+    bool chance(int numerator, int denominator) { return nextInt(denominator) < numerator; }
+
+    // Batch draws, the same values as nextInt()/nextFloat() in a loop but
+    // with the generator state kept in registers for the whole batch
+    void fillInts(int *out, int count, int bound);
+    void fillFloats(float *out, int count);
+
+    // Derive an independent 64-bit seed, e.g. for a child level
+    uint64_t split();
+
+private:
+    uint32_t s[4];
+    uint64_t initialSeed;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "Registry.h"
+#include <cmath>
+
+Entity Registry::create()
+{
+    Entity e;
+    if (!freeList.empty())
+    {
+        e = freeList.back();
+        freeList.pop_back();
+    }
+    else
+    {
+        e = (Entity)active.size();
+        active.push_back(0);
+    }
+    active[e] = 1;
+    return e;
+}
+
+void Registry::destroy(Entity e)
+{
+    transforms.remove(e);
+    velocities.remove(e);
+    colliders.remove(e);
+    renderables.remove(e);
+    pickups.remove(e);
+    drivers.remove(e);
+    active[e] = 0;
+    freeList.push_back(e);
+}
+
+void Registry::clear()
+{
+    transforms.clear();
+    velocities.clear();
+    colliders.clear();
+    renderables.clear();
+    pickups.clear();
+    drivers.clear();
+    active.clear();
+    freeList.clear();
+}
+
+Entity Registry::findOverlap(float x, float z, float halfWidth, float halfLength) const
+{
+    for (size_t i = 0; i < colliders.size(); i++)
+    {
+        Entity e = colliders.entity(i);
+        if (!isActive(e))
+            continue;
+
+        const Collider &c = colliders[i];
+        const Transform &t = transforms.get(e);
+        if (std::abs(x - t.x) < halfWidth + c.width / 2 && std::abs(z - t.z) < halfLength + c.length / 2)
+            return e;
+    }
+    return NULL_ENTITY;
+}
@@ -0,0 +1,102 @@
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include "Components.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+typedef uint32_t Entity;
+static const Entity NULL_ENTITY = 0xFFFFFFFFu;
+
+// Sparse set: components packed in a dense array with an entity -> slot
+// lookup. Systems walk the dense array front to back; removing swaps the
+// last element into the hole, so there are never gaps.
+template <typename T>
+class ComponentArray
+{
+public:
+    T &add(Entity e, const T &value)
+    {
+        if (e >= sparse.size())
+            sparse.resize(e + 1, (uint32_t)NO_SLOT);
+        if (sparse[e] != NO_SLOT)
+            return dense[sparse[e]] = value;
+
+        sparse[e] = (uint32_t)dense.size();
+        dense.push_back(value);
+        entities.push_back(e);
+        return dense.back();
+    }
+
+    void remove(Entity e)
+    {
+        if (!has(e))
+            return;
+        uint32_t slot = sparse[e];
+        Entity last = entities.back();
+        dense[slot] = dense.back();
+        entities[slot] = last;
+        sparse[last] = slot;
+        sparse[e] = NO_SLOT;
+        dense.pop_back();
+        entities.pop_back();
+    }
+
+    bool has(Entity e) const { return e < sparse.size() && sparse[e] != NO_SLOT; }
+    T &get(Entity e) { return dense[sparse[e]]; }
+    const T &get(Entity e) const { return dense[sparse[e]]; }
+    T *find(Entity e) { return has(e) ? &dense[sparse[e]] : nullptr; }
+    const T *find(Entity e) const { return has(e) ? &dense[sparse[e]] : nullptr; }
+
+    // Dense access, index order is insertion order until something is removed
+    size_t size() const { return dense.size(); }
+    T &operator[](size_t i) { return dense[i]; }
+    const T &operator[](size_t i) const { return dense[i]; }
+    Entity entity(size_t i) const { return entities[i]; }
+
+    void clear()
+    {
+        dense.clear();
+        entities.clear();
+        sparse.clear();
+    }
+
+private:
+    static const uint32_t NO_SLOT = 0xFFFFFFFFu;
+
+    std::vector<T> dense;
+    std::vector<Entity> entities;
+    std::vector<uint32_t> sparse; // Indexed by entity
+};
+
+// All objects of one level. Entities are indices, recycled after destroy().
+// An inactive entity keeps its components but systems skip it, which is how
+// pooled objects such as traffic slots wait to respawn.
+// Copyable, so a level's objects go into a GameSnapshot with one assignment.
+class Registry
+{
+public:
+    Entity create();
+    void destroy(Entity e);
+    void clear();
+
+    bool isActive(Entity e) const { return active[e] != 0; }
+    void setActive(Entity e, bool on) { active[e] = on ? 1 : 0; }
+
+    // First active entity with a Collider overlapping the box, or NULL_ENTITY
+    Entity findOverlap(float x, float z, float halfWidth, float halfLength) const;
+
+    ComponentArray<Transform> transforms;
+    ComponentArray<Velocity> velocities;
+    ComponentArray<Collider> colliders;
+    ComponentArray<Renderable> renderables;
+    ComponentArray<Pickup> pickups;
+    ComponentArray<AIDriver> drivers;
+
+private:
+    std::vector<unsigned char> active; // Indexed by entity, bytes so jobs can write neighbours
+    std::vector<Entity> freeList;
+};
+
+#endif
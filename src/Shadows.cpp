@@ -0,0 +1,343 @@
+#include "Shadows.h"
+#include "GLExtensions.h"
+#include "Profiler.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static const int CASCADES = Lighting::SUN_CASCADES;
+static const int SPOTS = Lighting::SPOT_SHADOWS;
+
+// Half the side of each cascade's box, centred on the player's chunk
+static const float CASCADE_RADIUS[CASCADES] = {20.0f, 60.0f, 160.0f};
+static const float CHUNK_SIZE = 10.0f;
+static const float CASTER_HEIGHT = 30.0f; // Boxes run from the ground to here
+static const float SUN_DISTANCE = 500.0f;
+
+// Game::update() turns the sun 0.18 degrees a tick, so the cache is redrawn
+// about every 8 ticks while the player stays in one chunk
+static const float SUN_REFRESH_COS = 0.9997f;
+static const float SUN_MIN_HEIGHT = 0.05f; // Lower suns cast no shadows, they would be streaks
+
+bool Shadows::active = false;
+
+static GLuint sunMap, staticMap, spotMap;
+static GLuint sunFramebuffer, staticFramebuffer, spotFramebuffer;
+
+static bool staticValid = false;
+static bool refreshing = false; // Static maps are being redrawn this frame
+static float cachedSun[3];
+static float cachedX, cachedZ; // Chunk centre
+static float sunView[CASCADES][16], sunProjection[CASCADES][16];
+
+static bool sunUsed = false;  // This frame
+static bool spotsUsed = false;
+static bool copied = false;   // Static maps blitted into this frame's
+static float spotView[SPOTS][16], spotProjection[SPOTS][16];
+static GLint savedViewport[4];
+
+// Column major, out = a * b
+static void multiply(const float a[16], const float b[16], float out[16])
+{
+    float result[16];
+    for (int column = 0; column < 4; column++)
+        for (int row = 0; row < 4; row++)
+            result[column * 4 + row] = a[row] * b[column * 4] + a[4 + row] * b[column * 4 + 1] +
+                                       a[8 + row] * b[column * 4 + 2] + a[12 + row] * b[column * 4 + 3];
+    memcpy(out, result, sizeof(result));
+}
+
+// Same matrix as gluLookAt(), looking along dir from eye
+static void lookAlong(const float eye[3], const float dir[3], float out[16])
+{
+    float up[3] = {0.0f, 1.0f, 0.0f};
+    if (fabsf(dir[1]) > 0.99f)
+    {
+        up[1] = 0.0f;
+        up[2] = 1.0f;
+    }
+
+    float f[3], s[3], u[3];
+    float length = sqrtf(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+    for (int c = 0; c < 3; c++)
+        f[c] = dir[c] / length;
+    s[0] = f[1] * up[2] - f[2] * up[1];
+    s[1] = f[2] * up[0] - f[0] * up[2];
+    s[2] = f[0] * up[1] - f[1] * up[0];
+    length = sqrtf(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+    for (int c = 0; c < 3; c++)
+        s[c] /= length;
+    u[0] = s[1] * f[2] - s[2] * f[1];
+    u[1] = s[2] * f[0] - s[0] * f[2];
+    u[2] = s[0] * f[1] - s[1] * f[0];
+
+    memset(out, 0, 16 * sizeof(float));
+    for (int c = 0; c < 3; c++)
+    {
+        out[c * 4] = s[c];
+        out[c * 4 + 1] = u[c];
+        out[c * 4 + 2] = -f[c];
+    }
+    out[12] = -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]);
+    out[13] = -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]);
+    out[14] = f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2];
+    out[15] = 1.0f;
+}
+
+// Same matrices as glOrtho() and gluPerspective()
+static void ortho(float left, float right, float bottom, float top, float zNear, float zFar, float out[16])
+{
+    memset(out, 0, 16 * sizeof(float));
+    out[0] = 2.0f / (right - left);
+    out[5] = 2.0f / (top - bottom);
+    out[10] = -2.0f / (zFar - zNear);
+    out[12] = -(right + left) / (right - left);
+    out[13] = -(top + bottom) / (top - bottom);
+    out[14] = -(zFar + zNear) / (zFar - zNear);
+    out[15] = 1.0f;
+}
+
+static void perspective(float fovY, float zNear, float zFar, float out[16])
+{
+    float f = 1.0f / tanf(fovY * 3.14159265f / 360.0f);
+    memset(out, 0, 16 * sizeof(float));
+    out[0] = f;
+    out[5] = f;
+    out[10] = (zFar + zNear) / (zNear - zFar);
+    out[11] = -1.0f;
+    out[14] = 2.0f * zFar * zNear / (zNear - zFar);
+}
+
+// Sun's view and a projection that just holds a cascade's box
+static void fitCascade(int cascade)
+{
+    float r = CASCADE_RADIUS[cascade];
+    float center[3] = {cachedX, CASTER_HEIGHT * 0.5f, cachedZ};
+    float eye[3], dir[3];
+    for (int c = 0; c < 3; c++)
+    {
+        eye[c] = center[c] + cachedSun[c] * SUN_DISTANCE;
+        dir[c] = -cachedSun[c];
+    }
+    float *view = sunView[cascade];
+    lookAlong(eye, dir, view);
+
+    float lo[3] = {1e30f, 1e30f, 1e30f}, hi[3] = {-1e30f, -1e30f, -1e30f};
+    for (int corner = 0; corner < 8; corner++)
+    {
+        float x = cachedX + (corner & 1 ? r : -r);
+        float y = corner & 2 ? CASTER_HEIGHT : 0.0f;
+        float z = cachedZ + (corner & 4 ? r : -r);
+        for (int c = 0; c < 3; c++)
+        {
+            float v = view[c] * x + view[4 + c] * y + view[8 + c] * z + view[12 + c];
+            lo[c] = fminf(lo[c], v);
+            hi[c] = fmaxf(hi[c], v);
+        }
+    }
+    ortho(lo[0], hi[0], lo[1], hi[1], -hi[2], -lo[2], sunProjection[cascade]);
+}
+
+static GLuint createDepthTexture(int width, int height, bool compare)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Compared maps filter the four nearest results, a 2x2 PCF for free
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, compare ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, compare ? GL_LINEAR : GL_NEAREST);
+    if (compare)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_R_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    }
+    return texture;
+}
+
+static GLuint createFramebuffer(GLuint depth)
+{
+    GLuint framebuffer;
+    GLExtensions::genFramebuffers(1, &framebuffer);
+    GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    GLExtensions::framebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    bool complete = GLExtensions::checkFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, 0);
+    return complete ? framebuffer : 0;
+}
+
+bool Shadows::init()
+{
+    GLExtensions::load();
+    if (!Lighting::isActive() || !GLExtensions::hasFramebuffers)
+    {
+        printf("Shadows: no framebuffer objects, lights cast no shadows\n");
+        return false;
+    }
+
+    sunMap = createDepthTexture(CASCADE_SIZE * CASCADES, CASCADE_SIZE, true);
+    staticMap = createDepthTexture(CASCADE_SIZE * CASCADES, CASCADE_SIZE, false);
+    spotMap = createDepthTexture(SPOT_SIZE * SPOTS, SPOT_SIZE, true);
+    sunFramebuffer = createFramebuffer(sunMap);
+    staticFramebuffer = createFramebuffer(staticMap);
+    spotFramebuffer = createFramebuffer(spotMap);
+    if (!sunFramebuffer || !staticFramebuffer || !spotFramebuffer)
+    {
+        printf("Shadows: depth framebuffers incomplete, lights cast no shadows\n");
+        return false;
+    }
+
+    active = true;
+    printf("Shadows: %d sun cascades of %dx%d, %d spot maps of %dx%d\n", CASCADES, CASCADE_SIZE, CASCADE_SIZE, SPOTS,
+           SPOT_SIZE, SPOT_SIZE);
+    return true;
+}
+
+void Shadows::invalidate()
+{
+    staticValid = false;
+}
+
+bool Shadows::beginSun(const float sunPosition[3], float x, float z)
+{
+    float length = sqrtf(sunPosition[0] * sunPosition[0] + sunPosition[1] * sunPosition[1] +
+                         sunPosition[2] * sunPosition[2]);
+    if (length <= 0.0f || sunPosition[1] / length < SUN_MIN_HEIGHT)
+        return false;
+
+    float sun[3] = {sunPosition[0] / length, sunPosition[1] / length, sunPosition[2] / length};
+    float chunkX = (floorf(x / CHUNK_SIZE) + 0.5f) * CHUNK_SIZE;
+    float chunkZ = (floorf(z / CHUNK_SIZE) + 0.5f) * CHUNK_SIZE;
+    refreshing = !staticValid || chunkX != cachedX || chunkZ != cachedZ ||
+                 sun[0] * cachedSun[0] + sun[1] * cachedSun[1] + sun[2] * cachedSun[2] < SUN_REFRESH_COS;
+
+    // Until the cache is redrawn, the cars use the sun it was drawn with
+    if (refreshing)
+    {
+        memcpy(cachedSun, sun, sizeof(sun));
+        cachedX = chunkX;
+        cachedZ = chunkZ;
+        for (int c = 0; c < CASCADES; c++)
+            fitCascade(c);
+    }
+
+    sunUsed = true;
+    copied = false;
+    return true;
+}
+
+bool Shadows::isStaticStale()
+{
+    return refreshing;
+}
+
+static void beginPass(GLuint framebuffer, int x, int size, const float projection[16], const float view[16], bool clear)
+{
+    glGetIntegerv(GL_VIEWPORT, savedViewport);
+    GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(x, 0, size, size);
+    glDepthMask(GL_TRUE);
+    if (clear)
+    {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(x, 0, size, size);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadMatrixf(projection);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadMatrixf(view);
+
+    // Slope scaled, so surfaces facing the light edge-on don't shadow themselves
+    Lighting::disable();
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+}
+
+void Shadows::beginCascade(int cascade, bool staticCasters)
+{
+    PROFILE_ZONE("Shadows::beginCascade");
+
+    // Every cascade's cars go on top of a copy of the cache
+    if (!staticCasters && !copied)
+    {
+        GLExtensions::bindFramebuffer(GL_READ_FRAMEBUFFER, staticFramebuffer);
+        GLExtensions::bindFramebuffer(GL_DRAW_FRAMEBUFFER, sunFramebuffer);
+        int width = CASCADE_SIZE * CASCADES;
+        GLExtensions::blitFramebuffer(0, 0, width, CASCADE_SIZE, 0, 0, width, CASCADE_SIZE, GL_DEPTH_BUFFER_BIT,
+                                      GL_NEAREST);
+        GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, 0);
+        copied = true;
+    }
+
+    beginPass(staticCasters ? staticFramebuffer : sunFramebuffer, cascade * CASCADE_SIZE, CASCADE_SIZE,
+              sunProjection[cascade], sunView[cascade], staticCasters);
+}
+
+void Shadows::beginSpot(int index, const Light &light)
+{
+    PROFILE_ZONE("Shadows::beginSpot");
+
+    float eye[3] = {light.x, light.y, light.z};
+    float dir[3] = {light.dirX, light.dirY, light.dirZ};
+    lookAlong(eye, dir, spotView[index]);
+    perspective(fminf(light.spotCutoff * 2.0f, 150.0f), 0.2f, light.range, spotProjection[index]);
+    spotsUsed = true;
+
+    beginPass(spotFramebuffer, index * SPOT_SIZE, SPOT_SIZE, spotProjection[index], spotView[index], true);
+}
+
+void Shadows::endPass()
+{
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    Lighting::enable();
+
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+
+    GLExtensions::bindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+}
+
+// Clip space to the texture coordinates of one map among count side by side
+static void toTile(int tile, int count, const float projection[16], const float view[16], float out[16])
+{
+    float bias[16] = {0.5f / count, 0.0f, 0.0f, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f,
+                      0.0f, 0.0f, 0.5f, 0.0f, (tile + 0.5f) / count, 0.5f, 0.5f, 1.0f};
+    multiply(bias, projection, out);
+    multiply(out, view, out);
+}
+
+void Shadows::finish()
+{
+    float sunMatrices[CASCADES][16], spotMatrices[SPOTS][16];
+    for (int c = 0; c < CASCADES; c++)
+        toTile(c, CASCADES, sunProjection[c], sunView[c], sunMatrices[c]);
+    for (int s = 0; s < SPOTS; s++)
+        toTile(s, SPOTS, spotProjection[s], spotView[s], spotMatrices[s]);
+    Lighting::setShadows(sunUsed ? sunMatrices : NULL, spotsUsed ? spotMatrices : NULL);
+
+    if (sunUsed && refreshing)
+        staticValid = true;
+    refreshing = false;
+    sunUsed = spotsUsed = false;
+
+    GLExtensions::activeTexture(GL_TEXTURE0 + Lighting::SUN_SHADOW_UNIT);
+    glBindTexture(GL_TEXTURE_2D, sunMap);
+    GLExtensions::activeTexture(GL_TEXTURE0 + Lighting::SPOT_SHADOW_UNIT);
+    glBindTexture(GL_TEXTURE_2D, spotMap);
+    GLExtensions::activeTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,56 @@
+#ifndef SHADOWS_H
+#define SHADOWS_H
+
+#include "Lighting.h"
+
+// Depth maps for the shader lighting path: three sun cascades around the
+// player and a small map per headlight. The cascades are square boxes fixed
+// to a chunk of the ground, so what doesn't move (buildings, lamp posts) is
+// drawn into a cached copy only when the player crosses into another chunk
+// or the sun has moved a few ticks' worth; each frame that copy is blitted
+// into the sampled maps and only the cars are drawn on top. Headlights move
+// with the car, their maps are redrawn every frame.
+//
+// Per frame, between Lighting::beginFrame() and Lighting::upload():
+//   if (beginSun(...)) { cascades, static ones first if isStaticStale() }
+//   beginSpot(...) for each headlight that is on
+//   finish();
+// with the casters drawn between each begin*() and endPass().
+class Shadows
+{
+public:
+    static const int CASCADE_SIZE = 1024; // Texels per side of one cascade
+    static const int SPOT_SIZE = 512;
+
+    // After Lighting::init(); needs framebuffer objects
+    static bool init();
+    static bool isActive() { return active; }
+
+    // Drops the cached static maps, e.g. when the level changes
+    static void invalidate();
+
+    // Fits the cascades around (x, z) for a sun towards sunPosition. False if
+    // the sun is below the horizon, then the sun casts no shadows this frame.
+    static bool beginSun(const float sunPosition[3], float x, float z);
+
+    // The cached static maps must be redrawn before this frame's cascades
+    static bool isStaticStale();
+
+    // Renders into one cascade, depth only: the static cache, or this
+    // frame's map (which starts as a copy of the cache)
+    static void beginCascade(int cascade, bool staticCasters);
+
+    // Renders into spot map index, seen from a spot light
+    static void beginSpot(int index, const Light &light);
+
+    // Back to the screen, with the matrices and viewport begin*() changed
+    static void endPass();
+
+    // Hands this frame's maps to Lighting and binds them for the shaders
+    static void finish();
+
+private:
+    static bool active;
+};
+
+#endif
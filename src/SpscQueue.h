@@ -0,0 +1,54 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stdint.h>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// push() fails instead of blocking when the queue is full.
+template <typename T, uint32_t SIZE>
+class SpscQueue
+{
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    // Producer thread only
+    bool push(const T &item)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= SIZE)
+            return false;
+
+        items[h & (SIZE - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool pop(T &item)
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return false;
+
+        item = items[t & (SIZE - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Only safe while neither side is running
+    void clear()
+    {
+        head.store(0);
+        tail.store(0);
+    }
+
+private:
+    static_assert((SIZE & (SIZE - 1)) == 0, "SpscQueue size must be a power of two");
+
+    T items[SIZE];
+    std::atomic<uint32_t> head; // Written by the producer
+    std::atomic<uint32_t> tail; // Written by the consumer
+};
+
+#endif
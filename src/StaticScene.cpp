@@ -0,0 +1,30 @@
+#include "StaticScene.h"
+#include <GL/glut.h>
+
+StaticScene::StaticScene()
+{
+    list = 0;
+    version = 0;
+    recorded = false;
+}
+
+void StaticScene::begin(uint32_t sceneVersion)
+{
+    if (!list)
+        list = glGenLists(1);
+    version = sceneVersion;
+    recorded = false;
+    glNewList(list, GL_COMPILE);
+}
+
+void StaticScene::end()
+{
+    glEndList();
+    recorded = list != 0;
+}
+
+void StaticScene::draw() const
+{
+    if (recorded)
+        glCallList(list);
+}
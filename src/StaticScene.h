@@ -0,0 +1,35 @@
+#ifndef STATIC_SCENE_H
+#define STATIC_SCENE_H
+
+#include <stdint.h>
+
+// Geometry that never moves, compiled once into a display list and replayed
+// with one call wherever it is seen (the main view, a mirror). The draw
+// calls between begin() and end() are recorded, not drawn; the recording is
+// kept until the scene's version changes or invalidate() is called.
+//
+//   if (!scene.isCurrent(version)) { scene.begin(version); draw...; scene.end(); }
+//   scene.draw();
+class StaticScene
+{
+public:
+    StaticScene();
+
+    // The recording holds this version of the scene
+    bool isCurrent(uint32_t sceneVersion) const { return recorded && version == sceneVersion; }
+
+    // Forgets the recording without touching OpenGL, so any thread may call it
+    void invalidate() { recorded = false; }
+
+    // GL thread only
+    void begin(uint32_t sceneVersion);
+    void end();
+    void draw() const;
+
+private:
+    unsigned int list; // Display list name, reused by every recording
+    uint32_t version;
+    bool recorded;
+};
+
+#endif
@@ -4,8 +4,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <windows.h>
 #include <GL/glut.h>
+#include "PixelConvert.h"
 
 // Removed glew.h and glaux.h - not needed for MinGW
 // Removed #pragma comment(lib, ...) - MSVC-only
@@ -21,7 +21,7 @@ typedef struct _AUX_RGBImageRec_TB
 } AUX_RGBImageRec_TB;
 
 // Custom BMP loader
-static AUX_RGBImageRec_TB *auxDIBImageLoadA_TB(const char *filename)
+static inline AUX_RGBImageRec_TB *auxDIBImageLoadA_TB(const char *filename)
 {
     FILE *file = fopen(filename, "rb");
     if (!file)
@@ -53,61 +53,45 @@ static AUX_RGBImageRec_TB *auxDIBImageLoadA_TB(const char *filename)
     int rowSize = ((width * 3 + 3) / 4) * 4;
     int imageSize = rowSize * height;
 
-    unsigned char *rawData = (unsigned char *)malloc(imageSize);
-    if (!rawData)
-    {
-        fclose(file);
-        return NULL;
-    }
-
-    fseek(file, dataOffset, SEEK_SET);
-    if (fread(rawData, 1, imageSize, file) != (size_t)imageSize)
-    {
-        free(rawData);
-        fclose(file);
-        return NULL;
-    }
-    fclose(file);
-
     AUX_RGBImageRec_TB *result = (AUX_RGBImageRec_TB *)malloc(sizeof(AUX_RGBImageRec_TB));
     if (!result)
     {
-        free(rawData);
+        fclose(file);
         return NULL;
     }
 
+    // The padded rows are read straight into the result and packed in place
     result->sizeX = width;
     result->sizeY = height;
-    result->data = (unsigned char *)malloc(width * height * 3);
+    result->data = (unsigned char *)malloc(imageSize);
     if (!result->data)
     {
-        free(rawData);
         free(result);
+        fclose(file);
         return NULL;
     }
 
-    for (int y = 0; y < height; y++)
+    fseek(file, dataOffset, SEEK_SET);
+    if (fread(result->data, 1, imageSize, file) != (size_t)imageSize)
     {
-        for (int x = 0; x < width; x++)
-        {
-            int srcIdx = y * rowSize + x * 3;
-            int dstIdx = y * width * 3 + x * 3;
-            result->data[dstIdx + 0] = rawData[srcIdx + 2];
-            result->data[dstIdx + 1] = rawData[srcIdx + 1];
-            result->data[dstIdx + 2] = rawData[srcIdx + 0];
-        }
+        free(result->data);
+        free(result);
+        fclose(file);
+        return NULL;
     }
-    free(rawData);
+    fclose(file);
+
+    PixelConvert::swapRedBlueRows(result->data, rowSize, result->data, width, height, 3, false);
     return result;
 }
 
-static void loadPPM(GLuint *textureID, char *strFileName, int width, int height, int wrap)
+static inline void loadPPM(GLuint *textureID, char *strFileName, int width, int height, int wrap)
 {
-    BYTE *data;
+    unsigned char *data;
     FILE *pFile = fopen(strFileName, "rb");
     if (pFile)
     {
-        data = (BYTE *)malloc(width * height * 3);
+        data = (unsigned char *)malloc(width * height * 3);
         fread(data, 1, width * height * 3, pFile);
         fclose(pFile);
     }
@@ -128,7 +112,7 @@ static void loadPPM(GLuint *textureID, char *strFileName, int width, int height,
     free(data);
 }
 
-static void loadBMP(GLuint *textureID, char *strFileName, int wrap)
+static inline void loadBMP(GLuint *textureID, char *strFileName, int wrap)
 {
     AUX_RGBImageRec_TB *pBitmap = auxDIBImageLoadA_TB(strFileName);
     if (!pBitmap)
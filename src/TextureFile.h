@@ -0,0 +1,70 @@
+#ifndef TEXTURE_FILE_H
+#define TEXTURE_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Cooked textures. tools/TextureCooker.cpp block compresses images offline
+// into a .dds: the standard 128-byte DDS header, then every mip level from
+// the largest down to 1x1, each a grid of 4x4 blocks that GLTexture hands
+// to glCompressedTexImage2D untouched. Unlike other DDS writers the block
+// rows run bottom to top, the way OpenGL (and our BMP and TGA loaders)
+// expect images, so nothing is flipped at load time.
+
+static const uint32_t DDS_MAGIC = 0x20534444;       // "DDS "
+static const uint32_t DDS_FOURCC_DXT1 = 0x31545844; // BC1: RGB, 8 bytes per block
+static const uint32_t DDS_FOURCC_DXT5 = 0x35545844; // BC3: RGBA, 16 bytes per block
+static const uint32_t DDS_FOURCC_ATI2 = 0x32495441; // BC5: two channels, normal map x and y, 16 bytes per block
+
+static const uint32_t DDSD_CAPS = 0x1;
+static const uint32_t DDSD_HEIGHT = 0x2;
+static const uint32_t DDSD_WIDTH = 0x4;
+static const uint32_t DDSD_PIXELFORMAT = 0x1000;
+static const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+static const uint32_t DDSD_LINEARSIZE = 0x80000;
+static const uint32_t DDPF_FOURCC = 0x4;
+static const uint32_t DDSCAPS_COMPLEX = 0x8;
+static const uint32_t DDSCAPS_TEXTURE = 0x1000;
+static const uint32_t DDSCAPS_MIPMAP = 0x400000;
+
+struct DdsPixelFormat
+{
+    uint32_t size; // 32
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t rMask, gMask, bMask, aMask;
+};
+
+struct DdsHeader
+{
+    uint32_t magic;
+    uint32_t size; // 124, the header without the magic
+    uint32_t flags;
+    uint32_t height, width;
+    uint32_t linearSize; // Bytes in the largest level
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    DdsPixelFormat pixelFormat;
+    uint32_t caps, caps2, caps3, caps4;
+    uint32_t reserved2;
+};
+
+// Bytes per 4x4 block, 0 for formats we don't cook
+inline int ddsBlockBytes(uint32_t fourCC)
+{
+    if (fourCC == DDS_FOURCC_DXT1)
+        return 8;
+    if (fourCC == DDS_FOURCC_DXT5 || fourCC == DDS_FOURCC_ATI2)
+        return 16;
+    return 0;
+}
+
+// Partial blocks at the edges are stored whole
+inline size_t ddsLevelSize(int width, int height, int blockBytes)
+{
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+}
+
+#endif
@@ -0,0 +1,299 @@
+#include "TextureStreamer.h"
+#include "BlockCompression.h"
+#include "GLExtensions.h"
+#include "Platform.h"
+#include "Profiler.h"
+#include "TextureFile.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static const int MAX_LEVELS = 16;
+static const size_t UPLOAD_BYTES_PER_FRAME = 4 << 20; // A 2048x2048 BC3 level, about 1 ms over PCIe
+
+struct StreamedTexture
+{
+    GLuint name;
+    Platform::MappedFile file;
+    uint32_t fourCC;
+    GLenum format;
+    bool native; // Blocks go to GL as they are, otherwise decoded to RGBA here
+    int levels;
+    int tail;      // First level that is always resident
+    int base;      // Finest resident level
+    int wanted;    // Level last frame's draws asked for
+    int requested; // Finest level asked for this frame, tail if none
+    uint32_t lastUsed;
+    const unsigned char *data[MAX_LEVELS];
+    size_t size[MAX_LEVELS];  // Bytes in the file
+    size_t bytes[MAX_LEVELS]; // Bytes in video memory
+    int width[MAX_LEVELS], height[MAX_LEVELS];
+};
+
+static std::vector<StreamedTexture> textures;
+static size_t budget = 256 << 20;
+static size_t resident = 0;
+static uint32_t frame = 1;
+
+void TextureStreamer::setBudget(size_t bytes)
+{
+    budget = bytes;
+}
+
+size_t TextureStreamer::getBudget()
+{
+    return budget;
+}
+
+size_t TextureStreamer::getResidentBytes()
+{
+    return resident;
+}
+
+int TextureStreamer::getPendingCount()
+{
+    int pending = 0;
+    for (size_t i = 0; i < textures.size(); i++)
+        if (textures[i].base > textures[i].wanted)
+            pending++;
+    return pending;
+}
+
+static StreamedTexture *find(GLuint name)
+{
+    for (size_t i = 0; i < textures.size(); i++)
+        if (textures[i].name == name)
+            return &textures[i];
+    return NULL;
+}
+
+static void upload(StreamedTexture &texture, int level)
+{
+    int w = texture.width[level], h = texture.height[level];
+    if (texture.native)
+        GLExtensions::compressedTexImage2D(GL_TEXTURE_2D, level, texture.format, w, h, 0, (GLsizei)texture.size[level],
+                                           texture.data[level]);
+    else
+    {
+        std::vector<unsigned char> pixels((size_t)w * h * 4);
+        BlockCompression::decompress(texture.data[level], w, h, texture.fourCC, &pixels[0]);
+        glTexImage2D(GL_TEXTURE_2D, level, texture.fourCC == DDS_FOURCC_DXT5 ? GL_RGBA : GL_RGB, w, h, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, &pixels[0]);
+    }
+    resident += texture.bytes[level];
+}
+
+unsigned int TextureStreamer::open(const char *path, int &width, int &height)
+{
+    Platform::MappedFile file;
+    if (!Platform::mapFile(path, file))
+        return 0;
+
+    DdsHeader header;
+    int blockBytes = 0;
+    if (file.size >= sizeof(header))
+    {
+        memcpy(&header, file.data, sizeof(header));
+        if (header.magic == DDS_MAGIC && header.size == sizeof(header) - 4 && (header.pixelFormat.flags & DDPF_FOURCC) &&
+            header.width > 0 && header.height > 0)
+            blockBytes = ddsBlockBytes(header.pixelFormat.fourCC);
+    }
+
+    // Make sure every level is in the file
+    StreamedTexture texture;
+    texture.levels = 0;
+    if (blockBytes)
+    {
+        int count = (header.flags & DDSD_MIPMAPCOUNT) && header.mipMapCount > 0 ? header.mipMapCount : 1;
+        int w = header.width, h = header.height;
+        size_t end = sizeof(header);
+        while (texture.levels < count && texture.levels < MAX_LEVELS && end + ddsLevelSize(w, h, blockBytes) <= file.size)
+        {
+            int level = texture.levels++;
+            texture.data[level] = file.data + end;
+            texture.size[level] = ddsLevelSize(w, h, blockBytes);
+            texture.width[level] = w;
+            texture.height[level] = h;
+            end += texture.size[level];
+            w = w > 1 ? w / 2 : 1;
+            h = h > 1 ? h / 2 : 1;
+        }
+        if (texture.levels < count)
+            texture.levels = 0;
+    }
+    if (texture.levels == 0)
+    {
+        printf("Warning: %s is not a cooked texture\n", path);
+        fflush(stdout);
+        Platform::unmapFile(file);
+        return 0;
+    }
+
+    texture.file = file;
+    texture.fourCC = header.pixelFormat.fourCC;
+    texture.format = GL_COMPRESSED_RG_RGTC2;
+    if (texture.fourCC == DDS_FOURCC_DXT1)
+        texture.format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    else if (texture.fourCC == DDS_FOURCC_DXT5)
+        texture.format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+    // Without driver support the blocks are decoded here, the mips are still the cooked ones
+    GLExtensions::load();
+    texture.native = texture.fourCC == DDS_FOURCC_ATI2 ? GLExtensions::hasRGTC : GLExtensions::hasS3TC;
+    for (int level = 0; level < texture.levels; level++)
+        texture.bytes[level] = texture.native ? texture.size[level]
+                                              : (size_t)texture.width[level] * texture.height[level] *
+                                                    (texture.fourCC == DDS_FOURCC_DXT5 ? 4 : 3);
+
+    texture.tail = 0;
+    while (texture.tail < texture.levels - 1 &&
+           (texture.width[texture.tail] > TAIL_SIZE || texture.height[texture.tail] > TAIL_SIZE))
+        texture.tail++;
+    texture.base = texture.tail;
+    texture.wanted = texture.requested = texture.tail;
+    texture.lastUsed = 0;
+
+    glGenTextures(1, &texture.name);
+    glBindTexture(GL_TEXTURE_2D, texture.name);
+
+    // Use mipmapping filter if there are mips
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture.levels > 1 ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture.tail);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.levels - 1);
+    for (int level = texture.tail; level < texture.levels; level++)
+        upload(texture, level);
+
+    width = header.width;
+    height = header.height;
+    textures.push_back(texture);
+    return texture.name;
+}
+
+void TextureStreamer::request(unsigned int name, float screenPixels)
+{
+    StreamedTexture *texture = find(name);
+    if (!texture)
+        return;
+
+    // The level whose size is closest above the screen size
+    int level = 0;
+    float size = (float)(texture->width[0] > texture->height[0] ? texture->width[0] : texture->height[0]);
+    while (level < texture->tail && size * 0.5f >= screenPixels)
+    {
+        size *= 0.5f;
+        level++;
+    }
+    if (texture->lastUsed != frame || level < texture->requested)
+        texture->requested = level;
+    texture->lastUsed = frame;
+}
+
+float TextureStreamer::projectedSize(float radius)
+{
+    GLfloat modelview[16], projection[16];
+    GLint viewport[4];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+    glGetFloatv(GL_PROJECTION_MATRIX, projection);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    float scale = sqrtf(modelview[0] * modelview[0] + modelview[1] * modelview[1] + modelview[2] * modelview[2]);
+    float r = radius * scale;
+    float depth = -modelview[14];
+    if (depth < r)
+        depth = r; // The camera is inside the sphere, it covers the screen
+    if (depth <= 0.0f)
+        return (float)viewport[3];
+    return r * projection[5] * viewport[3] / depth;
+}
+
+// Drops the finest resident level of the least recently drawn texture other
+// than keep, among those last drawn before the given frame. With surplusOnly,
+// only levels finer than their texture wants.
+static bool evictOne(const StreamedTexture *keep, bool surplusOnly, uint32_t drawnBefore)
+{
+    StreamedTexture *victim = NULL;
+    for (size_t i = 0; i < textures.size(); i++)
+    {
+        StreamedTexture &texture = textures[i];
+        if (&texture == keep || texture.base >= texture.tail || texture.lastUsed >= drawnBefore ||
+            (surplusOnly && texture.base >= texture.wanted))
+            continue;
+        if (!victim || texture.lastUsed < victim->lastUsed ||
+            (texture.lastUsed == victim->lastUsed && texture.bytes[texture.base] > victim->bytes[victim->base]))
+            victim = &texture;
+    }
+    if (!victim)
+        return false;
+
+    // Stop sampling the level before freeing it
+    int level = victim->base++;
+    glBindTexture(GL_TEXTURE_2D, victim->name);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, victim->base);
+    glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    resident -= victim->bytes[level];
+    return true;
+}
+
+void TextureStreamer::update()
+{
+    if (textures.empty())
+        return;
+    PROFILE_ZONE("TextureStreamer::update");
+
+    // Textures not drawn this frame want no more than their tail
+    for (size_t i = 0; i < textures.size(); i++)
+    {
+        StreamedTexture &texture = textures[i];
+        texture.wanted = texture.lastUsed == frame ? texture.requested : texture.tail;
+        texture.requested = texture.tail;
+    }
+
+    while (resident > budget && (evictOne(NULL, true, frame + 1) || evictOne(NULL, false, frame + 1)))
+    {
+    }
+
+    // One level at a time to whichever texture is furthest from what it
+    // wants, so everything on screen sharpens together
+    size_t uploaded = 0;
+    for (;;)
+    {
+        StreamedTexture *next = NULL;
+        for (size_t i = 0; i < textures.size(); i++)
+        {
+            StreamedTexture &texture = textures[i];
+            if (texture.base > texture.wanted && (!next || texture.base - texture.wanted > next->base - next->wanted))
+                next = &texture;
+        }
+        if (!next)
+            break;
+
+        int level = next->base - 1;
+        size_t bytes = next->bytes[level];
+        if (uploaded > 0 && uploaded + bytes > UPLOAD_BYTES_PER_FRAME)
+            break;
+
+        // Make room from levels nobody needs, then from textures not on
+        // screen; taking from ones that are would only swap the blur around
+        while (resident + bytes > budget && evictOne(next, true, frame + 1))
+        {
+        }
+        while (resident + bytes > budget && evictOne(next, false, frame))
+        {
+        }
+        if (resident + bytes > budget)
+        {
+            next->wanted = next->base; // Doesn't fit, try again next frame
+            continue;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, next->name);
+        upload(*next, level);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+        next->base = level;
+        uploaded += bytes;
+    }
+
+    frame++;
+}
@@ -0,0 +1,41 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <stddef.h>
+
+// Mip streaming for cooked .dds textures under a video memory budget.
+// open() makes the texture usable at once with only its small mips (the
+// tail, TAIL_SIZE and below). Each frame, draws report how many pixels a
+// texture covers on screen; update() then uploads the finer mips that size
+// calls for, a few megabytes per frame so loading never stalls, and evicts
+// the finest mips of the least recently drawn textures while over budget.
+// GL_TEXTURE_BASE_LEVEL hides the levels that are not resident. GL thread only.
+class TextureStreamer
+{
+public:
+    static const int TAIL_SIZE = 64;
+
+    static void setBudget(size_t bytes);
+    static size_t getBudget();
+    static size_t getResidentBytes();
+
+    // Textures drawn last frame that still lack mips they want
+    static int getPendingCount();
+
+    // Creates a GL texture from a cooked .dds with its tail resident and keeps
+    // the file mapped for later levels. Returns 0 if the file can't be used.
+    static unsigned int open(const char *path, int &width, int &height);
+
+    // The texture was drawn this frame about screenPixels across; textures
+    // not opened here are ignored
+    static void request(unsigned int texture, float screenPixels);
+
+    // Pixels across a sphere of radius (object units) around the current
+    // modelview origin, with the current projection and viewport
+    static float projectedSize(float radius);
+
+    // Call once per frame after drawing
+    static void update();
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "TimerWheel.h"
+
+TimerWheel::TimerWheel()
+{
+    now = 0;
+    serial = 0;
+}
+
+void TimerWheel::clear()
+{
+    for (uint32_t s = 0; s < SLOT_COUNT; s++)
+        slots[s].clear();
+    due.clear();
+    now = 0;
+}
+
+TimerWheel::TimerId TimerWheel::schedule(uint32_t tick, const std::function<void()> &callback)
+{
+    if (tick <= now)
+        tick = now + 1;
+
+    uint32_t slot = tick & (SLOT_COUNT - 1);
+    serial = (serial + 1) & 0xFFFFFF;
+    if (serial == 0)
+        serial = 1;
+
+    Timer timer;
+    timer.id = serial << 8 | slot;
+    timer.tick = tick;
+    timer.callback = callback;
+    slots[slot].push_back(timer);
+    return timer.id;
+}
+
+bool TimerWheel::cancel(TimerId id)
+{
+    if (id == NO_TIMER)
+        return false;
+
+    std::vector<Timer> &slot = slots[id & (SLOT_COUNT - 1)];
+    for (size_t i = 0; i < slot.size(); i++)
+    {
+        if (slot[i].id == id)
+        {
+            slot.erase(slot.begin() + i); // Keeps the scheduling order
+            return true;
+        }
+    }
+    return false;
+}
+
+void TimerWheel::advance(uint32_t tick)
+{
+    while (now < tick)
+    {
+        now++;
+
+        // Take the due timers out first, callbacks may schedule or cancel others
+        std::vector<Timer> &slot = slots[now & (SLOT_COUNT - 1)];
+        due.clear();
+        size_t kept = 0;
+        for (size_t i = 0; i < slot.size(); i++)
+        {
+            if (slot[i].tick == now)
+                due.push_back(slot[i]);
+            else
+                slot[kept++] = slot[i];
+        }
+        slot.resize(kept);
+
+        for (size_t i = 0; i < due.size(); i++)
+            due[i].callback();
+    }
+}
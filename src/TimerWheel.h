@@ -0,0 +1,52 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Gameplay events scheduled at an absolute sim tick. Timers hash into a
+// ring of slots by their due tick, so advancing one tick only looks at the
+// timers in one slot and a timer costs nothing until it fires; timers more
+// than one revolution out simply stay in their slot until their tick comes.
+// Callbacks fire in the order they were scheduled within a tick.
+class TimerWheel
+{
+public:
+    typedef uint32_t TimerId;
+    static const TimerId NO_TIMER = 0;
+
+    TimerWheel();
+
+    // Drops every timer without firing it and restarts at tick 0
+    void clear();
+
+    uint32_t getTick() const { return now; }
+
+    // Fires callback when advance() reaches tick; ticks already passed fire on the next advance
+    TimerId schedule(uint32_t tick, const std::function<void()> &callback);
+
+    // Returns false if the timer already fired or was cancelled
+    bool cancel(TimerId id);
+
+    // Moves to tick, firing every timer due up to and including it
+    void advance(uint32_t tick);
+
+private:
+    static const uint32_t SLOT_COUNT = 256; // Power of two
+
+    struct Timer
+    {
+        TimerId id;
+        uint32_t tick;
+        std::function<void()> callback;
+    };
+
+    uint32_t now;
+    uint32_t serial; // Ids are serial << 8 | slot, so cancel() only searches one slot
+    std::vector<Timer> slots[SLOT_COUNT];
+    std::vector<Timer> due; // Fired this tick, kept for its capacity
+};
+
+#endif
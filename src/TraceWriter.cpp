@@ -0,0 +1,162 @@
+#include "TraceWriter.h"
+
+#if EGYPT_PROFILE
+
+#include <chrono>
+
+TraceWriter &TraceWriter::get()
+{
+    static TraceWriter instance;
+    return instance;
+}
+
+TraceWriter::TraceWriter()
+{
+    active = false;
+    running = false;
+    file = NULL;
+    baseNs = 0;
+    firstEvent = true;
+}
+
+TraceWriter::~TraceWriter()
+{
+    stop();
+
+    // Rings outlive stop() because threads keep a cached pointer to theirs
+    for (size_t i = 0; i < rings.size(); i++)
+        delete rings[i];
+}
+
+bool TraceWriter::start(const char *path)
+{
+    if (running)
+        return true;
+
+    file = fopen(path, "wb");
+    if (!file)
+    {
+        printf("Warning: could not open trace file %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"EgyptianDriving\"}}");
+    firstEvent = false;
+
+    baseNs = Profiler::nowNs();
+    running = true;
+    active = true;
+    writer = std::thread(&TraceWriter::writerLoop, this);
+
+    printf("Tracing frame timeline to %s\n", path);
+    fflush(stdout);
+    return true;
+}
+
+void TraceWriter::stop()
+{
+    if (!running)
+        return;
+
+    active = false;
+    running = false;
+    writer.join();
+
+    // Anything pushed after the writer's last pass
+    drain();
+
+    uint32_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (size_t i = 0; i < rings.size(); i++)
+            dropped += rings[i]->dropped.exchange(0);
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    file = NULL;
+
+    if (dropped > 0)
+        printf("Trace: %u events dropped (ring full)\n", dropped);
+}
+
+TraceWriter::Ring *TraceWriter::threadRing()
+{
+    static thread_local Ring *ring = NULL;
+    if (ring)
+        return ring;
+
+    // First event on this thread, register a ring for it
+    ring = new Ring();
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    ring->tid = (int)rings.size() + 1;
+    rings.push_back(ring);
+    return ring;
+}
+
+void TraceWriter::push(int zone, uint64_t startNs, uint64_t durNs)
+{
+    Ring *ring = threadRing();
+
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    uint32_t tail = ring->tail.load(std::memory_order_acquire);
+    if (head - tail >= RING_SIZE)
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Event &e = ring->events[head & (RING_SIZE - 1)];
+    e.startNs = startNs;
+    e.durNs = durNs;
+    e.zone = zone;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void TraceWriter::writerLoop()
+{
+    while (running)
+    {
+        drain();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+void TraceWriter::drain()
+{
+    std::vector<Ring *> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        snapshot = rings;
+    }
+
+    Profiler &profiler = Profiler::get();
+
+    for (size_t r = 0; r < snapshot.size(); r++)
+    {
+        Ring *ring = snapshot[r];
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint32_t head = ring->head.load(std::memory_order_acquire);
+
+        for (; tail != head; tail++)
+        {
+            const Event &e = ring->events[tail & (RING_SIZE - 1)];
+            uint64_t start = e.startNs > baseNs ? e.startNs - baseNs : 0;
+
+            // Complete ("X") events, timestamps in microseconds
+            fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    firstEvent ? "" : ",\n", profiler.getZone(e.zone).name, ring->tid,
+                    start / 1000.0, e.durNs / 1000.0);
+            firstEvent = false;
+        }
+
+        ring->tail.store(tail, std::memory_order_release);
+    }
+}
+
+#endif // EGYPT_PROFILE
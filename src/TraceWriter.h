@@ -0,0 +1,73 @@
+#ifndef TRACE_WRITER_H
+#define TRACE_WRITER_H
+
+#include "Profiler.h"
+
+#if EGYPT_PROFILE
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+// Streams every profiler zone to a Chrome Trace Event JSON file that can be
+// opened in chrome://tracing or ui.perfetto.dev.
+//
+// Each thread writes into its own lock-free single-producer ring, a
+// background thread drains the rings and does all formatting and file I/O,
+// so the game thread never blocks on disk. Events are dropped (and counted)
+// if a ring fills up faster than the writer can drain it.
+class TraceWriter
+{
+public:
+    static TraceWriter &get();
+
+    bool start(const char *path);
+    void stop();
+    bool isActive() const { return active.load(std::memory_order_relaxed); }
+
+    // Called by Profiler::endZone on any thread
+    void push(int zone, uint64_t startNs, uint64_t durNs);
+
+private:
+    TraceWriter();
+    ~TraceWriter();
+
+    static const uint32_t RING_SIZE = 16384; // Power of two
+
+    struct Event
+    {
+        uint64_t startNs;
+        uint64_t durNs;
+        int zone;
+    };
+
+    struct Ring
+    {
+        Event events[RING_SIZE];
+        std::atomic<uint32_t> head; // Written by the owning thread
+        std::atomic<uint32_t> tail; // Written by the writer thread
+        std::atomic<uint32_t> dropped;
+        int tid;
+    };
+
+    std::atomic<bool> active;
+    std::atomic<bool> running;
+    FILE *file;
+    std::thread writer;
+    uint64_t baseNs;
+    bool firstEvent;
+
+    std::mutex ringsMutex;
+    std::vector<Ring *> rings;
+
+    Ring *threadRing();
+    void writerLoop();
+    void drain();
+};
+
+#endif // EGYPT_PROFILE
+
+#endif // TRACE_WRITER_H
@@ -0,0 +1,414 @@
+#include "Traffic.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+static const float TICK_SECONDS = 0.016f; // Speeds are stored in units per tick
+static const float FLASH_RANGE = 15.0f;   // Flashing reaches cars this far ahead
+static const float CHANGE_SPACING = 10.0f; // Two cars never merge into one lane this close in one tick
+
+TrafficSystem::TrafficSystem()
+{
+    roadWidth = 20.0f;
+    laneWidth = 4.0f;
+    laneCount = 5;
+    tickCount = 0;
+}
+
+void TrafficSystem::configure(float width, float lane)
+{
+    roadWidth = width;
+    laneWidth = lane > 0.0f ? lane : width;
+    laneCount = std::max(1, (int)(roadWidth / laneWidth));
+    clear();
+}
+
+void TrafficSystem::clear()
+{
+    lanes.assign(laneCount, std::vector<int>());
+    laneZ.assign(laneCount, std::vector<float>());
+    next.assign(laneCount, std::vector<int>());
+    placed.clear();
+    placedLane.clear();
+    placedZ.clear();
+    leaders.clear();
+    accel.clear();
+    wantLane.clear();
+    filed.clear();
+    tickCount = 0;
+}
+
+bool TrafficSystem::isClear(int lane, float z, float clearance) const
+{
+    const std::vector<float> &zs = laneZ[lane];
+    std::vector<float>::const_iterator it = std::lower_bound(zs.begin(), zs.end(), z - clearance);
+    if (it != zs.end() && *it < z + clearance)
+        return false;
+
+    for (size_t i = 0; i < placed.size(); i++)
+    {
+        if (placedLane[i] == lane && std::abs(placedZ[i] - z) < clearance)
+            return false;
+    }
+    return true;
+}
+
+void TrafficSystem::place(Registry &entities, int driver, int lane, float z, float speed)
+{
+    Entity e = entities.drivers.entity(driver);
+    entities.setActive(e, true);
+
+    Transform &t = entities.transforms.get(e);
+    t.x = laneCenter(lane);
+    t.z = z;
+    entities.velocities.get(e).speed = speed;
+
+    AIDriver &ai = entities.drivers[driver];
+    ai.lane = lane;
+    ai.desiredSpeed = speed;
+    ai.targetX = t.x;
+    ai.isMovingAside = false;
+    ai.cooldown = 0;
+
+    placed.push_back(driver);
+    placedLane.push_back(lane);
+    placedZ.push_back(z);
+}
+
+float TrafficSystem::idmAccel(float v, float desired, float gap, float leaderV) const
+{
+    float free = desired > 0.0f ? 1.0f - powf(v / desired, 4.0f) : -1.0f;
+    if (gap == INFINITY)
+        return idm.maxAccel * free;
+
+    float dv = v - leaderV;
+    float sStar = idm.minGap + std::max(0.0f, v * idm.headway + v * dv / (2.0f * sqrtf(idm.maxAccel * idm.comfortDecel)));
+    float ratio = sStar / std::max(gap, 0.01f);
+    return idm.maxAccel * (free - ratio * ratio);
+}
+
+float TrafficSystem::accelBehind(const Registry &entities, float v, float desired, float z, float length, int leader,
+                                 const TrafficTick &tick) const
+{
+    if (leader == NO_LEADER)
+        return idmAccel(v, desired, INFINITY, 0.0f);
+
+    if (leader == PLAYER_LEADER)
+    {
+        float gap = tick.playerZ - tick.playerSize - (z + length / 2);
+        return idmAccel(v, desired, gap, tick.playerSpeed / TICK_SECONDS);
+    }
+
+    Entity e = entities.drivers.entity(leader);
+    float leaderZ = entities.transforms.get(e).z;
+    float leaderLength = entities.colliders.get(e).length;
+    float gap = (leaderZ - leaderLength / 2) - (z + length / 2);
+    return idmAccel(v, desired, gap, entities.velocities.get(e).speed / TICK_SECONDS);
+}
+
+// Index in lanes[lane] of the last car behind z, or -1
+int TrafficSystem::findFollower(int lane, float z) const
+{
+    const std::vector<float> &zs = laneZ[lane];
+    return (int)(std::lower_bound(zs.begin(), zs.end(), z) - zs.begin()) - 1;
+}
+
+bool TrafficSystem::playerInLane(int lane, const TrafficTick &tick) const
+{
+    return std::abs(laneCenter(lane) - tick.playerX) < laneWidth / 2 + tick.playerSize;
+}
+
+// Read-only pass: IDM acceleration and a lane change proposal per car
+void TrafficSystem::decide(Registry &entities, int first, int last, const TrafficTick &tick)
+{
+    for (int i = first; i < last; i++)
+    {
+        Entity e = entities.drivers.entity(i);
+        wantLane[i] = entities.drivers[i].lane;
+        if (!entities.isActive(e))
+            continue;
+
+        AIDriver &ai = entities.drivers[i];
+        const Transform &t = entities.transforms.get(e);
+        float length = entities.colliders.get(e).length;
+        float v = entities.velocities.get(e).speed / TICK_SECONDS;
+        float desired = ai.desiredSpeed / TICK_SECONDS;
+
+        accel[i] = accelBehind(entities, v, desired, t.z, length, leaders[i], tick);
+        if (ai.isMovingAside)
+            continue;
+
+        // Flashing the lights asks a car just ahead to make room, towards the
+        // outside; cars already in an outer lane pull off onto the shoulder
+        bool flashed = false;
+        if (tick.justFlashed)
+        {
+            float distZ = t.z - tick.playerZ;
+            flashed = distZ > 0 && distZ < FLASH_RANGE && std::abs(t.x - tick.playerX) < 4.0f;
+        }
+        int outward = t.x > 0 ? ai.lane + 1 : ai.lane - 1;
+        if (flashed && (outward < 0 || outward >= laneCount))
+        {
+            ai.isMovingAside = true;
+            ai.targetX = t.x > 0 ? t.x + 6.0f : t.x - 6.0f;
+            continue;
+        }
+
+        // Lane changes are considered by an eighth of the cars each tick, and
+        // never while still sliding over from the last one
+        bool settled = std::abs(t.x - laneCenter(ai.lane)) < 0.1f && ai.cooldown == 0;
+        if (!flashed && (!settled || ((uint32_t)i + tickCount) % 8 != 0))
+            continue;
+
+        float bestGain = idm.changeThreshold;
+        for (int side = -1; side <= 1; side += 2)
+        {
+            int lane = ai.lane + side;
+            if (lane < 0 || lane >= laneCount || (flashed && lane != outward))
+                continue;
+
+            // Never cut in beside or just ahead of the player
+            if (playerInLane(lane, tick))
+            {
+                float clearance = length / 2 + tick.playerSize + idm.minGap;
+                float dz = t.z - tick.playerZ;
+                if (dz > -clearance && dz < clearance + tick.playerSpeed / TICK_SECONDS * idm.headway)
+                    continue;
+            }
+
+            // New leader and follower in the target lane
+            const std::vector<int> &queue = lanes[lane];
+            int k = findFollower(lane, t.z);
+            int follower = k >= 0 ? queue[k] : NO_LEADER;
+            int leader = k + 1 < (int)queue.size() ? queue[k + 1] : NO_LEADER;
+            if (playerInLane(lane, tick) && tick.playerZ > t.z)
+            {
+                float leaderZ = leader >= 0 ? entities.transforms.get(entities.drivers.entity(leader)).z : INFINITY;
+                if (tick.playerZ < leaderZ)
+                    leader = PLAYER_LEADER;
+            }
+
+            float newAccel = accelBehind(entities, v, desired, t.z, length, leader, tick);
+            if (newAccel < -idm.safeDecel)
+                continue; // Would cut in too close to the new leader
+
+            float followerLoss = 0.0f;
+            if (follower >= 0)
+            {
+                Entity f = entities.drivers.entity(follower);
+                const Transform &ft = entities.transforms.get(f);
+                float fLength = entities.colliders.get(f).length;
+                float fv = entities.velocities.get(f).speed / TICK_SECONDS;
+                float fDesired = entities.drivers[follower].desiredSpeed / TICK_SECONDS;
+                float gap = (t.z - length / 2) - (ft.z + fLength / 2);
+                float withMe = idmAccel(fv, fDesired, gap, v);
+                if (gap < idm.minGap || withMe < -idm.safeDecel)
+                    continue; // Unsafe for the car behind
+                followerLoss = accelBehind(entities, fv, fDesired, ft.z, fLength, leader, tick) - withMe;
+            }
+
+            float gain = newAccel - accel[i] - idm.politeness * followerLoss;
+            if (flashed || gain > bestGain)
+            {
+                bestGain = gain;
+                wantLane[i] = lane;
+            }
+        }
+    }
+}
+
+// Serial: lane changes proposed in the same tick must not merge side by side
+void TrafficSystem::commitLaneChanges(Registry &entities)
+{
+    changers.clear();
+    int cooldownTicks = (int)(idm.cooldownSeconds / TICK_SECONDS);
+
+    for (size_t i = 0; i < entities.drivers.size(); i++)
+    {
+        AIDriver &ai = entities.drivers[i];
+        if (wantLane[i] == ai.lane)
+            continue;
+
+        float z = entities.transforms.get(entities.drivers.entity(i)).z;
+        bool clash = false;
+        for (size_t c = 0; c < changers.size(); c += 2)
+        {
+            if ((int)changers[c + 1] == wantLane[i] && std::abs(changers[c] - z) < CHANGE_SPACING)
+            {
+                clash = true;
+                break;
+            }
+        }
+        if (clash)
+            continue;
+
+        ai.lane = wantLane[i];
+        ai.cooldown = cooldownTicks;
+        changers.push_back(z);
+        changers.push_back((float)ai.lane);
+    }
+}
+
+// Integrates each car on its own, then tests it against the player
+bool TrafficSystem::move(Registry &entities, int first, int last, const TrafficTick &tick)
+{
+    bool hit = false;
+    float slide = laneWidth * TICK_SECONDS / idm.changeSeconds;
+
+    for (int i = first; i < last; i++)
+    {
+        Entity e = entities.drivers.entity(i);
+        if (!entities.isActive(e))
+            continue;
+
+        AIDriver &ai = entities.drivers[i];
+        Transform &t = entities.transforms.get(e);
+
+        if (tick.moveTraffic)
+        {
+            float &speed = entities.velocities.get(e).speed;
+            speed = std::max(0.0f, speed + accel[i] * TICK_SECONDS * TICK_SECONDS);
+            t.z += speed;
+
+            if (ai.isMovingAside)
+            {
+                t.x += (ai.targetX - t.x) * 0.01f; // Slowly onto the shoulder
+            }
+            else
+            {
+                float dx = laneCenter(ai.lane) - t.x;
+                t.x += std::max(-slide, std::min(slide, dx));
+            }
+            if (ai.cooldown > 0)
+                ai.cooldown--;
+
+            // Despawn if too far behind OR if on grass
+            if (t.z < tick.playerZ - 20 || std::abs(t.x) > roadWidth / 2)
+            {
+                entities.setActive(e, false);
+                continue;
+            }
+        }
+
+        const Collider &c = entities.colliders.get(e);
+        if (std::abs(tick.playerX - t.x) < (tick.playerSize + c.width / 2) &&
+            std::abs(tick.playerZ - t.z) < (tick.playerSize + c.length / 2))
+        {
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+bool TrafficSystem::update(Registry &entities, const TrafficTick &tick, JobSystem *jobs)
+{
+    PROFILE_ZONE("TrafficSystem::update");
+
+    int count = (int)entities.drivers.size();
+    leaders.resize(count, (int)NO_LEADER);
+    accel.resize(count, 0.0f);
+    wantLane.resize(count, 0);
+    tickCount++;
+
+    // Each pass only writes its own car, so both run in parallel and give the
+    // same result with or without a job system
+    if (tick.moveTraffic)
+    {
+        auto decideRange = [&](int first, int last) { decide(entities, first, last, tick); };
+        if (jobs)
+            jobs->parallelFor(0, count, DRIVER_GRAIN, decideRange);
+        else
+            decideRange(0, count);
+
+        commitLaneChanges(entities);
+    }
+
+    std::atomic<bool> hit(false);
+    auto moveRange = [&](int first, int last)
+    {
+        if (move(entities, first, last, tick))
+            hit.store(true, std::memory_order_relaxed);
+    };
+    if (jobs)
+        jobs->parallelFor(0, count, DRIVER_GRAIN, moveRange);
+    else
+        moveRange(0, count);
+
+    return hit;
+}
+
+void TrafficSystem::rebuild(Registry &entities, const TrafficTick &tick)
+{
+    PROFILE_ZONE("TrafficSystem::rebuild");
+
+    int count = (int)entities.drivers.size();
+    leaders.assign(count, (int)NO_LEADER);
+    filed.assign(count, 0);
+
+    // Refile in the old order so every lane stays nearly sorted
+    for (int l = 0; l < laneCount; l++)
+    {
+        next[l].clear();
+    }
+    for (int l = 0; l < laneCount; l++)
+    {
+        for (size_t k = 0; k < lanes[l].size(); k++)
+            file(entities, lanes[l][k]);
+    }
+    for (size_t k = 0; k < placed.size(); k++)
+        file(entities, placed[k]);
+    placed.clear();
+    placedLane.clear();
+    placedZ.clear();
+    lanes.swap(next);
+
+    for (int l = 0; l < laneCount; l++)
+    {
+        std::vector<int> &queue = lanes[l];
+        std::vector<float> &zs = laneZ[l];
+        zs.resize(queue.size());
+        for (size_t k = 0; k < queue.size(); k++)
+            zs[k] = entities.transforms.get(entities.drivers.entity(queue[k])).z;
+
+        // Insertion sort, cars rarely pass each other
+        for (size_t k = 1; k < queue.size(); k++)
+        {
+            int driver = queue[k];
+            float z = zs[k];
+            size_t j = k;
+            while (j > 0 && zs[j - 1] > z)
+            {
+                queue[j] = queue[j - 1];
+                zs[j] = zs[j - 1];
+                j--;
+            }
+            queue[j] = driver;
+            zs[j] = z;
+        }
+
+        for (size_t k = 0; k + 1 < queue.size(); k++)
+            leaders[queue[k]] = queue[k + 1];
+
+        // The player leads whoever is right behind them
+        if (playerInLane(l, tick))
+        {
+            int behind = findFollower(l, tick.playerZ);
+            if (behind >= 0)
+                leaders[queue[behind]] = PLAYER_LEADER;
+        }
+    }
+}
+
+void TrafficSystem::file(Registry &entities, int driver)
+{
+    if (filed[driver] || !entities.isActive(entities.drivers.entity(driver)))
+        return;
+
+    const AIDriver &ai = entities.drivers[driver];
+    if (ai.isMovingAside)
+        return; // Leaving the road, no longer anyone's leader
+
+    filed[driver] = 1;
+    next[ai.lane].push_back(driver);
+}
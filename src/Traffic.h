@@ -0,0 +1,107 @@
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#include "JobSystem.h"
+#include "Registry.h"
+#include <vector>
+
+// Car-following model tuning, in metres and seconds.
+// IDM: a = maxAccel * (1 - (v / v0)^4 - (s* / s)^2),
+//      s* = minGap + v * headway + v * dv / (2 * sqrt(maxAccel * comfortDecel))
+// Lane changes follow MOBIL: change when the gain for this car, minus
+// politeness times the loss for the new follower, beats changeThreshold,
+// and the new follower never has to brake harder than safeDecel.
+struct IdmParams
+{
+    IdmParams()
+        : maxAccel(1.5f), comfortDecel(3.0f), minGap(2.0f), headway(1.0f), politeness(0.2f),
+          changeThreshold(0.3f), safeDecel(4.0f), changeSeconds(1.5f), cooldownSeconds(3.0f) {}
+
+    float maxAccel;
+    float comfortDecel;
+    float minGap;
+    float headway;
+    float politeness;
+    float changeThreshold;
+    float safeDecel;
+    float changeSeconds;   // Time to slide one lane over
+    float cooldownSeconds; // Minimum time between lane changes of one car
+};
+
+// Player inputs of one traffic tick
+struct TrafficTick
+{
+    float playerX, playerZ;
+    float playerSpeed; // Units per tick along +z
+    float playerSize;  // Half extent of the player's box
+    bool justFlashed;  // Headlights flashed this tick, cars just ahead pull aside
+    bool moveTraffic;
+};
+
+// Lane based traffic over the AIDriver entities of a Registry.
+// Every lane keeps its cars sorted by z, so a car's leader is simply the
+// next car in its lane and is found in O(1). A tick is two parallel passes
+// over the drivers (decide, then move) around a short serial pass that
+// commits lane changes, and the lanes are re-sorted afterwards with an
+// insertion sort, which is linear because the order barely changes.
+class TrafficSystem
+{
+public:
+    TrafficSystem();
+
+    // Lanes of laneWidth across a road of roadWidth centred on x = 0
+    void configure(float roadWidth, float laneWidth);
+    void setParams(const IdmParams &params) { idm = params; }
+    void clear();
+
+    int getLaneCount() const { return laneCount; }
+    float laneCenter(int lane) const { return (lane + 0.5f) * laneWidth - laneCount * laneWidth / 2; }
+
+    // True if no car in the lane is within clearance of z, including cars placed this tick
+    bool isClear(int lane, float z, float clearance) const;
+
+    // Puts an inactive driver (dense index into entities.drivers) on the road
+    void place(Registry &entities, int driver, int lane, float z, float speed);
+
+    // Moves every active driver and returns true if one hits the player
+    bool update(Registry &entities, const TrafficTick &tick, JobSystem *jobs);
+
+    // Drops inactive cars from the lanes, files placed and lane-changing cars
+    // into their new lanes and re-sorts. Call after update() and place().
+    void rebuild(Registry &entities, const TrafficTick &tick);
+
+private:
+    static const int NO_LEADER = -1;
+    static const int PLAYER_LEADER = -2;
+    static const int DRIVER_GRAIN = 512;
+
+    IdmParams idm;
+    float roadWidth;
+    float laneWidth;
+    int laneCount;
+    uint32_t tickCount;
+
+    std::vector<std::vector<int>> lanes;  // Driver indices sorted by z, back is the front of the queue
+    std::vector<std::vector<float>> laneZ; // z of each entry at the last rebuild, for binary searches
+    std::vector<int> placed;               // Drivers placed since the last rebuild, with their lane and z
+    std::vector<int> placedLane;
+    std::vector<float> placedZ;
+    std::vector<std::vector<int>> next;    // Lanes being rebuilt
+    std::vector<unsigned char> filed;      // Per driver, already in next
+    std::vector<int> leaders;              // Per driver, NO_LEADER, PLAYER_LEADER or a driver index
+    std::vector<float> accel;              // Per driver, m/s^2 from the decide pass
+    std::vector<int> wantLane;             // Per driver, lane change proposal from the decide pass
+    std::vector<float> changers;           // z, lane pairs of lane changes committed this tick
+
+    float idmAccel(float v, float desired, float gap, float leaderV) const;
+    float accelBehind(const Registry &entities, float v, float desired, float z, float length, int leader,
+                      const TrafficTick &tick) const;
+    int findFollower(int lane, float z) const;
+    bool playerInLane(int lane, const TrafficTick &tick) const;
+    void file(Registry &entities, int driver);
+    void decide(Registry &entities, int first, int last, const TrafficTick &tick);
+    bool move(Registry &entities, int first, int last, const TrafficTick &tick);
+    void commitLaneChanges(Registry &entities);
+};
+
+#endif
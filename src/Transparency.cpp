@@ -0,0 +1,119 @@
+#include "Transparency.h"
+#include "GLExtensions.h"
+#include "Lighting.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+std::vector<Transparency::Beam> Transparency::beams;
+std::vector<float> Transparency::vertices;
+
+// Unit cone as triangles, like glutSolidCone(1, 1): base ring at z = 0, tip
+// at z = 1. The sides and the base disk, a vertex of each is 3 floats.
+static const int CONE_VERTICES = Transparency::BEAM_SLICES * 6;
+static float cone[CONE_VERTICES][3];
+static bool coneBuilt = false;
+
+static void buildCone()
+{
+    int n = 0;
+    for (int i = 0; i < Transparency::BEAM_SLICES; i++)
+    {
+        float a0 = 2.0f * M_PI * i / Transparency::BEAM_SLICES;
+        float a1 = 2.0f * M_PI * (i + 1) / Transparency::BEAM_SLICES;
+        float ring[2][3] = {{cosf(a0), sinf(a0), 0.0f}, {cosf(a1), sinf(a1), 0.0f}};
+        const float tip[3] = {0.0f, 0.0f, 1.0f};
+        const float centre[3] = {0.0f, 0.0f, 0.0f};
+        const float *corners[6] = {ring[0], ring[1], tip, ring[1], ring[0], centre};
+        for (int c = 0; c < 6; c++, n++)
+            for (int k = 0; k < 3; k++)
+                cone[n][k] = corners[c][k];
+    }
+    coneBuilt = true;
+}
+
+void Transparency::addBeam(float radius, float length, const float color[4])
+{
+    float modelview[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+
+    // modelview * translate(0, 0, length) * scale(radius, radius, -length)
+    // flips the unit cone so its tip is at the origin
+    Beam beam;
+    for (int row = 0; row < 4; row++)
+    {
+        beam.matrix[row] = modelview[row] * radius;
+        beam.matrix[4 + row] = modelview[4 + row] * radius;
+        beam.matrix[8 + row] = -modelview[8 + row] * length;
+        beam.matrix[12 + row] = modelview[8 + row] * length + modelview[12 + row];
+    }
+    for (int k = 0; k < 4; k++)
+        beam.color[k] = color[k];
+    beam.depth = modelview[10] * length * 0.5f + modelview[14];
+    beams.push_back(beam);
+}
+
+// Eye space looks down -z, the most negative depth is the farthest
+bool Transparency::fartherFirst(const Beam &a, const Beam &b)
+{
+    return a.depth < b.depth;
+}
+
+void Transparency::draw()
+{
+    if (beams.empty())
+        return;
+    PROFILE_GPU_ZONE("Transparency::draw");
+
+    if (!coneBuilt)
+        buildCone();
+    std::stable_sort(beams.begin(), beams.end(), fartherFirst);
+
+    // Every beam in eye space, in drawing order
+    vertices.resize(beams.size() * CONE_VERTICES * 7);
+    float *out = &vertices[0];
+    for (size_t b = 0; b < beams.size(); b++)
+    {
+        const float *m = beams[b].matrix;
+        for (int v = 0; v < CONE_VERTICES; v++, out += 7)
+        {
+            const float *p = cone[v];
+            for (int row = 0; row < 3; row++)
+                out[row] = m[row] * p[0] + m[4 + row] * p[1] + m[8 + row] * p[2] + m[12 + row];
+            for (int k = 0; k < 4; k++)
+                out[3 + k] = beams[b].color[k];
+        }
+    }
+
+    bool lit = glIsEnabled(GL_LIGHTING);
+    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    Lighting::disable();
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE); // Tested against the opaque scene, hide nothing themselves
+
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 7 * sizeof(float), &vertices[0]);
+    glColorPointer(4, GL_FLOAT, 7 * sizeof(float), &vertices[3]);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(beams.size() * CONE_VERTICES));
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    glPopMatrix();
+    glPopAttrib();
+    if (lit)
+        Lighting::enable(); // glPopAttrib() turns lighting back on but not the shader
+
+    beams.clear();
+}
@@ -0,0 +1,37 @@
+#ifndef TRANSPARENCY_H
+#define TRANSPARENCY_H
+
+#include <vector>
+
+// The frame's alpha blended geometry, drawn once everything opaque is. The
+// light beams of the headlights and street lamps are queued while the opaque
+// pass draws them, each with the modelview current at the time; draw() sorts
+// them far to near and draws them all as one vertex array, with blending on,
+// depth writes and lighting off, set once for the whole batch.
+class Transparency
+{
+public:
+    static const int BEAM_SLICES = 10;
+
+    // A see-through cone of light with its tip at the origin, opening along
+    // +z to radius at length: glutSolidCone(radius, length) turned around
+    static void addBeam(float radius, float length, const float color[4]);
+
+    // After the opaque geometry of a frame; empties the queue
+    static void draw();
+
+private:
+    struct Beam
+    {
+        float matrix[16]; // Unit cone to eye space
+        float color[4];
+        float depth;      // Eye space z of the middle of the beam
+    };
+
+    static bool fartherFirst(const Beam &a, const Beam &b);
+
+    static std::vector<Beam> beams;
+    static std::vector<float> vertices; // x y z r g b a, reused every frame
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Hands the latest value from one writer thread to one reader thread
+// without either side ever waiting. The writer fills its private slot and
+// swaps it with the shared middle slot; the reader swaps the middle slot
+// into its own private slot when a fresh one is there. Old values the
+// reader never saw are simply overwritten.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : back(0), middle(1), front(2) {}
+
+    // Writer thread only
+    T &writeBuffer() { return slots[back]; }
+    void publish()
+    {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader thread only. acquire() returns false if nothing new was published.
+    bool hasNew() const { return (middle.load(std::memory_order_acquire) & FRESH) != 0; }
+    bool acquire()
+    {
+        if (!hasNew())
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T &readBuffer() const { return slots[front]; }
+
+private:
+    static const int INDEX = 3;
+    static const int FRESH = 4;
+
+    T slots[3];
+    int back;
+    std::atomic<int> middle;
+    int front;
+};
+
+#endif
@@ -1,5 +1,15 @@
 #include <GL/glut.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include "AudioOutput.h"
 #include "Game.h"
+#include "Platform.h"
+#include "TextureStreamer.h"
+#include "TraceWriter.h"
 
 Game game;
 
@@ -7,12 +17,21 @@ void display() {
     game.render();
 }
 
+// --single-thread: simulate and draw on the GLUT thread like before
 void timer(int value) {
     game.update();
     glutPostRedisplay();
     glutTimerFunc(16, timer, 0); // ~60 FPS
 }
 
+// Simulation on its own thread: redraw whenever it has published a new tick
+void idle() {
+    if (game.hasNewFrame())
+        glutPostRedisplay();
+    else
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
 void keyboard(unsigned char key, int x, int y) {
     game.handleInput(key, x, y);
 }
@@ -37,16 +56,106 @@ void reshape(int w, int h) {
     game.reshape(w, h);
 }
 
+// Steps the simulation as fast as possible until the replay ends, no rendering
+void runHeadless() {
+    double start = Platform::nowSeconds();
+    while (game.isReplaying()) {
+        game.update();
+    }
+    double seconds = Platform::nowSeconds() - start;
+
+    uint32_t ticks = game.getTick();
+    printf("Headless replay: %u ticks in %.3f s (%.1f us/tick, %.0f ticks/s)\n",
+           ticks, seconds, ticks ? seconds * 1e6 / ticks : 0.0, seconds > 0 ? ticks / seconds : 0.0);
+    fflush(stdout);
+}
+
 int main(int argc, char** argv) {
-    glutInit(&argc, argv);
-    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
-    glutInitWindowSize(800, 600);
-    glutCreateWindow("Egyptian Driving Game");
+    // Headless runs open no window, so they also work without a display
+    bool headless = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0)
+            headless = true;
+    }
+    if (!headless)
+        Platform::createWindow(&argc, argv, "Egyptian Driving Game", 800, 600);
+
+    // glutInit() has already stripped its own options from argv
+    uint64_t seed = (uint64_t)time(NULL);
+    const char *recordPath = NULL;
+    const char *replayPath = NULL;
+    const char *tracePath = NULL;
+    const char *audioPath = NULL;
+    bool noAudio = false;
+    bool singleThread = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            tracePath = argv[++i];
+        else if (strcmp(argv[i], "--audio-out") == 0 && i + 1 < argc)
+            audioPath = argv[++i];
+        else if (strcmp(argv[i], "--no-audio") == 0)
+            noAudio = true;
+        else if (strcmp(argv[i], "--single-thread") == 0)
+            singleThread = true;
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+            game.setWorkerCount(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--fixed-lighting") == 0)
+            game.setShaderLighting(false);
+        else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc)
+            TextureStreamer::setBudget((size_t)atoi(argv[++i]) << 20);
+    }
+
+    if (headless && !replayPath) {
+        printf("--headless needs --replay FILE\n");
+        return 1;
+    }
+
+    if (tracePath) {
+#if EGYPT_PROFILE
+        TraceWriter::get().start(tracePath);
+#else
+        printf("Warning: --trace needs a build with PROFILE=1\n");
+#endif
+    }
+
+    game.setSeed(seed);
+    if (replayPath && !game.replayInput(replayPath))
+        return 1;
+    if (recordPath && !replayPath)
+        game.recordInput(recordPath);
+
+    printf("Seed: %llu (pass --seed %llu to replay this traffic)\n",
+           (unsigned long long)game.getSeed(), (unsigned long long)game.getSeed());
+    fflush(stdout);
+
+    // Headless runs never touch the sound device unless asked to record the mix
+    if (audioPath)
+        game.setAudioOutput(new WavFileAudioOutput(audioPath));
+    else if (noAudio || headless)
+        game.setAudioOutput(new NullAudioOutput());
+
+    if (headless) {
+        game.initSimulation();
+        runHeadless();
+        game.shutdown();
+        return 0;
+    }
 
     game.init();
 
     glutDisplayFunc(display);
-    glutTimerFunc(0, timer, 0); // Start timer immediately
+    if (singleThread) {
+        glutTimerFunc(0, timer, 0); // Start timer immediately
+    } else {
+        game.startSimulation();
+        glutIdleFunc(idle);
+    }
     glutKeyboardFunc(keyboard);
     glutSpecialFunc(special);
     glutSpecialUpFunc(specialUp);
@@ -0,0 +1,65 @@
+#ifndef _WIN32
+
+#include "../Platform.h"
+#include "../AudioOutput.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// No audio backend yet, the mix is dropped
+AudioOutput *Platform::createAudioOutput()
+{
+    return new NullAudioOutput();
+}
+
+uint64_t Platform::nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+bool Platform::mapFile(const char *path, MappedFile &file)
+{
+    file.data = NULL;
+    file.size = 0;
+    file.handle = NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file open
+    if (view == MAP_FAILED)
+        return false;
+
+    file.data = (const unsigned char *)view;
+    file.size = (size_t)st.st_size;
+    return true;
+}
+
+void Platform::unmapFile(MappedFile &file)
+{
+    if (file.data)
+        munmap((void *)file.data, file.size);
+    file.data = NULL;
+    file.size = 0;
+    file.handle = NULL;
+}
+
+const char *Platform::name()
+{
+    return "POSIX";
+}
+
+#endif
@@ -0,0 +1,160 @@
+#ifdef _WIN32
+
+#include "../Platform.h"
+#include "../AudioOutput.h"
+#include <windows.h>
+#include <mmsystem.h>
+#include <string.h>
+#include <vector>
+
+// waveOut with a small ring of buffers, write() waits for the oldest to finish
+class WaveOutAudioOutput : public AudioOutput
+{
+public:
+    WaveOutAudioOutput()
+    {
+        device = NULL;
+        next = 0;
+        channels = 1;
+        memset(headers, 0, sizeof(headers));
+    }
+    ~WaveOutAudioOutput() { close(); }
+
+    bool open(int sampleRate, int channelCount)
+    {
+        channels = channelCount;
+
+        WAVEFORMATEX format;
+        memset(&format, 0, sizeof(format));
+        format.wFormatTag = WAVE_FORMAT_PCM;
+        format.nChannels = (WORD)channels;
+        format.nSamplesPerSec = sampleRate;
+        format.wBitsPerSample = 16;
+        format.nBlockAlign = (WORD)(channels * 2);
+        format.nAvgBytesPerSec = sampleRate * format.nBlockAlign;
+
+        return waveOutOpen(&device, WAVE_MAPPER, &format, 0, 0, CALLBACK_NULL) == MMSYSERR_NOERROR;
+    }
+
+    void write(const int16_t *samples, int frames)
+    {
+        WAVEHDR &header = headers[next];
+        next = (next + 1) % BUFFERS;
+
+        if (header.dwFlags & WHDR_PREPARED)
+        {
+            volatile DWORD *flags = &header.dwFlags; // Set by the driver
+            while (!(*flags & WHDR_DONE))
+                Sleep(1);
+            waveOutUnprepareHeader(device, &header, sizeof(header));
+        }
+
+        std::vector<int16_t> &buffer = buffers[&header - headers];
+        buffer.assign(samples, samples + frames * channels);
+
+        memset(&header, 0, sizeof(header));
+        header.lpData = (LPSTR)&buffer[0];
+        header.dwBufferLength = (DWORD)(buffer.size() * sizeof(int16_t));
+        waveOutPrepareHeader(device, &header, sizeof(header));
+        waveOutWrite(device, &header, sizeof(header));
+    }
+
+    void close()
+    {
+        if (!device)
+            return;
+
+        waveOutReset(device);
+        for (int i = 0; i < BUFFERS; i++)
+        {
+            if (headers[i].dwFlags & WHDR_PREPARED)
+                waveOutUnprepareHeader(device, &headers[i], sizeof(headers[i]));
+        }
+        waveOutClose(device);
+        device = NULL;
+    }
+
+    const char *name() const { return "waveOut"; }
+
+private:
+    static const int BUFFERS = 4;
+
+    HWAVEOUT device;
+    WAVEHDR headers[BUFFERS];
+    std::vector<int16_t> buffers[BUFFERS];
+    int next;
+    int channels;
+};
+
+AudioOutput *Platform::createAudioOutput()
+{
+    return new WaveOutAudioOutput();
+}
+
+uint64_t Platform::nowNs()
+{
+    static LARGE_INTEGER frequency;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    // Split to avoid overflowing counter * 1e9
+    uint64_t seconds = counter.QuadPart / frequency.QuadPart;
+    uint64_t rest = counter.QuadPart % frequency.QuadPart;
+    return seconds * 1000000000ULL + rest * 1000000000ULL / frequency.QuadPart;
+}
+
+bool Platform::mapFile(const char *path, MappedFile &file)
+{
+    file.data = NULL;
+    file.size = 0;
+    file.handle = NULL;
+
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(handle);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle); // The mapping keeps the file open
+    if (!mapping)
+        return false;
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    file.data = (const unsigned char *)view;
+    file.size = (size_t)size.QuadPart;
+    file.handle = mapping;
+    return true;
+}
+
+void Platform::unmapFile(MappedFile &file)
+{
+    if (file.data)
+        UnmapViewOfFile(file.data);
+    if (file.handle)
+        CloseHandle((HANDLE)file.handle);
+    file.data = NULL;
+    file.size = 0;
+    file.handle = NULL;
+}
+
+const char *Platform::name()
+{
+    return "Win32";
+}
+
+#endif
@@ -0,0 +1,211 @@
+// Compiles a text level description (levels/*.lvl) into the binary .lvb
+// the game loads, see src/LevelData.h for the layout.
+//
+// The text format is one "key values..." line per setting, '#' starts a
+// comment. Settings that are left out keep the built-in defaults, so a
+// level only lists what it changes:
+//
+//   level road|parking
+//
+//   road_width W            road_length L
+//   lane_width W
+//   buildings SPACING GAP WIDTH LENGTH HEIGHT
+//   lamps SPACING PHASE GAP
+//   finish Z
+//   traffic SLOTS           spawn_chance PERCENT
+//   car_speed MIN STEPS     spawn_ahead DISTANCE WINDOW
+//   powerups COUNT          powerup_chance ONE_IN
+//   powerup_ahead DISTANCE WINDOW
+//
+//   lot HALF_SIZE           spot X Z WIDTH LENGTH
+//   park_time SECONDS       park_speed MAX_SPEED
+//   cone X Z [WIDTH LENGTH]     person X Z [WIDTH LENGTH]
+//   box X Z WIDTH LENGTH
+//
+// The compiler only depends on LevelData.h, it does not link the game.
+#include "LevelData.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static bool parseLine(const char *key, const char *args, LevelData &level)
+{
+    RoadDesc &road = level.road;
+    ParkingDesc &lot = level.parking;
+    char word[32];
+    int n = 0;
+
+    if (strcmp(key, "level") == 0)
+    {
+        if (sscanf(args, "%31s", word) != 1)
+            return false;
+        if (strcmp(word, "road") == 0)
+            level.kind = LEVEL_ROAD;
+        else if (strcmp(word, "parking") == 0)
+            level.kind = LEVEL_PARKING;
+        else
+            return false;
+        return true;
+    }
+
+    // Road
+    if (strcmp(key, "road_width") == 0)
+        return sscanf(args, "%f", &road.width) == 1 && road.width > 0.0f;
+    if (strcmp(key, "road_length") == 0)
+        return sscanf(args, "%f", &road.length) == 1 && road.length > 0.0f;
+    if (strcmp(key, "lane_width") == 0)
+        return sscanf(args, "%f", &road.laneWidth) == 1 && road.laneWidth > 0.0f;
+    // The game steps along the road by these spacings, zero would never end
+    if (strcmp(key, "buildings") == 0)
+        return sscanf(args, "%f %f %f %f %f", &road.buildingSpacing, &road.buildingGap, &road.buildingWidth,
+                      &road.buildingLength, &road.buildingHeight) == 5 &&
+               road.buildingSpacing > 0.0f && road.buildingWidth > 0.0f && road.buildingLength > 0.0f;
+    if (strcmp(key, "lamps") == 0)
+        return sscanf(args, "%f %f %f", &road.lampSpacing, &road.lampPhase, &road.lampGap) == 3 &&
+               road.lampSpacing > 0.0f;
+    if (strcmp(key, "finish") == 0)
+        return sscanf(args, "%f", &road.finishZ) == 1;
+    // Counts size arrays and the rest bound random draws, see isValidRoad()
+    if (strcmp(key, "traffic") == 0)
+        return sscanf(args, "%d", &road.trafficSize) == 1 && road.trafficSize >= 0;
+    if (strcmp(key, "spawn_chance") == 0)
+        return sscanf(args, "%d", &road.traffic.spawnChance) == 1;
+    if (strcmp(key, "car_speed") == 0)
+        return sscanf(args, "%f %d", &road.traffic.minSpeed, &road.traffic.speedSteps) == 2 &&
+               road.traffic.speedSteps > 0;
+    if (strcmp(key, "spawn_ahead") == 0)
+        return sscanf(args, "%d %d", &road.traffic.spawnAhead, &road.traffic.spawnWindow) == 2 &&
+               road.traffic.spawnWindow > 0;
+    if (strcmp(key, "powerups") == 0)
+        return sscanf(args, "%d", &road.powerupCount) == 1 && road.powerupCount >= 0;
+    if (strcmp(key, "powerup_chance") == 0)
+        return sscanf(args, "%d", &road.traffic.powerupChance) == 1 && road.traffic.powerupChance > 0;
+    if (strcmp(key, "powerup_ahead") == 0)
+        return sscanf(args, "%d %d", &road.traffic.powerupAhead, &road.traffic.powerupWindow) == 2 &&
+               road.traffic.powerupWindow > 0;
+
+    // Parking lot
+    if (strcmp(key, "lot") == 0)
+        return sscanf(args, "%f", &lot.lotHalfSize) == 1;
+    if (strcmp(key, "spot") == 0)
+        return sscanf(args, "%f %f %f %f", &lot.spotX, &lot.spotZ, &lot.spotWidth, &lot.spotLength) == 4;
+    if (strcmp(key, "park_time") == 0)
+        return sscanf(args, "%f", &lot.parkSeconds) == 1;
+    if (strcmp(key, "park_speed") == 0)
+        return sscanf(args, "%f", &lot.parkSpeed) == 1;
+
+    // Static colliders
+    LevelCollider collider;
+    if (strcmp(key, "cone") == 0)
+    {
+        collider.kind = COLLIDER_CONE;
+        collider.width = collider.length = 0.5f;
+    }
+    else if (strcmp(key, "person") == 0)
+    {
+        collider.kind = COLLIDER_PERSON;
+        collider.width = collider.length = 0.8f;
+    }
+    else if (strcmp(key, "box") == 0)
+    {
+        collider.kind = COLLIDER_BOX;
+    }
+    else
+    {
+        return false;
+    }
+
+    n = sscanf(args, "%f %f %f %f", &collider.x, &collider.z, &collider.width, &collider.length);
+    if (n != 4 && (n != 2 || collider.kind == COLLIDER_BOX))
+        return false;
+    level.colliders.push_back(collider);
+    return true;
+}
+
+static bool compile(const char *inPath, LevelData &level)
+{
+    FILE *file = fopen(inPath, "r");
+    if (!file)
+    {
+        fprintf(stderr, "Error: could not open %s\n", inPath);
+        return false;
+    }
+
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), file))
+    {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment)
+            *comment = '\0';
+
+        char key[32];
+        int used = 0;
+        if (sscanf(line, "%31s%n", key, &used) != 1)
+            continue; // Blank line
+
+        if (!parseLine(key, line + used, level))
+        {
+            fprintf(stderr, "%s:%d: bad line '%s'\n", inPath, lineNumber, key);
+            ok = false;
+        }
+    }
+    fclose(file);
+
+    if (ok && level.kind == 0)
+    {
+        fprintf(stderr, "%s: missing 'level road' or 'level parking'\n", inPath);
+        ok = false;
+    }
+    return ok;
+}
+
+static bool write(const char *outPath, const LevelData &level)
+{
+    FILE *file = fopen(outPath, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Error: could not write %s\n", outPath);
+        return false;
+    }
+
+    LevelFileHeader header;
+    memcpy(header.magic, LEVEL_FILE_MAGIC, 4);
+    header.version = LEVEL_FILE_VERSION;
+    header.kind = level.kind;
+    header.colliderCount = (uint32_t)level.colliders.size();
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(&level.road, sizeof(level.road), 1, file) == 1;
+    ok = ok && fwrite(&level.parking, sizeof(level.parking), 1, file) == 1;
+    if (!level.colliders.empty())
+        ok = ok && fwrite(&level.colliders[0], sizeof(LevelCollider), level.colliders.size(), file) ==
+                       level.colliders.size();
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok)
+        fprintf(stderr, "Error: could not write %s\n", outPath);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        printf("Usage: %s LEVEL.lvl LEVEL.lvb\n", argv[0]);
+        return 1;
+    }
+
+    LevelData level;
+    if (!compile(argv[1], level) || !write(argv[2], level))
+    {
+        remove(argv[2]);
+        return 1;
+    }
+
+    printf("%s: %s level, %u colliders\n", argv[2], level.kind == LEVEL_ROAD ? "road" : "parking",
+           (unsigned)level.colliders.size());
+    return 0;
+}
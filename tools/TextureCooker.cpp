@@ -0,0 +1,291 @@
+// Cooks a texture (.bmp, .tga, .png or .jpg) into a block compressed .dds
+// with its full mip chain, see src/TextureFile.h for the layout.
+//
+//   EgyptainTextureCooker [--bc1 | --bc3 | --bc5] INPUT OUTPUT.dds
+//
+// Without a format the cooker picks BC5 for normal maps (files with
+// "normal" in the name), BC3 for images with any transparency and BC1 for
+// everything else. Mips are box filtered; normal map mips are renormalized.
+#include "BlockCompression.h"
+#include "ImageDecoder.h"
+#include "PixelConvert.h"
+#include "TextureFile.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static_assert(sizeof(DdsHeader) == 128, "DdsHeader layout changed");
+
+static bool readFile(const char *path, std::vector<unsigned char> &data)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+    unsigned char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        data.insert(data.end(), chunk, chunk + n);
+    fclose(file);
+    return true;
+}
+
+// Uncompressed 24 or 32-bit BMP, rows stay bottom first
+static bool decodeBMP(const std::vector<unsigned char> &data, DecodedImage &image)
+{
+    if (data.size() < 54 || data[0] != 'B' || data[1] != 'M')
+        return false;
+    unsigned offset = data[10] | data[11] << 8 | data[12] << 16 | (unsigned)data[13] << 24;
+    int width = data[18] | data[19] << 8 | data[20] << 16 | data[21] << 24;
+    int height = data[22] | data[23] << 8 | data[24] << 16 | data[25] << 24;
+    int bits = data[28] | data[29] << 8;
+    int compression = data[30];
+    if ((bits != 24 && bits != 32) || compression != 0 || width <= 0 || height <= 0)
+        return false;
+
+    int bytes = bits / 8;
+    size_t rowSize = ((size_t)width * bytes + 3) & ~(size_t)3;
+    if (offset + rowSize * height > data.size())
+        return false;
+
+    image.width = width;
+    image.height = height;
+    image.channels = bytes;
+    image.pixels.resize((size_t)width * height * bytes);
+    PixelConvert::swapRedBlueRows(&data[offset], rowSize, &image.pixels[0], width, height, bytes, false);
+    return true;
+}
+
+// Uncompressed 24 or 32-bit TGA, bottom row first like GLTexture::LoadTGA
+static bool decodeTGA(const std::vector<unsigned char> &data, DecodedImage &image)
+{
+    if (data.size() < 18 || data[2] != 2)
+        return false;
+    int width = data[12] | data[13] << 8, height = data[14] | data[15] << 8;
+    int bits = data[16];
+    if ((bits != 24 && bits != 32) || width <= 0 || height <= 0)
+        return false;
+
+    int bytes = bits / 8;
+    size_t offset = 18 + data[0];
+    size_t size = (size_t)width * height * bytes;
+    if (offset + size > data.size())
+        return false;
+
+    image.width = width;
+    image.height = height;
+    image.channels = bytes;
+    image.pixels.resize(size);
+    PixelConvert::swapRedBlueRows(&data[offset], (size_t)width * bytes, &image.pixels[0], width, height, bytes,
+                                  (data[17] & 0x20) != 0);
+    return true;
+}
+
+// Any decoded image to RGBA, bottom row first
+static bool loadRGBA(const char *path, std::vector<unsigned char> &rgba, int &width, int &height)
+{
+    std::vector<unsigned char> data;
+    if (!readFile(path, data) || data.empty())
+    {
+        fprintf(stderr, "Error: could not open %s\n", path);
+        return false;
+    }
+
+    DecodedImage image;
+    bool topFirst = true;
+    bool ok;
+    if (data[0] == 'B')
+    {
+        ok = decodeBMP(data, image);
+        topFirst = false;
+    }
+    else if (data[0] == 0x89)
+        ok = ImageDecoder::decodePNG(&data[0], data.size(), image);
+    else if (data[0] == 0xFF)
+        ok = ImageDecoder::decodeJPEG(&data[0], data.size(), image);
+    else
+    {
+        ok = decodeTGA(data, image);
+        topFirst = false;
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "Error: could not decode %s\n", path);
+        return false;
+    }
+
+    width = image.width;
+    height = image.height;
+    rgba.resize((size_t)width * height * 4);
+    for (int y = 0; y < height; y++)
+    {
+        int sourceRow = topFirst ? height - 1 - y : y;
+        const unsigned char *src = &image.pixels[(size_t)sourceRow * width * image.channels];
+        unsigned char *dst = &rgba[(size_t)y * width * 4];
+        for (int x = 0; x < width; x++, src += image.channels, dst += 4)
+        {
+            switch (image.channels)
+            {
+            case 1:
+                dst[0] = dst[1] = dst[2] = src[0];
+                dst[3] = 255;
+                break;
+            case 2:
+                dst[0] = dst[1] = dst[2] = src[0];
+                dst[3] = src[1];
+                break;
+            case 3:
+                memcpy(dst, src, 3);
+                dst[3] = 255;
+                break;
+            default:
+                memcpy(dst, src, 4);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+// Next mip: the average of each 2x2 (the last row or column repeats on odd sizes)
+static void downsample(const std::vector<unsigned char> &src, int width, int height, bool normalMap,
+                       std::vector<unsigned char> &dst, int &dstWidth, int &dstHeight)
+{
+    dstWidth = width > 1 ? width / 2 : 1;
+    dstHeight = height > 1 ? height / 2 : 1;
+    dst.resize((size_t)dstWidth * dstHeight * 4);
+    for (int y = 0; y < dstHeight; y++)
+    {
+        int y0 = y * 2, y1 = y0 + 1 < height ? y0 + 1 : y0;
+        for (int x = 0; x < dstWidth; x++)
+        {
+            int x0 = x * 2, x1 = x0 + 1 < width ? x0 + 1 : x0;
+            const unsigned char *p[4] = {&src[((size_t)y0 * width + x0) * 4], &src[((size_t)y0 * width + x1) * 4],
+                                         &src[((size_t)y1 * width + x0) * 4], &src[((size_t)y1 * width + x1) * 4]};
+            unsigned char *out = &dst[((size_t)y * dstWidth + x) * 4];
+            for (int c = 0; c < 4; c++)
+                out[c] = (unsigned char)((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4);
+
+            if (normalMap)
+            {
+                float n[3], length = 0;
+                for (int c = 0; c < 3; c++)
+                {
+                    n[c] = out[c] / 127.5f - 1.0f;
+                    length += n[c] * n[c];
+                }
+                length = sqrtf(length);
+                if (length > 1e-6f)
+                {
+                    for (int c = 0; c < 3; c++)
+                        out[c] = (unsigned char)(n[c] / length * 127.5f + 127.5f);
+                }
+            }
+        }
+    }
+}
+
+static bool containsNoCase(const char *text, const char *word)
+{
+    for (; *text; text++)
+    {
+        size_t i = 0;
+        while (word[i] && tolower((unsigned char)text[i]) == word[i])
+            i++;
+        if (!word[i])
+            return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t fourCC = 0;
+    int arg = 1;
+    if (arg < argc && argv[arg][0] == '-')
+    {
+        if (strcmp(argv[arg], "--bc1") == 0)
+            fourCC = DDS_FOURCC_DXT1;
+        else if (strcmp(argv[arg], "--bc3") == 0)
+            fourCC = DDS_FOURCC_DXT5;
+        else if (strcmp(argv[arg], "--bc5") == 0)
+            fourCC = DDS_FOURCC_ATI2;
+        arg++;
+    }
+    if (argc - arg != 2 || (arg == 2 && fourCC == 0))
+    {
+        printf("Usage: %s [--bc1 | --bc3 | --bc5] INPUT OUTPUT.dds\n", argv[0]);
+        return 1;
+    }
+    const char *inPath = argv[arg], *outPath = argv[arg + 1];
+
+    std::vector<unsigned char> level;
+    int width, height;
+    if (!loadRGBA(inPath, level, width, height))
+        return 1;
+
+    bool normalMap = containsNoCase(inPath, "normal");
+    if (fourCC == 0)
+    {
+        fourCC = DDS_FOURCC_DXT1;
+        if (normalMap)
+            fourCC = DDS_FOURCC_ATI2;
+        else
+        {
+            for (size_t i = 3; i < level.size(); i += 4)
+                if (level[i] != 255)
+                {
+                    fourCC = DDS_FOURCC_DXT5;
+                    break;
+                }
+        }
+    }
+    normalMap = fourCC == DDS_FOURCC_ATI2;
+
+    DdsHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = DDS_MAGIC;
+    header.size = sizeof(header) - 4;
+    header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    header.width = width;
+    header.height = height;
+    header.linearSize = (uint32_t)ddsLevelSize(width, height, ddsBlockBytes(fourCC));
+    header.pixelFormat.size = sizeof(DdsPixelFormat);
+    header.pixelFormat.flags = DDPF_FOURCC;
+    header.pixelFormat.fourCC = fourCC;
+    header.caps = DDSCAPS_TEXTURE | DDSCAPS_MIPMAP | DDSCAPS_COMPLEX;
+
+    std::vector<uint8_t> blocks;
+    std::vector<unsigned char> next;
+    size_t rawBytes = 0;
+    int levelWidth = width, levelHeight = height;
+    for (;;)
+    {
+        BlockCompression::compress(&level[0], levelWidth, levelHeight, fourCC, blocks);
+        rawBytes += level.size();
+        header.mipMapCount++;
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+        downsample(level, levelWidth, levelHeight, normalMap, next, levelWidth, levelHeight);
+        level.swap(next);
+    }
+
+    FILE *file = fopen(outPath, "wb");
+    bool ok = file && fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(&blocks[0], 1, blocks.size(), file) == blocks.size();
+    if (file)
+        ok = fclose(file) == 0 && ok;
+    if (!ok)
+    {
+        fprintf(stderr, "Error: could not write %s\n", outPath);
+        remove(outPath);
+        return 1;
+    }
+
+    const char *name = fourCC == DDS_FOURCC_DXT1 ? "BC1" : fourCC == DDS_FOURCC_DXT5 ? "BC3" : "BC5";
+    printf("%s: %dx%d %s, %u mips, %u KB (%u KB as RGBA)\n", outPath, width, height, name, header.mipMapCount,
+           (unsigned)((sizeof(header) + blocks.size()) / 1024), (unsigned)(rawBytes / 1024));
+    return 0;
+}
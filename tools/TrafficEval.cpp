@@ -0,0 +1,412 @@
+// Batch Monte-Carlo evaluation of Level1 traffic difficulty.
+//
+// Runs many independent seeded Level1 episodes with a scripted driver for
+// every combination of the traffic parameters given on the command line,
+// spread over all cores, and reports crash rate, time to finish and
+// power-up usage per parameter set. Each episode owns its Level1, Car and
+// random stream, so episodes share nothing and results only depend on the
+// seeds, not on the number of threads.
+#include "JobSystem.h"
+#include "Level1.h"
+#include "Platform.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static const float TICK_SECONDS = 0.016f; // Game ticks are 16 ms
+static const float LOOKAHEAD = 25.0f;     // How far ahead the driver watches traffic
+static const float ROAD_LIMIT = 8.0f;     // Keep |x| below this, lamp posts are further out
+
+struct EpisodeResult
+{
+    bool crashed;
+    bool finished;
+    int ticks;
+    int pickups[2];
+};
+
+struct ParamSet
+{
+    TrafficParams traffic;
+    std::vector<EpisodeResult> results;
+};
+
+struct Options
+{
+    int episodes;
+    uint64_t seed;
+    int workers;
+    int maxTicks;
+    int trafficSize;
+    const char *csvPath;
+    LevelData level; // Road layout and the traffic values not being swept
+    std::vector<int> spawnChance;
+    std::vector<float> minSpeed;
+    std::vector<int> spawnAhead;
+    std::vector<int> powerupChance;
+};
+
+//////////////////////////////////////////////////////////////////////
+// Scripted driver
+//////////////////////////////////////////////////////////////////////
+
+// Full throttle. Steers around the nearest car ahead in its lane, towards
+// the side with more road, and flashes its lights when one gets close.
+class ScriptedDriver
+{
+public:
+    ScriptedDriver() : flashTicks(0) {}
+
+    void drive(Car &car, const Level1 &level)
+    {
+        float x = car.getX();
+        float z = car.getZ();
+
+        const Transform *threat = NULL;
+        float nearest = LOOKAHEAD;
+        const Registry &entities = level.getEntities();
+        for (size_t i = 0; i < entities.drivers.size(); i++)
+        {
+            Entity e = entities.drivers.entity(i);
+            const Transform &obs = entities.transforms.get(e);
+            float dz = obs.z - z;
+            if (entities.isActive(e) && dz > -2.0f && dz < nearest && fabsf(obs.x - x) < 3.0f)
+            {
+                threat = &obs;
+                nearest = dz;
+            }
+        }
+
+        float targetX = x;
+        if (threat)
+        {
+            // Dodge to whichever side of the threat has more room
+            targetX = threat->x >= 0.0f ? threat->x - 4.0f : threat->x + 4.0f;
+            if (nearest < 12.0f && flashTicks == 0 && car.isLightsOn())
+                flashTicks = 30;
+        }
+        else if (fabsf(x) > ROAD_LIMIT - 2.0f)
+        {
+            targetX = 0.0f; // Drift back to the middle
+        }
+        targetX = std::max(-ROAD_LIMIT, std::min(ROAD_LIMIT, targetX));
+
+        // Heading proportional to the lateral error, left (+rotation) moves towards +x
+        float desired = std::max(-25.0f, std::min(25.0f, (targetX - x) * 8.0f));
+        float rotation = car.getRotation();
+        car.turnLeft(rotation < desired - 1.0f);
+        car.turnRight(rotation > desired + 1.0f);
+        car.accelerate(true);
+
+        // Lights off for one tick then back on, Level1 reacts to the rising edge
+        if (flashTicks == 30 || flashTicks == 29)
+            car.toggleLights();
+        if (flashTicks > 0)
+            flashTicks--;
+    }
+
+private:
+    int flashTicks;
+};
+
+static EpisodeResult runEpisode(const TrafficParams &traffic, uint64_t seed, const Options &options)
+{
+    Level1 level;
+    level.setSeed(seed);
+    level.setLevelData(options.level);
+    level.setTrafficSize(options.trafficSize);
+    level.setTrafficParams(traffic);
+    level.init();
+
+    Car car;
+    ScriptedDriver driver;
+
+    EpisodeResult result;
+    result.crashed = false;
+    result.finished = false;
+    result.ticks = options.maxTicks;
+
+    for (int tick = 0; tick < options.maxTicks; tick++)
+    {
+        driver.drive(car, level);
+        car.update();
+        level.update();
+
+        if (level.checkCollisions(car))
+        {
+            result.crashed = true;
+            result.ticks = tick + 1;
+            break;
+        }
+        if (level.isFinished(car))
+        {
+            result.finished = true;
+            result.ticks = tick + 1;
+            break;
+        }
+    }
+
+    result.pickups[0] = level.getPickupCount(0);
+    result.pickups[1] = level.getPickupCount(1);
+    return result;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Reporting
+//////////////////////////////////////////////////////////////////////
+
+struct Summary
+{
+    float crashRate;
+    float finishRate;
+    float timeoutRate;
+    float meanSeconds; // Time to finish, finished episodes only
+    float p10, p50, p90;
+    float noTrafficPerEpisode;
+    float boostPerEpisode;
+};
+
+static float percentile(const std::vector<float> &sorted, float p)
+{
+    if (sorted.empty())
+        return 0.0f;
+    size_t n = (size_t)(p / 100.0f * (sorted.size() - 1) + 0.5f);
+    return sorted[n];
+}
+
+static Summary summarize(const ParamSet &set)
+{
+    Summary s;
+    int crashed = 0, finished = 0, noTraffic = 0, boost = 0;
+    std::vector<float> times;
+
+    for (size_t i = 0; i < set.results.size(); i++)
+    {
+        const EpisodeResult &r = set.results[i];
+        crashed += r.crashed;
+        finished += r.finished;
+        noTraffic += r.pickups[0];
+        boost += r.pickups[1];
+        if (r.finished)
+            times.push_back(r.ticks * TICK_SECONDS);
+    }
+    std::sort(times.begin(), times.end());
+
+    float n = (float)set.results.size();
+    s.crashRate = crashed / n;
+    s.finishRate = finished / n;
+    s.timeoutRate = 1.0f - s.crashRate - s.finishRate;
+    s.meanSeconds = 0.0f;
+    for (size_t i = 0; i < times.size(); i++)
+        s.meanSeconds += times[i];
+    if (!times.empty())
+        s.meanSeconds /= times.size();
+    s.p10 = percentile(times, 10.0f);
+    s.p50 = percentile(times, 50.0f);
+    s.p90 = percentile(times, 90.0f);
+    s.noTrafficPerEpisode = noTraffic / n;
+    s.boostPerEpisode = boost / n;
+    return s;
+}
+
+static void writeCsv(const char *path, const std::vector<ParamSet> &sets)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "Error: could not write %s\n", path);
+        return;
+    }
+
+    fprintf(file, "spawn_chance,min_speed,speed_steps,spawn_ahead,spawn_window,powerup_chance,episodes,"
+                  "crash_rate,finish_rate,timeout_rate,finish_mean_s,finish_p10_s,finish_p50_s,finish_p90_s,"
+                  "no_traffic_per_episode,boost_per_episode\n");
+    for (size_t i = 0; i < sets.size(); i++)
+    {
+        const TrafficParams &t = sets[i].traffic;
+        Summary s = summarize(sets[i]);
+        fprintf(file, "%d,%.3f,%d,%d,%d,%d,%d,%.4f,%.4f,%.4f,%.2f,%.2f,%.2f,%.2f,%.3f,%.3f\n",
+                t.spawnChance, t.minSpeed, t.speedSteps, t.spawnAhead, t.spawnWindow, t.powerupChance,
+                (int)sets[i].results.size(), s.crashRate, s.finishRate, s.timeoutRate,
+                s.meanSeconds, s.p10, s.p50, s.p90, s.noTrafficPerEpisode, s.boostPerEpisode);
+    }
+    fclose(file);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Command line
+//////////////////////////////////////////////////////////////////////
+
+static void parseInts(const char *text, std::vector<int> &out)
+{
+    out.clear();
+    for (const char *p = text; *p;)
+    {
+        out.push_back(atoi(p));
+        p = strchr(p, ',');
+        if (!p)
+            break;
+        p++;
+    }
+}
+
+static void parseFloats(const char *text, std::vector<float> &out)
+{
+    out.clear();
+    for (const char *p = text; *p;)
+    {
+        out.push_back((float)atof(p));
+        p = strchr(p, ',');
+        if (!p)
+            break;
+        p++;
+    }
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [options]\n"
+           "  --episodes N          Episodes per parameter set (1000)\n"
+           "  --seed N              Base seed; episode i uses the same seed in every set (1)\n"
+           "  --workers N           Worker threads, -1 = one per core (-1)\n"
+           "  --max-ticks N         Episodes still running after N ticks time out (10000)\n"
+           "  --level FILE.lvb      Compiled road level to drive, defaults come from it (built-in)\n"
+           "  --traffic N           Traffic slots per level (10)\n"
+           "  --spawn-chance A,B    Percent per tick that a free slot spawns a car (2)\n"
+           "  --min-speed A,B       Slowest traffic speed (0.05)\n"
+           "  --spawn-ahead A,B     Spawn distance ahead of the player (100)\n"
+           "  --powerup-chance A,B  1 in N chance per tick a power-up respawns (500)\n"
+           "  --csv FILE            Also write the summary as CSV\n"
+           "Every combination of the comma separated lists is evaluated.\n",
+           name);
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    options.episodes = 1000;
+    options.seed = 1;
+    options.workers = -1;
+    options.maxTicks = 10000;
+    options.trafficSize = -1;
+    options.csvPath = NULL;
+    options.level = LevelData::defaultRoad();
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--episodes") == 0 && hasValue)
+            options.episodes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue)
+            options.seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--workers") == 0 && hasValue)
+            options.workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-ticks") == 0 && hasValue)
+            options.maxTicks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--level") == 0 && hasValue)
+        {
+            const char *path = argv[++i];
+            if (!options.level.load(path) || options.level.kind != LEVEL_ROAD)
+            {
+                fprintf(stderr, "Error: %s is not a compiled road level\n", path);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--traffic") == 0 && hasValue)
+            options.trafficSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--spawn-chance") == 0 && hasValue)
+            parseInts(argv[++i], options.spawnChance);
+        else if (strcmp(argv[i], "--min-speed") == 0 && hasValue)
+            parseFloats(argv[++i], options.minSpeed);
+        else if (strcmp(argv[i], "--spawn-ahead") == 0 && hasValue)
+            parseInts(argv[++i], options.spawnAhead);
+        else if (strcmp(argv[i], "--powerup-chance") == 0 && hasValue)
+            parseInts(argv[++i], options.powerupChance);
+        else if (strcmp(argv[i], "--csv") == 0 && hasValue)
+            options.csvPath = argv[++i];
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.episodes < 1)
+        options.episodes = 1;
+
+    // Anything not given on the command line comes from the level
+    const RoadDesc &road = options.level.road;
+    if (options.trafficSize < 0)
+        options.trafficSize = road.trafficSize;
+    if (options.spawnChance.empty())
+        options.spawnChance.push_back(road.traffic.spawnChance);
+    if (options.minSpeed.empty())
+        options.minSpeed.push_back(road.traffic.minSpeed);
+    if (options.spawnAhead.empty())
+        options.spawnAhead.push_back(road.traffic.spawnAhead);
+    if (options.powerupChance.empty())
+        options.powerupChance.push_back(road.traffic.powerupChance);
+
+    // Common random numbers: every set sees the same episode seeds, so
+    // differences between sets come from the parameters, not the luck of the draw
+    std::vector<uint64_t> seeds(options.episodes);
+    Random master(options.seed);
+    for (int i = 0; i < options.episodes; i++)
+        seeds[i] = master.split();
+
+    std::vector<ParamSet> sets;
+    for (size_t a = 0; a < options.spawnChance.size(); a++)
+        for (size_t b = 0; b < options.minSpeed.size(); b++)
+            for (size_t c = 0; c < options.spawnAhead.size(); c++)
+                for (size_t d = 0; d < options.powerupChance.size(); d++)
+                {
+                    ParamSet set;
+                    set.traffic = road.traffic;
+                    set.traffic.spawnChance = options.spawnChance[a];
+                    set.traffic.minSpeed = options.minSpeed[b];
+                    set.traffic.spawnAhead = options.spawnAhead[c];
+                    set.traffic.powerupChance = std::max(1, options.powerupChance[d]);
+                    sets.push_back(set);
+                }
+
+    JobSystem jobs(options.workers);
+    printf("Evaluating %d parameter sets x %d episodes on %d threads\n",
+           (int)sets.size(), options.episodes, jobs.getWorkerCount() + 1);
+    printf("%6s %6s %6s %6s | %7s %7s %7s | %7s %7s %7s %7s | %6s %6s\n",
+           "spawn", "speed", "ahead", "pwrup", "crash", "finish", "timeout",
+           "mean s", "p10 s", "p50 s", "p90 s", "noTrf", "boost");
+
+    double start = Platform::nowSeconds();
+    for (size_t i = 0; i < sets.size(); i++)
+    {
+        ParamSet &set = sets[i];
+        set.results.resize(options.episodes);
+        jobs.parallelFor(0, options.episodes, 4, [&](int first, int last)
+                         {
+                             for (int e = first; e < last; e++)
+                                 set.results[e] = runEpisode(set.traffic, seeds[e], options);
+                         });
+
+        Summary s = summarize(set);
+        printf("%6d %6.3f %6d %6d | %6.1f%% %6.1f%% %6.1f%% | %7.1f %7.1f %7.1f %7.1f | %6.2f %6.2f\n",
+               set.traffic.spawnChance, set.traffic.minSpeed, set.traffic.spawnAhead, set.traffic.powerupChance,
+               s.crashRate * 100.0f, s.finishRate * 100.0f, s.timeoutRate * 100.0f,
+               s.meanSeconds, s.p10, s.p50, s.p90, s.noTrafficPerEpisode, s.boostPerEpisode);
+        fflush(stdout);
+    }
+    double seconds = Platform::nowSeconds() - start;
+
+    int total = (int)sets.size() * options.episodes;
+    printf("%d episodes in %.2f s (%.0f episodes/s)\n", total, seconds, seconds > 0.0 ? total / seconds : 0.0);
+
+    if (options.csvPath)
+    {
+        writeCsv(options.csvPath, sets);
+        printf("Results written to %s\n", options.csvPath);
+    }
+    return 0;
+}